@@ -0,0 +1,153 @@
+#include "otsdaq-mu2e-tracker/FEInterfaces/ROCEmulatorHost.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+
+using namespace ots;
+
+//==========================================================================================
+ROCEmulatorHost* ROCEmulatorHost::instance(void)
+{
+	static ROCEmulatorHost host;
+	return &host;
+}
+
+//==========================================================================================
+// default: 1 ms tick, 1024 slots - one turn of the wheel is ~1 s
+ROCEmulatorHost::ROCEmulatorHost(void)
+    : stop_(false), busy_(false), tick_us_(1000), slot_(0), nextId_(0), nTimers_(0)
+{
+}
+
+//==========================================================================================
+ROCEmulatorHost::~ROCEmulatorHost(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cv_.notify_all();
+	if(thread_.joinable())
+		thread_.join();
+}
+
+//==========================================================================================
+void ROCEmulatorHost::setTick(uint32_t tick_us, uint32_t nSlots)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(not wheel_.empty())
+		return;
+
+	tick_us_ = (tick_us > 0) ? tick_us : 1;
+	wheel_.resize((nSlots > 0) ? nSlots : 1);
+}
+
+//==========================================================================================
+// rate <= 0 : the callback runs every tick
+int ROCEmulatorHost::add(callback_t callback, double rateHz)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(wheel_.empty())
+		wheel_.resize(1024);
+
+	uint64_t period = 1;
+	if(rateHz > 0)
+		period = std::max(uint64_t(1), uint64_t(std::llround(1.e6 / rateHz / tick_us_)));
+
+	int id = nextId_++;
+	schedule_(Timer{id, period, 0, std::move(callback)});
+	nTimers_++;
+
+	if(not thread_.joinable())
+		thread_ = std::thread(&ROCEmulatorHost::run_, this);
+
+	return id;
+}
+
+//==========================================================================================
+void ROCEmulatorHost::remove(int id)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	for(auto& slot : wheel_)
+	{
+		auto it = std::find_if(slot.begin(), slot.end(), [id](const Timer& t) { return t.id == id; });
+		if(it != slot.end())
+		{
+			slot.erase(it);
+			nTimers_--;
+			break;
+		}
+	}
+
+	// a copy of the callback may still be running - not waited for when a
+	//	callback removes a timer itself
+	if(std::this_thread::get_id() != thread_.get_id())
+		idle_.wait(lock, [this] { return not busy_; });
+}
+
+//==========================================================================================
+// called with the mutex held
+void ROCEmulatorHost::schedule_(Timer&& timer)
+{
+	size_t n     = wheel_.size();
+	timer.rounds = (timer.period - 1) / n;
+	wheel_[(slot_ + timer.period) % n].push_back(std::move(timer));
+}
+
+//==========================================================================================
+// a late tick is not skipped: the wheel catches up, so the average rates hold.
+//	The due timers are rescheduled first and their callbacks run on copies,
+//	with the mutex released
+void ROCEmulatorHost::run_(void)
+{
+	auto next = std::chrono::steady_clock::now();
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	while(not stop_)
+	{
+		next += std::chrono::microseconds(tick_us_);
+		cv_.wait_until(lock, next, [this] { return stop_; });
+		if(stop_)
+			break;
+
+		slot_ = (slot_ + 1) % wheel_.size();
+
+		std::list<Timer> due;
+		std::list<Timer>& slot = wheel_[slot_];
+		for(auto it = slot.begin(); it != slot.end();)
+		{
+			if(it->rounds > 0)
+			{
+				it->rounds--;
+				++it;
+			}
+			else
+			{
+				auto next_it = std::next(it);
+				due.splice(due.end(), slot, it);
+				it = next_it;
+			}
+		}
+
+		if(due.empty())
+			continue;
+
+		std::vector<callback_t> callbacks;
+		callbacks.reserve(due.size());
+		for(auto& timer : due)
+		{
+			callbacks.push_back(timer.callback);
+			schedule_(std::move(timer));
+		}
+
+		busy_ = true;
+		lock.unlock();
+		for(auto& callback : callbacks)
+			callback();
+		lock.lock();
+		busy_ = false;
+		idle_.notify_all();
+	}
+}
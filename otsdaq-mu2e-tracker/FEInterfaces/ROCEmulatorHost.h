@@ -0,0 +1,73 @@
+#ifndef _ots_ROCEmulatorHost_h_
+#define _ots_ROCEmulatorHost_h_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ots
+{
+// ROCEmulatorHost
+//	one thread per process driving the update of all emulated ROCs.
+//	Each emulated ROC registers a callback and an update rate; the callbacks
+//	sit on a hashed timer wheel (tick x number of slots), so the thread sleeps
+//	between ticks and the cost per tick does not depend on the number of ROCs.
+//	The due callbacks are copied out and run with the host mutex released, so
+//	add()/remove() from other ROCs don't wait for them; remove() returns only
+//	when no callback is running, so a ROC can unregister from its destructor.
+class ROCEmulatorHost
+{
+	// clang-format off
+  public:
+	typedef std::function<void(void)> callback_t;
+
+	static ROCEmulatorHost* 	instance		(void);
+
+								// returns the timer ID
+	int 						add				(callback_t callback, double rateHz);
+	void 						remove			(int id);
+
+								// first call wins, the wheel is built when the first timer is added
+	void 						setTick			(uint32_t tick_us, uint32_t nSlots);
+
+	size_t 						nTimers			(void) const { return nTimers_; }
+
+	~ROCEmulatorHost(void);
+
+  private:
+	ROCEmulatorHost(void);
+
+	struct Timer
+	{
+		int      	id;
+		uint64_t 	period;  // ticks
+		uint64_t 	rounds;  // full turns of the wheel left before firing
+		callback_t 	callback;
+	};
+
+	void 						schedule_		(Timer&& timer);
+	void 						run_			(void);
+
+	std::mutex              	mutex_;
+	std::condition_variable 	cv_;
+	std::condition_variable 	idle_;  // callbacks done
+	std::thread             	thread_;
+	bool                    	stop_;
+	bool                    	busy_;  // callbacks running, mutex released
+
+	uint32_t                	tick_us_;
+	std::vector<std::list<Timer>> wheel_;
+	size_t                  	slot_;
+	int                     	nextId_;
+	std::atomic<size_t>     	nTimers_;
+	// clang-format on
+};
+
+}  // namespace ots
+
+#endif
@@ -1,14 +1,27 @@
 #ifndef _ots_ROCTrackerInterface_h_
 #define _ots_ROCTrackerInterface_h_
 
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <random>
 #include <string>
+#include <vector>
 
+#include "otsdaq-mu2e-tracker/Utilities/TrackerDcsCoalescer.hh"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerDcsHistory.hh"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerRegisterCache.hh"
 #include "otsdaq-mu2e/FEInterfaces/ROCPolarFireCoreInterface.h"
 #include "otsdaq/DataManager/DataProducer.h"
 #include "otsdaq/FECore/FEProducerVInterface.h"
 
+namespace mu2e
+{
+class TrackerStatus;
+}
+
 namespace ots
 {
 class ROCTrackerInterface : public ROCPolarFireCoreInterface
@@ -29,6 +42,9 @@ public:
   	bool 									running					(void) override;
 
   	// write and read to registers
+  	virtual void 							writeROCRegister		(uint16_t address, uint16_t data_to_write) override;
+  	virtual uint16_t						readROCRegister			(uint16_t address) override;
+  	virtual void							readROCBlock			(std::vector<uint16_t>& data, uint16_t address, uint16_t wordCount, bool incrementAddress) override;
   	virtual void 							writeEmulatorRegister	(uint16_t address, uint16_t data_to_write) override;
   	virtual uint16_t						readEmulatorRegister	(uint16_t address) override;
   	virtual void							readEmulatorBlock	(std::vector<uint16_t>& data, uint16_t address, uint16_t wordCount, bool incrementAddress) override;
@@ -39,18 +55,23 @@ public:
 
 	enum {
 		ADDRESS_FIRMWARE_VERSION = 5,
+		ADDRESS_LINK_RESET = 14,
 		ADDRESS_MYREGISTER = 0x65,
   	};
 
-  	//	temperature--
+  	//	temperature-- updated by the emulator host thread, read by the FE thread.
+  	//	The noise comes from its own generator, rand() is shared by all the ROCs
   	class Thermometer {
   		private:
-    		double mnoiseTemp;
+    		std::atomic<double>                    mnoiseTemp;
+    		std::mt19937                           mrng;
+    		std::uniform_real_distribution<double> muniform{0., 1.};
 
   		public:
+    		void seed(unsigned s) { mrng.seed(s); }
     		void noiseTemp(double intemp) {
       			mnoiseTemp = (double)intemp +
-                   0.5 * (intemp * ((double)rand() / (RAND_MAX)) - 0.5);
+                   0.5 * (intemp * muniform(mrng) - 0.5);
       			return;
     		}
     		double GetBoardTempC() { return mnoiseTemp; }
@@ -58,6 +79,11 @@ public:
 
   	Thermometer temp1_;
   	double inputTemp_;
+  	double emulatorUpdateRateHz_;
+  	int    emulatorTimerId_;  // -1: not registered with ROCEmulatorHost
+
+  	std::mt19937                           emulatorRng_;      // bogus block data, one per ROC
+  	std::uniform_real_distribution<double> emulatorUniform_;
 
 	private:
 		unsigned int TrackerParameter_1_;
@@ -69,8 +95,26 @@ public:
 		std::ofstream datafile_;
 		unsigned int event_number_;
 
+		std::shared_ptr<mu2e::TrackerStatus> status_;       // shared by the ROCs of the process, null unless statusExportSegment is set
+		int                                  statusBlock_;
+
+		mu2e::TrackerRegisterCache registerCache_;  // static and config registers, the rest read through
+
+		bool                                       dcsCoalescing_;
+		int                                        dcsMaxBlockWords_;
+		std::vector<uint16_t>                      dcsFifoRegisters_;  // never coalesced
+		std::shared_ptr<mu2e::TrackerDcsCoalescer> dcs_;               // shared by the ROCs of the DTC, null if disabled
+
+		mu2e::TrackerDcsHistory*                   dcsHistory_;        // null if disabled
+		std::vector<uint16_t>                      dcsHistoryRegisters_;
+		int                                        dcsHistoryIntervalMs_;
+		std::chrono::steady_clock::time_point      dcsHistoryLast_;
+
+		void                                       sampleHistory_(unsigned FIFOdepth);
+
   public:
 	void ReadTrackerFIFO(__ARGS__);
+	void ReadDcsHistory(__ARGS__);
 
 	// clang-format on
 };
@@ -1,10 +1,23 @@
 #include "otsdaq-mu2e-tracker/FEInterfaces/ROCTrackerInterface.h"
+#include "otsdaq-mu2e-tracker/FEInterfaces/ROCEmulatorHost.h"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerLog.hh"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerStatus.hh"
 #include "otsdaq/DataManager/DataProducer.h"
 #include "otsdaq/DataManager/RawDataSaverConsumerBase.h"
 
 #include "otsdaq/Macros/InterfacePluginMacros.h"
 
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
 using namespace ots;
+using mu2e::TrackerDcsCoalescer;
+using mu2e::TrackerDcsHistory;
+using mu2e::TrackerLog;
+using mu2e::TrackerRegisterCache;
+using mu2e::TrackerStatus;
 
 
 #undef __MF_SUBJECT__
@@ -16,6 +29,14 @@ ROCTrackerInterface::ROCTrackerInterface(
     const ConfigurationTree& theXDAQContextConfigTree,
     const std::string&       theConfigurationPath)
     : ROCPolarFireCoreInterface(rocUID, theXDAQContextConfigTree, theConfigurationPath)
+    , emulatorTimerId_(-1)
+    , emulatorRng_(linkID_)
+    , emulatorUniform_(0., 1.)
+    , statusBlock_(-1)
+    , dcsCoalescing_(false)
+    , dcsMaxBlockWords_(16)
+    , dcsHistory_(nullptr)
+    , dcsHistoryIntervalMs_(1000)
 {
 	INIT_MF("." /*directory used is USER_DATA/LOG/.*/);
 
@@ -34,6 +55,22 @@ ROCTrackerInterface::ROCTrackerInterface(
 	__FE_COUTV__(TrackerParameter_1_);
 	__FE_COUTV__(TrackerParameter_2_);
 
+	// per-read/per-event messages go through TRK_LOG, written by the TrackerLog thread
+	// installed by the first ROC of the process, stderr again after the last one
+	TrackerLog::instance()->acquireSink([](int level, const char* text) {
+		if(level <= TrackerLog::kWarning)
+			__COUT_WARN__ << text << __E__;
+		else
+			__COUT__ << text << __E__;
+	});
+
+	// the level is process-wide, kInfo unless a ROC configuration raises it
+	try {
+	  TrackerLog::setLevel(getSelfNode().getNode("trackerLogLevel").getValue<int>());
+	} catch (...) {
+	  __CFG_COUT__ << "trackerLogLevel field not defined. Keeping the TrackerLog level" << __E__;
+	}
+
 	registerFEMacroFunction(
 	    "ReadROCTrackerFIFO",
 	    static_cast<FEVInterface::frontEndMacroFunction_t>(
@@ -42,6 +79,14 @@ ROCTrackerInterface::ROCTrackerInterface(
 	    std::vector<std::string>{},                           // output parameters
 	    1);                                                   // requiredUserPermissions
 
+	registerFEMacroFunction(
+	    "ReadDcsHistory",
+	    static_cast<FEVInterface::frontEndMacroFunction_t>(
+	        &ROCTrackerInterface::ReadDcsHistory),
+	    std::vector<std::string>{"Channel", "StartTime", "EndTime"},  // inputs parameters
+	    std::vector<std::string>{"Samples"},                          // output parameters
+	    1);                                                           // requiredUserPermissions
+
 	 try {
 	  inputTemp_ = getSelfNode().getNode("inputTemperature").getValue<double>();
 	} catch (...) {
@@ -50,15 +95,155 @@ ROCTrackerInterface::ROCTrackerInterface(
 	  inputTemp_ = 15.;
 	}
 
+	try {
+	  emulatorUpdateRateHz_ = getSelfNode().getNode("emulatorUpdateRateHz").getValue<double>();
+	} catch (...) {
+	  __CFG_COUT__ << "emulatorUpdateRateHz field not defined. Defaulting..."
+	               << __E__;
+	  emulatorUpdateRateHz_ = 10.;
+	}
+
+	// the emulator host is shared by all ROCs of the process: the first ROC
+	//	configured sets its tick and wheel size (default 1 ms x 1024 slots)
+	uint32_t emulatorTickUs = 1000, emulatorWheelSlots = 1024;
+	try {
+	  emulatorTickUs = getSelfNode().getNode("emulatorTickUs").getValue<uint32_t>();
+	} catch (...) {
+	  __CFG_COUT__ << "emulatorTickUs field not defined. Defaulting to "
+	               << emulatorTickUs << __E__;
+	}
+
+	try {
+	  emulatorWheelSlots = getSelfNode().getNode("emulatorWheelSlots").getValue<uint32_t>();
+	} catch (...) {
+	  __CFG_COUT__ << "emulatorWheelSlots field not defined. Defaulting to "
+	               << emulatorWheelSlots << __E__;
+	}
+	ROCEmulatorHost::instance()->setTick(emulatorTickUs, emulatorWheelSlots);
+
+	// latest FIFO depth, event counters and temperature in shared memory, read
+	//	by GUIs and scripts (trkStatus) without DCS transactions
+	std::string statusSegment;
+	try {
+	  statusSegment = getSelfNode().getNode("statusExportSegment").getValue<std::string>();
+	} catch (...) {
+	  __CFG_COUT__ << "statusExportSegment field not defined. Status export disabled."
+	               << __E__;
+	}
+
+	if(statusSegment != "" && statusSegment != "DEFAULT")
+	{
+		// one segment for all the ROCs of the front end, a block for each
+		status_ = TrackerStatus::shared(statusSegment);
+		if(status_)
+			statusBlock_ = status_->block("roc." + rocUID, TrackerStatus::kValues,
+			                              "event_number,fifo_depth,empty_events,board_temp_C,register_cache_hit_rate");
+		else
+			__COUT_WARN__ << "can't create status segment " << statusSegment << __E__;
+	}
+
+	// registers which don't change on their own are served from memory, not
+	//	with a DCS round trip: comma-separated addresses, decimal or 0x...
+	std::string shadowRegisters[2] = {"0,5", "8,18"};  // ID 0x1234 and firmware version; config
+	const char* shadowField[2]     = {"shadowStaticRegisters", "shadowConfigRegisters"};
+	for(int i = 0; i < 2; i++)
+	{
+		try {
+		  shadowRegisters[i] = getSelfNode().getNode(shadowField[i]).getValue<std::string>();
+		} catch (...) {
+		  __CFG_COUT__ << shadowField[i] << " field not defined. Defaulting to "
+		               << shadowRegisters[i] << __E__;
+		}
+
+		std::istringstream list(shadowRegisters[i]);
+		std::string        address;
+		while(std::getline(list, address, ','))
+		{
+			if(address.find_first_not_of(" \t") == std::string::npos)
+				continue;
+			registerCache_.setClass(std::stoul(address, nullptr, 0),
+			                        i == 0 ? TrackerRegisterCache::kStatic : TrackerRegisterCache::kConfig);
+		}
+	}
+
+	 temp1_.seed(linkID_);
+
+	// DCS requests of all the ROCs of the DTC through one queue, registered in
+	//	configure(): duplicate reads answered once, adjacent ones read as a block.
+	//	The FIFO registers (comma-separated) are always read on their own
+	try {
+	  dcsCoalescing_ = getSelfNode().getNode("dcsCoalescing").getValue<bool>();
+	} catch (...) {
+	  __CFG_COUT__ << "dcsCoalescing field not defined. Defaulting to false."
+	               << __E__;
+	}
+
+	try {
+	  dcsMaxBlockWords_ = getSelfNode().getNode("dcsMaxBlockWords").getValue<int>();
+	} catch (...) {
+	  __CFG_COUT__ << "dcsMaxBlockWords field not defined. Defaulting to "
+	               << dcsMaxBlockWords_ << __E__;
+	}
+
+	std::string fifoRegisters = "42";
+	try {
+	  fifoRegisters = getSelfNode().getNode("dcsFifoRegisters").getValue<std::string>();
+	} catch (...) {
+	  __CFG_COUT__ << "dcsFifoRegisters field not defined. Defaulting to "
+	               << fifoRegisters << __E__;
+	}
+
+	std::istringstream fifoList(fifoRegisters);
+	std::string        fifoAddress;
+	while(std::getline(fifoList, fifoAddress, ','))
+	{
+		if(fifoAddress.find_first_not_of(" \t") != std::string::npos)
+			dcsFifoRegisters_.push_back(std::stoul(fifoAddress, nullptr, 0));
+	}
+
+	// DCS values sampled while running, kept in memory (one compressed ring per
+	//	channel) and fetched a time range at a time with ReadDcsHistory:
+	//	dcsHistoryDepth samples per channel (0: no history), one sample every
+	//	dcsHistoryIntervalMs of the FIFO depth, empty events, board temperature
+	//	and of the ROC registers in dcsHistoryRegisters (comma-separated)
+	unsigned int historyDepth = 0;
+	try {
+	  historyDepth = getSelfNode().getNode("dcsHistoryDepth").getValue<unsigned int>();
+	} catch (...) {
+	  __CFG_COUT__ << "dcsHistoryDepth field not defined. DCS history disabled."
+	               << __E__;
+	}
+
+	try {
+	  dcsHistoryIntervalMs_ = getSelfNode().getNode("dcsHistoryIntervalMs").getValue<int>();
+	} catch (...) {
+	  __CFG_COUT__ << "dcsHistoryIntervalMs field not defined. Defaulting to "
+	               << dcsHistoryIntervalMs_ << __E__;
+	}
+
+	std::string historyRegisters;
+	try {
+	  historyRegisters = getSelfNode().getNode("dcsHistoryRegisters").getValue<std::string>();
+	} catch (...) {
+	  __CFG_COUT__ << "dcsHistoryRegisters field not defined. No registers sampled."
+	               << __E__;
+	}
+
+	std::istringstream historyList(historyRegisters);
+	std::string        historyAddress;
+	while(std::getline(historyList, historyAddress, ','))
+	{
+		if(historyAddress.find_first_not_of(" \t") != std::string::npos && historyAddress != "DEFAULT")
+			dcsHistoryRegisters_.push_back(std::stoul(historyAddress, nullptr, 0));
+	}
+
+	if(historyDepth > 0)
+		dcsHistory_ = new TrackerDcsHistory(historyDepth);
+
 	 temp1_.noiseTemp(inputTemp_);
 }
 void ROCTrackerInterface::ReadTrackerFIFO(__ARGS__)
 {
-	__FE_COUT__ << "# of input args = " << argsIn.size() << __E__;
-	__FE_COUT__ << "# of output args = " << argsOut.size() << __E__;
-	for(auto& argIn : argsIn)
-		__FE_COUT__ << argIn.first << ": " << argIn.second << __E__;
-
 	// macro commands section
 
 	__FE_COUT__ << "# of input args = " << argsIn.size() << __E__;
@@ -81,7 +266,7 @@ void ROCTrackerInterface::ReadTrackerFIFO(__ARGS__)
 		while(FIFOdepth <= 0 && counter < 1000)
 		{
 			if(counter % 100 == 0)
-				__FE_COUT__ << "... waiting for non-zero depth" << __E__;
+				TRK_LOG(TrackerLog::kDebug, "... waiting for non-zero depth");
 			FIFOdepth = readRegister(0x35);
 			counter++;
 		}
@@ -93,20 +278,117 @@ void ROCTrackerInterface::ReadTrackerFIFO(__ARGS__)
 		__FE_COUT__ << argOut.first << ": " << argOut.second << __E__;
 }
 
+//==========================================================================================
+//	the samples of Channel with StartTime <= time <= EndTime (seconds since the
+//	epoch, empty or 0: no limit), one "time value" line each. Without a channel,
+//	one "channel samples" line per channel
+void ROCTrackerInterface::ReadDcsHistory(__ARGS__)
+{
+	if(!dcsHistory_)
+	{
+		__SET_ARG_OUT__("Samples", "DCS history disabled, set dcsHistoryDepth");
+		return;
+	}
+
+	std::string channel = __GET_ARG_IN__("Channel", std::string);
+	std::string start   = __GET_ARG_IN__("StartTime", std::string);
+	std::string end     = __GET_ARG_IN__("EndTime", std::string);
+
+	__FE_COUTV__(channel);
+
+	auto toTime = [](std::string const& seconds, int64_t none) {
+		double t = (seconds == "DEFAULT") ? 0 : strtod(seconds.c_str(), nullptr);
+		return (t > 0) ? int64_t(t * 1e6) : none;
+	};
+
+	std::ostringstream out;
+	char               line[64];
+
+	if(channel == "" || channel == "DEFAULT")
+	{
+		for(auto const& name : dcsHistory_->channels())
+			out << name << " " << dcsHistory_->nSamples(name) << "\n";
+	}
+	else
+	{
+		std::vector<TrackerDcsHistory::Sample> samples;
+		dcsHistory_->query(channel, toTime(start, INT64_MIN), toTime(end, INT64_MAX), samples);
+
+		for(auto const& sample : samples)
+		{
+			snprintf(line, sizeof(line), "%lld.%06lld %.10g\n", (long long)(sample.time / 1000000),
+			         (long long)(sample.time % 1000000), sample.value);
+			out << line;
+		}
+		__FE_COUT__ << samples.size() << " samples of " << channel << __E__;
+	}
+
+	__SET_ARG_OUT__("Samples", out.str());
+}
+
 //==========================================================================================
 ROCTrackerInterface::~ROCTrackerInterface(void)
 {
 	// NOTE:: be careful not to call __FE_COUT__ decoration because it uses the
 	// tree and it may already be destructed partially
 	__COUT__ << FEVInterface::interfaceUID_ << " Destructor" << __E__;
+
+	TrackerLog::instance()->releaseSink();
+
+	// the queue outlives this ROC if other ROCs of the DTC still use it
+	if(dcs_)
+		dcs_->removeLink(linkID_);
+
+	if(emulatorTimerId_ >= 0)
+		ROCEmulatorHost::instance()->remove(emulatorTimerId_);
+
+	delete dcsHistory_;
 }
 
+//==================================================================================================
+//	the cache is bypassed for the volatile registers, see TrackerRegisterCache
+uint16_t ROCTrackerInterface::readROCRegister(uint16_t address)
+{
+	return registerCache_.read(address, [&] {
+		return dcs_ ? dcs_->read(linkID_, address).get() : ROCPolarFireCoreInterface::readROCRegister(address);
+	});
+}  // end readROCRegister()
+
+//==================================================================================================
+void ROCTrackerInterface::readROCBlock(std::vector<uint16_t>& data,
+                                       uint16_t               address,
+                                       uint16_t               wordCount,
+                                       bool                   incrementAddress)
+{
+	if(not dcs_)
+		return ROCPolarFireCoreInterface::readROCBlock(data, address, wordCount, incrementAddress);
+
+	std::vector<uint16_t> block = dcs_->readBlock(linkID_, address, wordCount, incrementAddress).get();
+	data.insert(data.end(), block.begin(), block.end());
+}  // end readROCBlock()
+
+//==================================================================================================
+void ROCTrackerInterface::writeROCRegister(uint16_t address, uint16_t data_to_write)
+{
+	if(dcs_)
+		dcs_->write(linkID_, address, data_to_write).get();
+	else
+		ROCPolarFireCoreInterface::writeROCRegister(address, data_to_write);
+
+	// a link reset puts the ROC back to its defaults
+	if(address == ADDRESS_LINK_RESET)
+		registerCache_.invalidate();
+	else
+		registerCache_.written(address);
+}  // end writeROCRegister()
+
 //==================================================================================================
 void ROCTrackerInterface::writeEmulatorRegister(uint16_t address, uint16_t data_to_write)
 {
-	__FE_COUT__ << "Calling Tracker write ROC Emulator register: link number " << std::dec
-	            << linkID_ << ", address = " << address
-	            << ", write data = " << data_to_write << __E__;
+	TRK_LOG(TrackerLog::kDebug,
+	        "Calling Tracker write ROC Emulator register: link number "
+	            << std::dec << linkID_ << ", address = " << address
+	            << ", write data = " << data_to_write);
 
 	return;
 
@@ -115,7 +397,7 @@ void ROCTrackerInterface::writeEmulatorRegister(uint16_t address, uint16_t data_
 //==================================================================================================
 uint16_t ROCTrackerInterface::readEmulatorRegister(uint16_t address)
 {
-	__CFG_COUT__ << "Tracker emulator read" << __E__;
+	TRK_LOG(TrackerLog::kTrace, "Tracker emulator read, address = " << address);
 
         if(address == 6 || address == 7)
 		return ROCPolarFireCoreInterface::readEmulatorRegister(address);	
@@ -134,14 +416,14 @@ void ROCTrackerInterface::readEmulatorBlock(std::vector<uint16_t>& 	data,
 						uint16_t		wordCount,
 						bool			incrementAddress)
 {
-	__CFG_COUT__ << "Tracker emulator block read " << "wordCount= "<<wordCount<< __E__;
+	TRK_LOG(TrackerLog::kDebug, "Tracker emulator block read " << "wordCount= " << wordCount);
 
 // make up some bogus data. Right now hardwired, could be read in as a parameter...
     double input_data = 15;  
 
 	for(unsigned int i=0;i<wordCount;++i) {
-          	double rand_data = input_data + 0.5 * (input_data * (((double)rand() / (RAND_MAX)) - 0.5));
-	  	__CFG_COUT__ << "rand_data= "<<rand_data<< __E__;
+          	double rand_data = input_data + 0.5 * (input_data * (emulatorUniform_(emulatorRng_) - 0.5));
+	  	TRK_LOG(TrackerLog::kTrace, "rand_data= " << rand_data);
 		data.push_back(rand_data);
 //		data.push_back(address + (incrementAddress?i:0));
 }		
@@ -154,8 +436,29 @@ void ROCTrackerInterface::configure(void) try
 	__CFG_COUT__
 	    << "Tracker configure, first configure back-end communication with DTC... "
 	    << __E__;
+	registerCache_.invalidate();
 	ROCPolarFireCoreInterface::configure();
 
+	// the transactions themselves are the ones of ROCPolarFireCoreInterface,
+	//	run on the thread of the DTC queue
+	if(dcsCoalescing_ && !dcs_)
+	{
+		dcs_ = TrackerDcsCoalescer::get(thisDTC_);
+		dcs_->setMaxBlock(dcsMaxBlockWords_);
+		for(uint16_t address : dcsFifoRegisters_)
+			dcs_->setNoCoalesce(address);
+
+		dcs_->addLink(
+		    linkID_,
+		    [this](uint16_t address) { return ROCPolarFireCoreInterface::readROCRegister(address); },
+		    [this](std::vector<uint16_t>& data, uint16_t address, uint16_t wordCount, bool incrementAddress) {
+			    ROCPolarFireCoreInterface::readROCBlock(data, address, wordCount, incrementAddress);
+		    },
+		    [this](uint16_t address, uint16_t data) { ROCPolarFireCoreInterface::writeROCRegister(address, data); });
+
+		__CFG_COUT__ << "DCS requests of link " << linkID_ << " go through the DTC queue" << __E__;
+	}
+
 	//__MCOUT_INFO__("Tracker configure, next configure front-end... " << __E__);
 	//__MCOUT_INFO__("..... write parameter 1 = " << TrackerParameter_1_ << __E__);
 	//__MCOUT_INFO__("..... followed by parameter 2 = " << TrackerParameter_2_ << __E__);
@@ -223,8 +526,7 @@ bool ROCTrackerInterface::running(void)
 	unsigned FIFOdepth = 0;
 	FIFOdepth          = readRegister(35);
 
-	std::cout << "TRK FIFOdepth " << FIFOdepth << " Event number " << event_number_
-	          << std::endl;
+	TRK_LOG(TrackerLog::kDebug, "TRK FIFOdepth " << FIFOdepth << " Event number " << event_number_);
 
 	unsigned counter = 0;  // don't wait forever
 
@@ -233,7 +535,7 @@ bool ROCTrackerInterface::running(void)
 		readRegister(6);
 		if(counter % 100 == 0)
 		{
-			__FE_COUT__ << "... waiting for non-zero depth" << __E__;
+			TRK_LOG(TrackerLog::kDebug, "... waiting for non-zero depth");
 		}
 		FIFOdepth = readRegister(35);
 		counter++;
@@ -271,6 +573,19 @@ bool ROCTrackerInterface::running(void)
 		number_of_empty_events_++;
 	}
 
+	if(status_)
+	{
+		double values[] = {double(event_number_),
+		                   double(FIFOdepth),
+		                   double(number_of_empty_events_),
+		                   temp1_.GetBoardTempC(),
+		                   registerCache_.hitRate()};
+		status_->publishValues(statusBlock_, values, sizeof(values) / sizeof(double));
+	}
+
+	if(dcsHistory_)
+		sampleHistory_(FIFOdepth);
+
 	if(0)
 	{
 		unsigned data_to_check = readRegister(0x6);
@@ -300,6 +615,15 @@ void ROCTrackerInterface::stop()  // runNumber)
 	__MCOUT__("--> number of good events = " << number_of_good_events_ << __E__);
 	__MCOUT__("--> number of bad events = " << number_of_bad_events_ << __E__);
 	__MCOUT__("--> number of empty events = " << number_of_empty_events_ << __E__);
+	__MCOUT__("--> register cache hit rate = " << registerCache_.hitRate() << " ("
+	                                           << registerCache_.nHits() << " DCS reads saved)" << __E__);
+	if(dcs_)
+		__MCOUT__("--> DTC DCS queue: " << dcs_->nRequests() << " requests in " << dcs_->nTransactions()
+		                                << " transactions, " << dcs_->nCoalesced() << " reads coalesced, "
+		                                << dcs_->nBatched() << " in block reads" << __E__);
+	if(dcsHistory_)
+		__MCOUT__("--> DCS history: " << dcsHistory_->channels().size() << " channels in "
+		                              << dcsHistory_->bytes() << " bytes" << __E__);
 	// int startIndex = getIterationIndex();
 
 	// indicateIterationWork();  // I still need to be touched
@@ -314,14 +638,42 @@ void ROCTrackerInterface::stop()  // runNumber)
 	return;
 }
 
+//==================================================================================================
+//	at most once per dcsHistoryIntervalMs, the same time for all the channels
+void ROCTrackerInterface::sampleHistory_(unsigned FIFOdepth)
+{
+	auto now = std::chrono::steady_clock::now();
+	if(now - dcsHistoryLast_ < std::chrono::milliseconds(dcsHistoryIntervalMs_))
+		return;
+	dcsHistoryLast_ = now;
+
+	int64_t time = TrackerDcsHistory::now();
+	dcsHistory_->add("fifo_depth", time, FIFOdepth);
+	dcsHistory_->add("empty_events", time, number_of_empty_events_);
+	dcsHistory_->add("board_temp_C", time, temp1_.GetBoardTempC());
+	for(uint16_t address : dcsHistoryRegisters_)
+		dcsHistory_->add("register_" + std::to_string(address), time, readRegister(address));
+}
+
 //==================================================================================================
 // return false to stop workloop thread
+//	the emulated ROC is updated by the ROCEmulatorHost thread shared by all ROCs
+//	of the process, at emulatorUpdateRateHz, so the workloop only registers it
 bool ROCTrackerInterface::emulatorWorkLoop(void)
 {
 	//__CFG_COUT__ << "emulator working..." << __E__;
 
-	temp1_.noiseTemp(inputTemp_);
-	return true;  // true to keep workloop going
+	if(emulatorTimerId_ < 0)
+	{
+		emulatorTimerId_ = ROCEmulatorHost::instance()->add(
+		    [this] { temp1_.noiseTemp(inputTemp_); }, emulatorUpdateRateHz_);
+
+		__CFG_COUT__ << "emulator registered with the host at " << emulatorUpdateRateHz_
+		             << " Hz, " << ROCEmulatorHost::instance()->nTimers()
+		             << " emulated ROC(s)" << __E__;
+	}
+
+	return false;  // true to keep workloop going
 
 	//	float input, inputTemp;
 	//	int addBoard, a;
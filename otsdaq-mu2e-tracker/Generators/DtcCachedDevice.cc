@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// DtcDevice with a shadow register cache, see DtcCachedDevice.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_DtcCachedDevice").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/DtcCachedDevice.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <algorithm>
+
+using namespace DTCLib;
+
+namespace {
+  const int kNLinks = 6;
+}
+
+//-----------------------------------------------------------------------------
+mu2e::DtcCachedDevice::DtcCachedDevice(DtcDevice* Device, fhicl::ParameterSet const& ps) :
+    _device  (Device)
+  , _rocReset(ps.get<std::vector<uint16_t>>("roc_reset", {14})) {
+
+  std::vector<uint16_t> rocStatic = ps.get<std::vector<uint16_t>>("roc_static", {0, 5});
+  std::vector<uint16_t> rocConfig = ps.get<std::vector<uint16_t>>("roc_config", {8, 18});
+
+  for (int link=0; link<kNLinks; link++) {
+    for (uint16_t a : rocStatic) _rocCache.setClass(rocKey_(DTC_Link_ID(link), a), TrackerRegisterCache::kStatic);
+    for (uint16_t a : rocConfig) _rocCache.setClass(rocKey_(DTC_Link_ID(link), a), TrackerRegisterCache::kConfig);
+  }
+
+  _dtcCache.setClass(ps.get<std::vector<uint32_t>>("dtc_static", {0x9000, 0x9004})        , TrackerRegisterCache::kStatic);
+  _dtcCache.setClass(ps.get<std::vector<uint32_t>>("dtc_config", {0x9104, 0x9144, 0x91a8}), TrackerRegisterCache::kConfig);
+
+  TLOG(TLVL_INFO) << "register cache: " << rocStatic.size() << " static and " << rocConfig.size()
+                  << " config ROC registers per link";
+}
+
+//-----------------------------------------------------------------------------
+mu2e::DtcCachedDevice::~DtcCachedDevice() {
+  TLOG(TLVL_INFO) << "register cache hit rate: ROC " << _rocCache.hitRate() << " DTC " << _dtcCache.hitRate();
+  delete _device;
+}
+
+//-----------------------------------------------------------------------------
+roc_data_t mu2e::DtcCachedDevice::ReadROCRegister(DTC_Link_ID const& link, roc_address_t address, int tmo_ms) {
+  return _rocCache.read(rocKey_(link, address),
+                        [&] { return _device->ReadROCRegister(link, address, tmo_ms); });
+}
+
+//-----------------------------------------------------------------------------
+bool mu2e::DtcCachedDevice::WriteROCRegister(DTC_Link_ID const& link, roc_address_t address, roc_data_t data,
+                                             bool requestAck, int tmo_ms) {
+  bool ok = _device->WriteROCRegister(link, address, data, requestAck, tmo_ms);
+
+  if (std::find(_rocReset.begin(), _rocReset.end(), address) != _rocReset.end()) {
+    _rocCache.invalidate(rocKey_(link, 0), rocKey_(link, 0xffff));
+  }
+  else {
+    _rocCache.written(rocKey_(link, address));
+  }
+
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t mu2e::DtcCachedDevice::ReadRegister(DTC_Register const& address) {
+  return _dtcCache.read(address, [&] { return _device->ReadRegister(address); });
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::DtcCachedDevice::WriteRegister(uint32_t data, DTC_Register const& address) {
+  _device->WriteRegister(data, address);
+  _dtcCache.written(address);
+}
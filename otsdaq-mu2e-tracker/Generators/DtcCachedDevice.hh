@@ -0,0 +1,77 @@
+#ifndef otsdaq_mu2e_tracker_Generators_DtcCachedDevice_hh
+#define otsdaq_mu2e_tracker_Generators_DtcCachedDevice_hh
+//-----------------------------------------------------------------------------
+// DtcCachedDevice : DtcDevice in front of another one, DTC and ROC register
+// reads go through a TrackerRegisterCache. Everything else is forwarded.
+// Owns the device behind it
+//
+// - ROC keys: link << 16 | address
+// - a write to one of the roc_reset registers resets the ROC: all registers
+//   of its link are read again
+//
+// register_cache : {
+//   enabled    : false
+//   roc_static : [ 0, 5 ]                  # design ID (0x1234), firmware version
+//   roc_config : [ 8, 18 ]
+//   roc_reset  : [ 14 ]
+//   dtc_static : [ 0x9000, 0x9004 ]        # design version and date
+//   dtc_config : [ 0x9104, 0x9144, 0x91a8 ]
+// }
+//-----------------------------------------------------------------------------
+#include "otsdaq-mu2e-tracker/Generators/DtcDevice.hh"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerRegisterCache.hh"
+
+#include "fhiclcpp/fwd.h"
+
+#include <vector>
+
+namespace mu2e {
+  class DtcCachedDevice : public DtcDevice {
+  public:
+    DtcCachedDevice(DtcDevice* Device, fhicl::ParameterSet const& ps);
+    ~DtcCachedDevice() override;
+
+    int    read_data      (DTCLib::DTC_DMA_Engine const& chn, void** buffer, int tmo_ms) override {
+      return _device->read_data(chn, buffer, tmo_ms);
+    }
+    int    read_release   (DTCLib::DTC_DMA_Engine const& chn, unsigned num) override {
+      return _device->read_release(chn, num);
+    }
+    int    release_all    (DTCLib::DTC_DMA_Engine const& chn) override { return _device->release_all(chn); }
+    void   ResetDeviceTime() override { _device->ResetDeviceTime(); }
+    double GetDeviceTime  () override { return _device->GetDeviceTime(); }
+
+    DTCLib::roc_data_t ReadROCRegister (DTCLib::DTC_Link_ID const& link, DTCLib::roc_address_t address, int tmo_ms) override;
+
+    bool WriteROCRegister(DTCLib::DTC_Link_ID const& link, DTCLib::roc_address_t address, DTCLib::roc_data_t data,
+                          bool requestAck, int tmo_ms) override;
+
+    uint32_t ReadRegister (DTCLib::DTC_Register const& address)                override;
+    void     WriteRegister(uint32_t data, DTCLib::DTC_Register const& address) override;
+
+    void SendRequestForTimestamp(DTCLib::DTC_EventWindowTag const& tag, uint32_t heartbeatsAfter) override {
+      _device->SendRequestForTimestamp(tag, heartbeatsAfter);
+    }
+
+    void SendRequestsForRange(int count, DTCLib::DTC_EventWindowTag const& start, bool increment,
+                              uint32_t delayBetweenRequests, int requestsAhead, uint32_t heartbeatsAfter) override {
+      _device->SendRequestsForRange(count, start, increment, delayBetweenRequests, requestsAhead, heartbeatsAfter);
+    }
+
+    DtcDevice*                  device  () const { return _device; }
+    TrackerRegisterCache const& rocCache() const { return _rocCache; }
+    TrackerRegisterCache const& dtcCache() const { return _dtcCache; }
+
+  private:
+    static uint32_t rocKey_(DTCLib::DTC_Link_ID const& link, DTCLib::roc_address_t address) {
+      return (uint32_t(link) << 16) | address;
+    }
+
+    DtcDevice*            _device;
+    TrackerRegisterCache  _rocCache;
+    TrackerRegisterCache  _dtcCache;
+    std::vector<uint16_t> _rocReset;
+  };
+}  // namespace mu2e
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef otsdaq_mu2e_tracker_Generators_DtcDevice_hh
+#define otsdaq_mu2e_tracker_Generators_DtcDevice_hh
+//-----------------------------------------------------------------------------
+// DtcDevice : the subset of DTCLib::DTC / mu2edev / DTCSoftwareCFO calls used
+// by TrackerVST, collected behind one interface so the board reader can run
+// either on a real DTC (DtcHardwareDevice) or on an in-process stand-in
+// (DtcMockDevice). Method names and semantics follow the DTC library.
+// ROC register access is thread-safe (TrackerRocMonitor samples the counters
+// from its own thread), the DMA calls are made by the readout thread only
+//-----------------------------------------------------------------------------
+#include "dtcInterfaceLib/DTC.h"
+#include "dtcInterfaceLib/DTCSoftwareCFO.h"
+
+#include <cstdint>
+#include <mutex>
+
+namespace mu2e {
+  class DtcDevice {
+  public:
+    virtual ~DtcDevice() {}
+//-----------------------------------------------------------------------------
+// DMA engines, same as mu2edev
+//-----------------------------------------------------------------------------
+    virtual int    read_data      (DTCLib::DTC_DMA_Engine const& chn, void** buffer, int tmo_ms) = 0;
+    virtual int    read_release   (DTCLib::DTC_DMA_Engine const& chn, unsigned num)             = 0;
+    virtual int    release_all    (DTCLib::DTC_DMA_Engine const& chn)                           = 0;
+    virtual void   ResetDeviceTime() = 0;
+    virtual double GetDeviceTime  () = 0;
+//-----------------------------------------------------------------------------
+// DTC and ROC (DCS) registers, same as DTCLib::DTC
+//-----------------------------------------------------------------------------
+    virtual DTCLib::roc_data_t ReadROCRegister (DTCLib::DTC_Link_ID const& link,
+                                                DTCLib::roc_address_t      address,
+                                                int                        tmo_ms) = 0;
+
+    virtual bool               WriteROCRegister(DTCLib::DTC_Link_ID const& link,
+                                                DTCLib::roc_address_t      address,
+                                                DTCLib::roc_data_t         data,
+                                                bool                       requestAck,
+                                                int                        tmo_ms) = 0;
+
+    virtual uint32_t           ReadRegister    (DTCLib::DTC_Register const& address)                = 0;
+    virtual void               WriteRegister   (uint32_t data, DTCLib::DTC_Register const& address) = 0;
+//-----------------------------------------------------------------------------
+// data requests, same as DTCLib::DTCSoftwareCFO
+//-----------------------------------------------------------------------------
+    virtual void SendRequestForTimestamp(DTCLib::DTC_EventWindowTag const& tag, uint32_t heartbeatsAfter = 16) = 0;
+
+    virtual void SendRequestsForRange   (int                               count,
+                                         DTCLib::DTC_EventWindowTag const& start,
+                                         bool                              increment,
+                                         uint32_t                          delayBetweenRequests,
+                                         int                               requestsAhead,
+                                         uint32_t                          heartbeatsAfter) = 0;
+  };
+
+//-----------------------------------------------------------------------------
+// real hardware: forward everything to the DTC library, doesn't own the DTC or the CFO
+//-----------------------------------------------------------------------------
+  class DtcHardwareDevice : public DtcDevice {
+  public:
+    DtcHardwareDevice(DTCLib::DTC* Dtc, DTCLib::DTCSoftwareCFO* Cfo) : _dtc(Dtc), _cfo(Cfo) {}
+
+    int    read_data      (DTCLib::DTC_DMA_Engine const& chn, void** buffer, int tmo_ms) override {
+      return _dtc->GetDevice()->read_data(chn, buffer, tmo_ms);
+    }
+    int    read_release   (DTCLib::DTC_DMA_Engine const& chn, unsigned num) override {
+      return _dtc->GetDevice()->read_release(chn, num);
+    }
+    int    release_all    (DTCLib::DTC_DMA_Engine const& chn) override { return _dtc->GetDevice()->release_all(chn); }
+    void   ResetDeviceTime() override { _dtc->GetDevice()->ResetDeviceTime(); }
+    double GetDeviceTime  () override { return _dtc->GetDevice()->GetDeviceTime(); }
+
+    DTCLib::roc_data_t ReadROCRegister (DTCLib::DTC_Link_ID const& link, DTCLib::roc_address_t address, int tmo_ms) override {
+      std::lock_guard<std::mutex> lock(_dcsMutex);
+      return _dtc->ReadROCRegister(link, address, tmo_ms);
+    }
+
+    bool WriteROCRegister(DTCLib::DTC_Link_ID const& link, DTCLib::roc_address_t address, DTCLib::roc_data_t data,
+                          bool requestAck, int tmo_ms) override {
+      std::lock_guard<std::mutex> lock(_dcsMutex);
+      return _dtc->WriteROCRegister(link, address, data, requestAck, tmo_ms);
+    }
+
+    uint32_t ReadRegister (DTCLib::DTC_Register const& address)                override { return _dtc->ReadRegister_(address); }
+    void     WriteRegister(uint32_t data, DTCLib::DTC_Register const& address) override { _dtc->WriteRegister_(data, address); }
+
+    void SendRequestForTimestamp(DTCLib::DTC_EventWindowTag const& tag, uint32_t heartbeatsAfter) override {
+      _cfo->SendRequestForTimestamp(tag, heartbeatsAfter);
+    }
+
+    void SendRequestsForRange(int count, DTCLib::DTC_EventWindowTag const& start, bool increment,
+                              uint32_t delayBetweenRequests, int requestsAhead, uint32_t heartbeatsAfter) override {
+      _cfo->SendRequestsForRange(count, start, increment, delayBetweenRequests, requestsAhead, heartbeatsAfter);
+    }
+
+  private:
+    DTCLib::DTC*            _dtc;
+    DTCLib::DTCSoftwareCFO* _cfo;
+    std::mutex              _dcsMutex;          // one DCS transaction at a time
+  };
+}  // namespace mu2e
+
+#endif
@@ -0,0 +1,471 @@
+///////////////////////////////////////////////////////////////////////////////
+// software DTC: timing model for the DAQ DMA and DCS paths, see DtcMockDevice.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_DtcMockDevice").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/DtcMockDevice.hh"
+
+#include "cetlib_except/exception.h"
+#include "fhiclcpp/ParameterSet.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+using namespace DTCLib;
+
+//-----------------------------------------------------------------------------
+mu2e::DtcMockDevice::DtcMockDevice(fhicl::ParameterSet const& ps) :
+    _dmaLatency        (ps.get<double>  ("dma_latency_us"     ,   20.))
+  , _bandwidth         (ps.get<double>  ("bandwidth_mb_per_s" , 1000.))
+  , _dcsRoundTrip      (ps.get<double>  ("dcs_round_trip_us"  ,   50.))
+  , _timeoutFraction   (ps.get<double>  ("timeout_fraction"   ,    0.))
+  , _corruptionFraction(ps.get<double>  ("corruption_fraction",    0.))
+  , _linkMask          (ps.get<unsigned>("link_mask"          ,   0x1) & 0x3f)
+  , _packetsPerRoc     (ps.get<size_t>  ("packets_per_roc"    ,    10))
+  , _rocFifoDepth      (ps.get<size_t>  ("roc_fifo_depth"     ,    64))
+  , _nBuffers          (ps.get<size_t>  ("n_buffers"          ,    32))
+  , _trackReleases     (ps.get<bool>    ("track_releases"     , false))
+  , _dtcId             (ps.get<int>     ("dtc_id"             ,     0))
+  , _nextWindowTime    (std::chrono::steady_clock::now())
+  , _nHits             (0)
+  , _nTruncated        (0)
+  , _lastHeartbeatsAfter(0)
+  , _rng               (ps.get<unsigned>("random_seed"        ,     0))
+  , _uniform           (0., 1.)
+  , _dmaFreeTime       (std::chrono::steady_clock::now())
+  , _nextBuffer        (0)
+  , _nBadReleases      (0)
+  , _deviceTime        (0) {
+
+  fhicl::ParameterSet traffic = ps.get<fhicl::ParameterSet>("traffic", fhicl::ParameterSet());
+
+  _hitModel         = (traffic.get<std::string>("model", "counter") == "hits");
+  _panelsPerLink    = std::max(traffic.get<int>("panels_per_link", 1), 1);
+  _occupancy        = traffic.get<double>  ("occupancy"         , 0.01);
+  _offSpillFraction = traffic.get<double>  ("off_spill_fraction", 0.  );
+  _spillWindows     = traffic.get<uint64_t>("spill_windows"     , 0   );
+  _spillPeriod      = traffic.get<uint64_t>("spill_period"      , 0   );
+  _spillsPerCycle   = traffic.get<uint64_t>("spills_per_cycle"  , 8   );
+  _cyclePeriod      = traffic.get<uint64_t>("cycle_period"      , 0   );
+  _nAdcSamples      = traffic.get<int>     ("n_adc_samples"     , 15  );
+  _rate             = traffic.get<double>  ("rate_hz"           , 0.  );
+  _hitPackets       = (94 + 10*_nAdcSamples + 127)/128;  // header fields take 94 bits
+
+  size_t nrocs     = __builtin_popcount(_linkMask)*(_hitModel ? _panelsPerLink : 1);
+  size_t max_bytes = 8 + sizeof(DTC_EventHeader) + sizeof(DTC_SubEventHeader) + nrocs*kPacketSize*(_packetsPerRoc+1);
+  if (_hitModel) max_bytes = 8 + sizeof(DTC_EventHeader) + sizeof(DTC_SubEventHeader) + nrocs*kPacketSize*(_hitPackets+1);
+//-----------------------------------------------------------------------------
+// the DMA buffer is shared equally among the panels
+//-----------------------------------------------------------------------------
+  _maxHitPackets = 0;
+  if (max_bytes <= sizeof(mu2e_databuff_t)) {
+    size_t header_bytes = 8 + sizeof(DTC_EventHeader) + sizeof(DTC_SubEventHeader);
+    _maxHitPackets = (sizeof(mu2e_databuff_t)-header_bytes)/(kPacketSize*nrocs) - 1;
+  }
+
+  if (max_bytes > sizeof(mu2e_databuff_t)) {
+    throw cet::exception("DtcMockDevice") << "event size " << max_bytes << " exceeds the DMA buffer size "
+                                          << sizeof(mu2e_databuff_t) << ", reduce packets_per_roc or panels_per_link";
+  }
+
+  if (_bandwidth <= 0) _bandwidth = 1.e6;
+
+  _ring.resize(_nBuffers*sizeof(mu2e_databuff_t));
+
+  memset(_rocRegister, 0, sizeof(_rocRegister));
+  for (int link=0; link<kNLinks; link++) _rocRegister[link][0] = 0x1234;
+
+  TLOG(TLVL_INFO) << "DtcMockDevice: link_mask=0x" << std::hex << _linkMask << std::dec
+                  << " latency=" << _dmaLatency << " us bandwidth=" << _bandwidth << " MB/s"
+                  << " DCS round trip=" << _dcsRoundTrip << " us"
+                  << " timeout fraction=" << _timeoutFraction
+                  << " corruption fraction=" << _corruptionFraction;
+  if (_hitModel) {
+    TLOG(TLVL_INFO) << "DtcMockDevice: straw hits, " << _panelsPerLink << " panel(s) per link, occupancy=" << _occupancy
+                    << " spill: " << _spillWindows << "/" << _spillPeriod << " windows x " << _spillsPerCycle
+                    << " per " << _cyclePeriod << " rate=" << _rate << " Hz";
+  }
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::DtcMockDevice::sleepUntil_(time_point_t T) {
+  if (T > std::chrono::steady_clock::now()) std::this_thread::sleep_until(T);
+}
+
+//-----------------------------------------------------------------------------
+// ROC counters are 32-bit, split over two consecutive 16-bit registers
+//-----------------------------------------------------------------------------
+void mu2e::DtcMockDevice::incrementCounter_(int Link, int LowRegister, uint32_t N) {
+  uint16_t* r = _rocRegister[Link];
+  uint32_t  c = ((uint32_t(r[LowRegister+1]) << 16) | r[LowRegister]) + N;
+  r[LowRegister  ] = c & 0xffff;
+  r[LowRegister+1] = (c >> 16) & 0xffff;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::DtcMockDevice::resetCounters_(int Link) {
+  uint16_t* r = _rocRegister[Link];
+  for (int i=23; i<60; i++) r[i] = 0;
+  r[64] = 0;
+  r[65] = 0;
+}
+
+//-----------------------------------------------------------------------------
+// one request goes to all ROCs in the link mask. A ROC holds at most _rocFifoDepth
+// pending requests, the oldest one is lost on overflow and SIZE_FIFO_FULL is set
+//-----------------------------------------------------------------------------
+void mu2e::DtcMockDevice::enqueueRequest_(uint64_t Tag) {
+  auto now = std::chrono::steady_clock::now();
+
+  bool full = (_requests.size() >= _rocFifoDepth);
+  if (full) _requests.pop_front();
+
+  Request req;
+  req.tag   = Tag;
+  req.ready = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      std::chrono::duration<double, std::micro>(_dmaLatency));
+  req.lost  = (_uniform(_rng) < _timeoutFraction);
+  _requests.push_back(req);
+
+  for (int link=0; link<kNLinks; link++) {
+    if (((_linkMask >> link) & 0x1) == 0) continue;
+    incrementCounter_(link, 64);                       // N(EWM) seen
+    incrementCounter_(link, 27);                       // N(HBT) seen
+    incrementCounter_(link, 35);                       // N(data req)
+    incrementCounter_(link, 23);                       // STORE_CNT
+    if (full) _rocRegister[link][24] |= (1 << 12);     // SIZE_FIFO_FULL, bit 28 of the 32-bit word
+    _rocRegister[link][54] = Tag         & 0xffff;     // last data request tag
+    _rocRegister[link][55] = (Tag >> 16) & 0xffff;
+    _rocRegister[link][56] = (Tag >> 32) & 0xffff;
+  }
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::DtcMockDevice::formatEvent_(uint64_t Tag, uint8_t* Buffer, bool Corrupt) {
+  size_t nrocs     = __builtin_popcount(_linkMask)*(_hitModel ? _panelsPerLink : 1);
+  size_t roc_bytes = kPacketSize*(_packetsPerRoc+1);
+  size_t sub_bytes = sizeof(DTC_SubEventHeader) + nrocs*roc_bytes;
+  size_t evt_bytes = sizeof(DTC_EventHeader) + sub_bytes;
+  uint64_t total   = 8 + evt_bytes;
+//-----------------------------------------------------------------------------
+// with hits the sizes are known only at the end: clear the headers now, the
+// data packets are written in full
+//-----------------------------------------------------------------------------
+  if (_hitModel) memset(Buffer, 0, 8 + sizeof(DTC_EventHeader) + sizeof(DTC_SubEventHeader));
+  else           memset(Buffer, 0, total);
+
+  auto eh = reinterpret_cast<DTC_EventHeader*>(Buffer+8);
+  eh->inclusive_event_byte_count = evt_bytes;
+  eh->event_tag_low              = Tag & 0xffffffff;
+  eh->event_tag_high             = (Tag >> 32) & 0xffff;
+  eh->num_dtcs                   = 1;
+
+  auto sh = reinterpret_cast<DTC_SubEventHeader*>(eh+1);
+  sh->inclusive_subevent_byte_count = sub_bytes;
+  sh->event_tag_low                 = Tag & 0xffffffff;
+  sh->event_tag_high                = (Tag >> 32) & 0xffff;
+  sh->num_rocs                      = nrocs;
+  sh->source_dtc_id                 = _dtcId;
+//-----------------------------------------------------------------------------
+// ROC data header packet: byte count, valid|link|packet type (5), packet count,
+// 48-bit event window tag, status, DTC ID; followed by the data packets
+//-----------------------------------------------------------------------------
+  uint16_t* p = reinterpret_cast<uint16_t*>(sh+1);
+  uint16_t* first_roc = p;
+
+  for (int link=0; link<kNLinks; link++) {
+    if (((_linkMask >> link) & 0x1) == 0) continue;
+
+    for (int panel=0; panel<(_hitModel ? _panelsPerLink : 1); panel++) {
+      size_t npackets = _packetsPerRoc;
+      if (_hitModel) {
+        npackets  = formatHits_(Tag, link*_panelsPerLink+panel, reinterpret_cast<uint8_t*>(p+kPacketSize/2), _maxHitPackets);
+        roc_bytes = kPacketSize*(npackets+1);
+      }
+      else {
+        uint16_t* data = p+kPacketSize/2;
+        for (size_t i=0; i<_packetsPerRoc*kPacketSize/2; i++) data[i] = i;
+      }
+
+      memset(p, 0, kPacketSize);
+      p[0] = roc_bytes;
+      p[1] = (1 << 15) | (link << 8) | (5 << 4);
+      p[2] = npackets;
+      p[3] = Tag         & 0xffff;
+      p[4] = (Tag >> 16) & 0xffff;
+      p[5] = (Tag >> 32) & 0xffff;
+
+      p += roc_bytes/2;
+    }
+  }
+
+  if (_hitModel) {
+    evt_bytes = reinterpret_cast<uint8_t*>(p) - reinterpret_cast<uint8_t*>(eh);
+    sub_bytes = evt_bytes - sizeof(DTC_EventHeader);
+    total     = 8 + evt_bytes;
+    eh->inclusive_event_byte_count    = evt_bytes;
+    sh->inclusive_subevent_byte_count = sub_bytes;
+  }
+  memcpy(Buffer, &total, sizeof(total));
+//-----------------------------------------------------------------------------
+// the same words TrackerVST::readDTCBuffer checks : 1,2,3,7,8
+//-----------------------------------------------------------------------------
+  if (Corrupt and (nrocs > 0)) {
+    static const int words[] = {0, 1, 2, 6, 7};
+    int iw = std::min(int(_uniform(_rng)*5), 4);
+    first_roc[words[iw]] = (_uniform(_rng) < 0.5) ? 0xcafe : 0xdead;
+  }
+
+  return total;
+}
+
+//-----------------------------------------------------------------------------
+// occupancy for the event window Tag: on spill, scaled down between the spills
+// and in the gap at the end of the supercycle
+//-----------------------------------------------------------------------------
+double mu2e::DtcMockDevice::occupancy_(uint64_t Tag) const {
+  if (_spillWindows == 0) return _occupancy;
+
+  double   off = _occupancy*_offSpillFraction;
+  uint64_t t   = (_cyclePeriod > 0) ? Tag % _cyclePeriod : Tag;
+
+  if (_spillPeriod == 0) return (t < _spillWindows) ? _occupancy : off;
+  if ((_cyclePeriod > 0) and (t >= _spillsPerCycle*_spillPeriod)) return off;
+
+  return (t % _spillPeriod < _spillWindows) ? _occupancy : off;
+}
+
+//-----------------------------------------------------------------------------
+// straw hits of one panel, in the layout decoded by TrackerHitDecoder:
+// straw index, TDC0/TOT0, TDC1/TOT1, NumADCPackets|PMP, then 10-bit ADC
+// samples from bit 94 on. Times uniform over the event window, the waveform
+// is a pedestal plus a pulse of random height
+//-----------------------------------------------------------------------------
+size_t mu2e::DtcMockDevice::formatHits_(uint64_t Tag, int Panel, uint8_t* Data, size_t MaxPackets) {
+  static const float shape[] = {0.00, 0.05, 0.40, 0.90, 1.00, 0.85, 0.65, 0.48,
+                                0.35, 0.25, 0.18, 0.13, 0.09, 0.06, 0.04, 0.03};
+  const int      nstraws  = 96;
+  const uint32_t pedestal = 100;
+
+  std::poisson_distribution<int> nhits_distribution(nstraws*occupancy_(Tag));
+  int nhits = nhits_distribution(_rng);
+
+  size_t maxhits = MaxPackets/_hitPackets;
+  if (size_t(nhits) > maxhits) {
+    _nTruncated++;
+    nhits = maxhits;
+  }
+
+  memset(Data, 0, nhits*_hitPackets*kPacketSize);
+
+  for (int i=0; i<nhits; i++) {
+    uint8_t*  hit = Data + i*_hitPackets*kPacketSize;
+    uint16_t* w   = reinterpret_cast<uint16_t*>(hit);
+
+    uint32_t straw = std::min(int(_uniform(_rng)*nstraws), nstraws-1);
+    uint32_t tdc0  = uint32_t(_uniform(_rng)*0xa000);
+    uint32_t tdc1  = tdc0 + uint32_t(_uniform(_rng)*0x400);
+    uint32_t tot   = uint32_t(_uniform(_rng)*16) & 0xf;
+
+    w[0] = ((Panel & 0x1ff) << 7) | straw;
+    w[1] = tdc0 & 0xffff;
+    w[2] = ((tdc0 >> 16) & 0xff) | (tot << 8) | ((Tag & 0xf) << 12);
+    w[3] = tdc1 & 0xffff;
+    w[4] = ((tdc1 >> 16) & 0xff) | (tot << 8);
+    w[5] = (_hitPackets-1) & 0xf;
+
+    double height = 50 + 600*_uniform(_rng);
+    size_t pos    = 94;
+    for (int k=0; k<_nAdcSamples; k++, pos+=10) {
+      uint32_t adc = std::min(uint32_t(pedestal + height*shape[k % 16]), uint32_t(0x3ff));
+      uint32_t v   = adc << (pos & 0x7);
+      hit[pos/8  ] |= v & 0xff;
+      hit[pos/8+1] |= (v >> 8) & 0xff;
+      if ((pos & 0x7) > 6) hit[pos/8+2] |= (v >> 16) & 0xff;
+    }
+  }
+
+  _nHits += nhits;
+  return nhits*_hitPackets;
+}
+
+//-----------------------------------------------------------------------------
+int mu2e::DtcMockDevice::read_data(DTC_DMA_Engine const& chn, void** buffer, int tmo_ms) {
+  auto start    = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::milliseconds(tmo_ms);
+  int  sts      = 0;
+
+  *buffer = nullptr;
+
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  if ((chn == DTC_DMA_Engine_DAQ) and (_held.size() < _nBuffers) and (not _requests.empty())) {
+    Request req = _requests.front();
+    auto    begin = std::max(req.ready, _dmaFreeTime);
+    if (_rate > 0) begin = std::max(begin, _nextWindowTime);
+
+    if (begin <= deadline) {
+      _requests.pop_front();
+      if (not req.lost) {
+        uint8_t* buf    = &_ring[_nextBuffer*sizeof(mu2e_databuff_t)];
+        bool     bad    = (_uniform(_rng) < _corruptionFraction);
+        size_t   nbytes = formatEvent_(req.tag, buf, bad);
+
+        _dmaFreeTime = begin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                 std::chrono::duration<double, std::micro>(nbytes/_bandwidth));
+        if (_rate > 0) {
+          _nextWindowTime = begin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                      std::chrono::duration<double>(1./_rate));
+        }
+        auto done    = _dmaFreeTime;
+        lock.unlock();
+        sleepUntil_(done);
+        lock.lock();
+
+        for (int link=0; link<kNLinks; link++) {
+          if (((_linkMask >> link) & 0x1) == 0) continue;
+          incrementCounter_(link, 37);                 // N(data req read DDR)
+          incrementCounter_(link, 39);                 // N(data req sent DTC)
+          incrementCounter_(link, 25);                 // FETCH_CNT
+        }
+
+        _held.push_back(Held{_nextBuffer, req.tag});
+        _nextBuffer = (_nextBuffer+1) % _nBuffers;
+        *buffer     = buf;
+        sts         = nbytes;
+      }
+      else {
+        for (int link=0; link<kNLinks; link++) {
+          if (((_linkMask >> link) & 0x1) == 0) continue;
+          incrementCounter_(link, 41);                 // N(data req null data)
+        }
+      }
+    }
+  }
+
+  lock.unlock();
+  if (sts == 0) sleepUntil_(deadline);
+
+  _deviceTime += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  return sts;
+}
+
+//-----------------------------------------------------------------------------
+// like the DMA driver: the oldest buffer out goes back first
+//-----------------------------------------------------------------------------
+void mu2e::DtcMockDevice::releaseOldest_() {
+  if (_held.empty()) {
+    _nBadReleases++;
+    return;
+  }
+
+  if (_trackReleases) {
+    Held const& h = _held.front();
+    _releasedTags.push_back(h.tag);
+    uint16_t* w = reinterpret_cast<uint16_t*>(&_ring[h.index*sizeof(mu2e_databuff_t)]);
+    std::fill(w, w+sizeof(mu2e_databuff_t)/sizeof(uint16_t), 0xdead);
+  }
+  _held.pop_front();
+}
+
+//-----------------------------------------------------------------------------
+int mu2e::DtcMockDevice::read_release(DTC_DMA_Engine const& chn, unsigned num) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (unsigned i=0; i<num; i++) releaseOldest_();
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int mu2e::DtcMockDevice::release_all(DTC_DMA_Engine const& chn) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  while (not _held.empty()) releaseOldest_();
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<uint64_t> mu2e::DtcMockDevice::releasedTags() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _releasedTags;
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::DtcMockDevice::nHeld() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _held.size();
+}
+
+//-----------------------------------------------------------------------------
+// the DCS transactions are serialized like on the DTC, the round trip is
+// spent under the DCS lock only: the DAQ path goes on meanwhile
+//-----------------------------------------------------------------------------
+roc_data_t mu2e::DtcMockDevice::ReadROCRegister(DTC_Link_ID const& link, roc_address_t address, int tmo_ms) {
+  std::lock_guard<std::mutex> dcs(_dcsMutex);
+  sleepUntil_(std::chrono::steady_clock::now() + std::chrono::microseconds(long(_dcsRoundTrip)));
+
+  int ilink = int(link);
+  if ((ilink >= kNLinks) or (((_linkMask >> ilink) & 0x1) == 0) or (address >= kNRocRegisters)) return 0xffff;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  return _rocRegister[ilink][address];
+}
+
+//-----------------------------------------------------------------------------
+// register 14 resets the link, that also clears the ROC counters. Serialized
+// with the reads
+//-----------------------------------------------------------------------------
+bool mu2e::DtcMockDevice::WriteROCRegister(DTC_Link_ID const& link, roc_address_t address, roc_data_t data,
+                                           bool requestAck, int tmo_ms) {
+  std::lock_guard<std::mutex> dcs(_dcsMutex);
+  sleepUntil_(std::chrono::steady_clock::now() + std::chrono::microseconds(long(_dcsRoundTrip)));
+
+  int ilink = int(link);
+  if ((ilink >= kNLinks) or (((_linkMask >> ilink) & 0x1) == 0) or (address >= kNRocRegisters)) return false;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if ((address == 14) and (data & 0x1)) {
+    resetCounters_(ilink);
+    _requests.clear();
+  }
+  else {
+    _rocRegister[ilink][address] = data;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+uint32_t mu2e::DtcMockDevice::ReadRegister(DTC_Register const& address) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _dtcRegister.find(address);
+  return (it != _dtcRegister.end()) ? it->second : 0;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::DtcMockDevice::WriteRegister(uint32_t data, DTC_Register const& address) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _dtcRegister[address] = data;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::DtcMockDevice::SendRequestForTimestamp(DTC_EventWindowTag const& tag, uint32_t heartbeatsAfter) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _lastHeartbeatsAfter = heartbeatsAfter;
+  enqueueRequest_(tag.GetEventWindowTag(true));
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::DtcMockDevice::SendRequestsForRange(int count, DTC_EventWindowTag const& start, bool increment,
+                                               uint32_t delayBetweenRequests, int requestsAhead,
+                                               uint32_t heartbeatsAfter) {
+  uint64_t tag = start.GetEventWindowTag(true);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _lastHeartbeatsAfter = heartbeatsAfter;
+  for (int i=0; i<count; i++) {
+    enqueueRequest_(tag);
+    if (increment) tag++;
+  }
+}
@@ -0,0 +1,189 @@
+#ifndef otsdaq_mu2e_tracker_Generators_DtcMockDevice_hh
+#define otsdaq_mu2e_tracker_Generators_DtcMockDevice_hh
+//-----------------------------------------------------------------------------
+// DtcMockDevice : in-process stand-in for a DTC with one or several tracker ROCs
+// behind it. Used to profile and regression-test the TrackerVST request/readout
+// pipeline without hardware. Configured with a 'mock_config' FHiCL table:
+//
+// mock_config : {
+//   dma_latency_us      : 20      # data request -> start of the DMA transfer
+//   bandwidth_mb_per_s  : 1000.   # DAQ DMA bandwidth, transfers are serialized
+//   dcs_round_trip_us   : 50      # one ROC register read or write
+//   timeout_fraction    : 0.      # fraction of requests never answered (read_data times out)
+//   corruption_fraction : 0.      # fraction of events with 0xcafe/0xdead in the first ROC packet
+//   link_mask           : 0x1     # links with a ROC on them
+//   packets_per_roc     : 10      # data packets per ROC per event window
+//   roc_fifo_depth      : 64      # pending requests a ROC can hold, then SIZE_FIFO_FULL
+//   n_buffers           : 32      # DMA ring size
+//   random_seed         : 0
+//   track_releases      : false   # see below
+//   dtc_id              : 0       # source DTC ID in the sub-event header
+//   traffic             : { ... }  # see below
+// }
+//
+// track_releases : the tags of the buffers given back by read_release/
+// release_all are logged in release order (releasedTags()), a released
+// buffer is overwritten with 0xdead so that a late reader of it sees garbage,
+// and a release with no buffer out is counted (nBadReleases())
+//
+// each event is formatted the way the DTC delivers it: 8-byte DMA byte count,
+// DTC_EventHeader, DTC_SubEventHeader, then per ROC a data header packet followed
+// by the data packets (increasing counter pattern, as ROC register 8 = 0x10)
+//
+// traffic : synthetic straw hits instead of the counter pattern, in the hit
+// format of TrackerHitDecoder. To see how far the board reader scales:
+//
+// traffic : {
+//   model              : "counter"  # or "hits"
+//   panels_per_link    : 1          # ROC blocks per link, panel number in the straw index
+//   occupancy          : 0.01       # mean hits per straw per event window, on spill
+//   off_spill_fraction : 0.         # occupancy between spills, relative to on spill
+//   spill_windows      : 0          # event windows per spill, 0: no spill structure
+//   spill_period       : 0          # event windows from one spill to the next, 0: one spill per cycle
+//   spills_per_cycle   : 8
+//   cycle_period       : 0          # event windows per supercycle, 0: spills never stop
+//   n_adc_samples      : 15
+//   rate_hz            : 0.         # event windows delivered per second, 0: no limit
+// }
+//
+// hit counts per panel are Poisson, the straws uniform, which makes the count
+// on each straw Poisson with the configured occupancy. A panel with more hits
+// than fit in the DMA buffer is truncated (nTruncated()). For the highest rate
+// also set dma_latency_us : 0 and bandwidth_mb_per_s : 0 (no limit)
+//-----------------------------------------------------------------------------
+#include "otsdaq-mu2e-tracker/Generators/DtcDevice.hh"
+
+#include "fhiclcpp/fwd.h"
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace mu2e {
+  class DtcMockDevice : public DtcDevice {
+  public:
+    enum {
+      kNLinks        = 6,
+      kNRocRegisters = 256,
+      kPacketSize    = 16,             // bytes
+    };
+
+    explicit DtcMockDevice(fhicl::ParameterSet const& ps);
+    virtual ~DtcMockDevice() {}
+
+    int    read_data      (DTCLib::DTC_DMA_Engine const& chn, void** buffer, int tmo_ms) override;
+    int    read_release   (DTCLib::DTC_DMA_Engine const& chn, unsigned num)             override;
+    int    release_all    (DTCLib::DTC_DMA_Engine const& chn)                           override;
+    void   ResetDeviceTime() override { _deviceTime = 0; }
+    double GetDeviceTime  () override { return _deviceTime; }
+
+    DTCLib::roc_data_t ReadROCRegister (DTCLib::DTC_Link_ID const& link,
+                                        DTCLib::roc_address_t      address,
+                                        int                        tmo_ms) override;
+
+    bool               WriteROCRegister(DTCLib::DTC_Link_ID const& link,
+                                        DTCLib::roc_address_t      address,
+                                        DTCLib::roc_data_t         data,
+                                        bool                       requestAck,
+                                        int                        tmo_ms) override;
+
+    uint32_t           ReadRegister    (DTCLib::DTC_Register const& address) override;
+    void               WriteRegister   (uint32_t data, DTCLib::DTC_Register const& address) override;
+
+    void SendRequestForTimestamp(DTCLib::DTC_EventWindowTag const& tag, uint32_t heartbeatsAfter) override;
+
+    void SendRequestsForRange   (int                               count,
+                                 DTCLib::DTC_EventWindowTag const& start,
+                                 bool                              increment,
+                                 uint32_t                          delayBetweenRequests,
+                                 int                               requestsAhead,
+                                 uint32_t                          heartbeatsAfter) override;
+
+    size_t nHits      () const { return _nHits;      }
+    size_t nTruncated () const { return _nTruncated; }
+                                        // of the last request sent
+    uint32_t lastHeartbeatsAfter() const { return _lastHeartbeatsAfter; }
+                                        // track_releases only
+    std::vector<uint64_t> releasedTags() const;
+    size_t nBadReleases() const { return _nBadReleases; }
+    size_t nHeld       () const;
+
+  protected:
+    typedef std::chrono::steady_clock::time_point time_point_t;
+
+    struct Request {
+      uint64_t     tag;
+      time_point_t ready;              // earliest time the DMA transfer can start
+      bool         lost;               // injected timeout
+    };
+
+    struct Held {
+      size_t       index;              // in the ring
+      uint64_t     tag;
+    };
+
+    void     enqueueRequest_  (uint64_t Tag);
+                                        // returns the number of bytes written, including the DMA byte count
+    size_t   formatEvent_     (uint64_t Tag, uint8_t* Buffer, bool Corrupt);
+                                        // ROC data packets of one panel, returns the number of packets
+    size_t   formatHits_      (uint64_t Tag, int Panel, uint8_t* Data, size_t MaxPackets);
+    double   occupancy_       (uint64_t Tag) const;
+
+    void     incrementCounter_(int Link, int LowRegister, uint32_t N = 1);
+    void     resetCounters_   (int Link);
+    void     sleepUntil_      (time_point_t T);
+    void     releaseOldest_   ();
+
+    double   _dmaLatency;              // us
+    double   _bandwidth;               // MB/s
+    double   _dcsRoundTrip;            // us
+    double   _timeoutFraction;
+    double   _corruptionFraction;
+    unsigned _linkMask;
+    size_t   _packetsPerRoc;
+    size_t   _rocFifoDepth;
+    size_t   _nBuffers;
+    bool     _trackReleases;
+    int      _dtcId;
+
+    bool     _hitModel;                // traffic.model == "hits"
+    int      _panelsPerLink;
+    double   _occupancy;
+    double   _offSpillFraction;
+    uint64_t _spillWindows;
+    uint64_t _spillPeriod;
+    uint64_t _spillsPerCycle;
+    uint64_t _cyclePeriod;
+    int      _nAdcSamples;
+    int      _hitPackets;              // 16-byte packets per hit
+    size_t   _maxHitPackets;           // data packets per panel which fit in the DMA buffer
+    double   _rate;                    // Hz, 0: no limit
+    time_point_t _nextWindowTime;      // rate limit: earliest start of the next transfer
+    size_t   _nHits;
+    size_t   _nTruncated;
+    uint32_t _lastHeartbeatsAfter;
+
+    std::mt19937                           _rng;
+    std::uniform_real_distribution<double> _uniform;
+
+    std::deque<Request>          _requests;
+    time_point_t                 _dmaFreeTime;        // end of the last DMA transfer
+    std::vector<uint8_t>         _ring;               // _nBuffers x sizeof(mu2e_databuff_t)
+    size_t                       _nextBuffer;
+    std::deque<Held>             _held;               // buffers returned by read_data, not released yet, oldest first
+    std::vector<uint64_t>        _releasedTags;
+    size_t                       _nBadReleases;
+    double                       _deviceTime;         // seconds spent in read_data
+
+    uint16_t                     _rocRegister[kNLinks][kNRocRegisters];
+    std::map<uint32_t, uint32_t> _dtcRegister;
+
+    mutable std::mutex           _mutex;              // registers and request queue, not held while sleeping
+    std::mutex                   _dcsMutex;           // one DCS transaction at a time, as on the DTC
+  };
+}  // namespace mu2e
+
+#endif
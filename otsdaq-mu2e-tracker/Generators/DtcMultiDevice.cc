@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////////////
+// several DTCs read by one thread, see DtcMultiDevice.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_DtcMultiDevice").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/DtcMultiDevice.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+using namespace DTCLib;
+
+//-----------------------------------------------------------------------------
+mu2e::DtcMultiDevice::DtcMultiDevice(std::vector<DtcDevice*> const& Devices, fhicl::ParameterSet const& ps) :
+    _devices       (Devices)
+  , _next          (0)
+  , _lastSource    (-1)
+  , _pollUs        (std::max(ps.get<int>("poll_interval_us"    ,   20), 1))
+  , _maxPollUs     (std::max(ps.get<int>("max_poll_interval_us", 1000), 1))
+  , _deviceTime    (0)
+  , _nReads        (Devices.size(), 0)
+  , _nIdlePolls    (0)
+  , _nStrayReleases(0) {
+
+  _maxPollUs = std::max(_maxPollUs, _pollUs);
+
+  TLOG(TLVL_INFO) << "DtcMultiDevice: " << _devices.size() << " DTCs, poll_interval_us=" << _pollUs
+                  << " max_poll_interval_us=" << _maxPollUs;
+}
+
+//-----------------------------------------------------------------------------
+mu2e::DtcMultiDevice::~DtcMultiDevice() {
+  for (DtcDevice* d : _devices) delete d;
+}
+
+//-----------------------------------------------------------------------------
+// the DCS DMA engine is the primary's only
+//-----------------------------------------------------------------------------
+int mu2e::DtcMultiDevice::read_data(DTC_DMA_Engine const& chn, void** buffer, int tmo_ms) {
+  if (chn != DTC_DMA_Engine_DAQ) return _devices[0]->read_data(chn, buffer, tmo_ms);
+
+  auto   start    = std::chrono::steady_clock::now();
+  auto   deadline = start + std::chrono::milliseconds(tmo_ms);
+  int    sleepUs  = _pollUs;
+  int    sts      = 0;
+  size_t n        = _devices.size();
+
+  while (true) {
+    for (size_t k=0; k<n; k++) {
+      size_t i = (_next+k) % n;
+      sts = _devices[i]->read_data(chn, buffer, 0);
+      if (sts > 0) {
+        _next       = (i+1) % n;
+        _lastSource = i;
+        _held.push_back(i);
+        _nReads[i]++;
+        break;
+      }
+    }
+    if (sts > 0) break;
+
+    _nIdlePolls++;
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      sts = 0;
+      break;
+    }
+    std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(std::chrono::microseconds(sleepUs),
+                                                                              deadline-now));
+    sleepUs = std::min(2*sleepUs, _maxPollUs);
+  }
+
+  _deviceTime += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  return sts;
+}
+
+//-----------------------------------------------------------------------------
+// each buffer goes back to the device it came from. A release with nothing
+// held has no buffer to give back on any device: it is only counted
+//-----------------------------------------------------------------------------
+int mu2e::DtcMultiDevice::read_release(DTC_DMA_Engine const& chn, unsigned num) {
+  if (chn != DTC_DMA_Engine_DAQ) return _devices[0]->read_release(chn, num);
+
+  int rc = 0;
+  for (unsigned i=0; i<num; i++) {
+    if (_held.empty()) {
+      _nStrayReleases += num-i;
+      break;
+    }
+    rc |= _devices[_held.front()]->read_release(chn, 1);
+    _held.pop_front();
+  }
+  return rc;
+}
+
+//-----------------------------------------------------------------------------
+int mu2e::DtcMultiDevice::release_all(DTC_DMA_Engine const& chn) {
+  if (chn == DTC_DMA_Engine_DAQ) _held.clear();
+
+  int rc = 0;
+  for (DtcDevice* d : _devices) rc |= d->release_all(chn);
+  return rc;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::DtcMultiDevice::ResetDeviceTime() {
+  _deviceTime = 0;
+  for (DtcDevice* d : _devices) d->ResetDeviceTime();
+}
+
+//-----------------------------------------------------------------------------
+bool mu2e::DtcMultiDevice::WriteROCRegister(DTC_Link_ID const& link, roc_address_t address, roc_data_t data,
+                                            bool requestAck, int tmo_ms) {
+  bool ok = true;
+  for (DtcDevice* d : _devices) ok = d->WriteROCRegister(link, address, data, requestAck, tmo_ms) and ok;
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::DtcMultiDevice::WriteRegister(uint32_t data, DTC_Register const& address) {
+  for (DtcDevice* d : _devices) d->WriteRegister(data, address);
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::DtcMultiDevice::SendRequestForTimestamp(DTC_EventWindowTag const& tag, uint32_t heartbeatsAfter) {
+  for (DtcDevice* d : _devices) d->SendRequestForTimestamp(tag, heartbeatsAfter);
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::DtcMultiDevice::SendRequestsForRange(int count, DTC_EventWindowTag const& start, bool increment,
+                                                uint32_t delayBetweenRequests, int requestsAhead,
+                                                uint32_t heartbeatsAfter) {
+  for (DtcDevice* d : _devices) {
+    d->SendRequestsForRange(count, start, increment, delayBetweenRequests, requestsAhead, heartbeatsAfter);
+  }
+}
@@ -0,0 +1,85 @@
+#ifndef otsdaq_mu2e_tracker_Generators_DtcMultiDevice_hh
+#define otsdaq_mu2e_tracker_Generators_DtcMultiDevice_hh
+//-----------------------------------------------------------------------------
+// DtcMultiDevice : several DTCs behind one DtcDevice, read by one thread.
+// Owns the devices behind it, the first one is the primary
+//
+// - read_data() polls the DAQ DMA engines of all devices without blocking,
+//   round-robin from the one after the last served, and returns the first
+//   buffer found. With none ready it sleeps poll_interval_us, doubling up to
+//   max_poll_interval_us, until the timeout. lastSource() says which device
+//   the buffer came from
+// - read_release() gives the buffers back in read order, each to its device.
+//   Releases beyond the buffers held are ignored (nStrayReleases())
+// - data requests, DTC and ROC register writes go to all the devices,
+//   register reads to the primary
+//
+// TrackerVST : the DTCs in multi_dtc.dtc_ids are read in addition to dtc_id
+//
+// multi_dtc : {
+//   dtc_ids              : [ ]
+//   poll_interval_us     : 20
+//   max_poll_interval_us : 1000
+// }
+//-----------------------------------------------------------------------------
+#include "otsdaq-mu2e-tracker/Generators/DtcDevice.hh"
+
+#include "fhiclcpp/fwd.h"
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace mu2e {
+  class DtcMultiDevice : public DtcDevice {
+  public:
+    DtcMultiDevice(std::vector<DtcDevice*> const& Devices, fhicl::ParameterSet const& ps);
+    ~DtcMultiDevice() override;
+
+    int    read_data      (DTCLib::DTC_DMA_Engine const& chn, void** buffer, int tmo_ms) override;
+    int    read_release   (DTCLib::DTC_DMA_Engine const& chn, unsigned num)             override;
+    int    release_all    (DTCLib::DTC_DMA_Engine const& chn)                           override;
+    void   ResetDeviceTime() override;
+    double GetDeviceTime  () override { return _deviceTime; }
+
+    DTCLib::roc_data_t ReadROCRegister (DTCLib::DTC_Link_ID const& link, DTCLib::roc_address_t address, int tmo_ms) override {
+      return _devices[0]->ReadROCRegister(link, address, tmo_ms);
+    }
+
+    bool WriteROCRegister(DTCLib::DTC_Link_ID const& link, DTCLib::roc_address_t address, DTCLib::roc_data_t data,
+                          bool requestAck, int tmo_ms) override;
+
+    uint32_t ReadRegister (DTCLib::DTC_Register const& address)                override { return _devices[0]->ReadRegister(address); }
+    void     WriteRegister(uint32_t data, DTCLib::DTC_Register const& address) override;
+
+    void SendRequestForTimestamp(DTCLib::DTC_EventWindowTag const& tag, uint32_t heartbeatsAfter) override;
+
+    void SendRequestsForRange(int count, DTCLib::DTC_EventWindowTag const& start, bool increment,
+                              uint32_t delayBetweenRequests, int requestsAhead, uint32_t heartbeatsAfter) override;
+
+    size_t     nDevices  () const { return _devices.size(); }
+    DtcDevice* device    (size_t I) const { return _devices[I]; }
+                                        // device of the last buffer read_data() returned
+    int        lastSource() const { return _lastSource;     }
+
+    size_t     nReads    (size_t I) const { return _nReads[I]; }
+                                        // rounds over all devices without a buffer
+    size_t     nIdlePolls() const { return _nIdlePolls;     }
+                                        // read_release() calls with no buffer held
+    size_t     nStrayReleases() const { return _nStrayReleases; }
+
+  private:
+    std::vector<DtcDevice*> _devices;
+    std::deque<int>         _held;              // device of each DAQ buffer not released yet
+    size_t                  _next;              // polled first
+    int                     _lastSource;
+    int                     _pollUs;
+    int                     _maxPollUs;
+    double                  _deviceTime;        // seconds spent in read_data
+    std::vector<size_t>     _nReads;
+    size_t                  _nIdlePolls;
+    size_t                  _nStrayReleases;
+  };
+}  // namespace mu2e
+
+#endif
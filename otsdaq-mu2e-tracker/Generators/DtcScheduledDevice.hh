@@ -0,0 +1,68 @@
+#ifndef otsdaq_mu2e_tracker_Generators_DtcScheduledDevice_hh
+#define otsdaq_mu2e_tracker_Generators_DtcScheduledDevice_hh
+//-----------------------------------------------------------------------------
+// DtcScheduledDevice : DtcDevice in front of another one, the ROC register
+// (DCS) transactions go through a TrackerDcsScheduler at a fixed priority and
+// the caller waits for them. DMA, DTC registers and data requests are
+// forwarded as they are. Owns the device behind it if asked to
+//
+// TrackerVST puts one in front of its device (kHigh, run control) and one in
+// front of the ROC monitor (kNormal); the diagnostics go to the scheduler
+// directly (kLow) and don't wait
+//-----------------------------------------------------------------------------
+#include "otsdaq-mu2e-tracker/Generators/DtcDevice.hh"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerDcsScheduler.hh"
+
+namespace mu2e {
+  class DtcScheduledDevice : public DtcDevice {
+  public:
+    DtcScheduledDevice(DtcDevice* Device, TrackerDcsScheduler* Scheduler, TrackerDcsScheduler::Priority_t Priority,
+                       bool Owner) :
+      _device(Device), _scheduler(Scheduler), _priority(Priority), _owner(Owner) {}
+
+    ~DtcScheduledDevice() override { if (_owner) delete _device; }
+
+    int    read_data      (DTCLib::DTC_DMA_Engine const& chn, void** buffer, int tmo_ms) override {
+      return _device->read_data(chn, buffer, tmo_ms);
+    }
+    int    read_release   (DTCLib::DTC_DMA_Engine const& chn, unsigned num) override {
+      return _device->read_release(chn, num);
+    }
+    int    release_all    (DTCLib::DTC_DMA_Engine const& chn) override { return _device->release_all(chn); }
+    void   ResetDeviceTime() override { _device->ResetDeviceTime(); }
+    double GetDeviceTime  () override { return _device->GetDeviceTime(); }
+
+    DTCLib::roc_data_t ReadROCRegister (DTCLib::DTC_Link_ID const& link, DTCLib::roc_address_t address, int tmo_ms) override {
+      if (_scheduler->onThread()) return _device->ReadROCRegister(link, address, tmo_ms);
+      return _scheduler->run(_priority, [=] { return _device->ReadROCRegister(link, address, tmo_ms); });
+    }
+
+    bool WriteROCRegister(DTCLib::DTC_Link_ID const& link, DTCLib::roc_address_t address, DTCLib::roc_data_t data,
+                          bool requestAck, int tmo_ms) override {
+      if (_scheduler->onThread()) return _device->WriteROCRegister(link, address, data, requestAck, tmo_ms);
+      return _scheduler->run(_priority, [=] { return _device->WriteROCRegister(link, address, data, requestAck, tmo_ms); });
+    }
+
+    uint32_t ReadRegister (DTCLib::DTC_Register const& address)                override { return _device->ReadRegister(address); }
+    void     WriteRegister(uint32_t data, DTCLib::DTC_Register const& address) override { _device->WriteRegister(data, address); }
+
+    void SendRequestForTimestamp(DTCLib::DTC_EventWindowTag const& tag, uint32_t heartbeatsAfter) override {
+      _device->SendRequestForTimestamp(tag, heartbeatsAfter);
+    }
+
+    void SendRequestsForRange(int count, DTCLib::DTC_EventWindowTag const& start, bool increment,
+                              uint32_t delayBetweenRequests, int requestsAhead, uint32_t heartbeatsAfter) override {
+      _device->SendRequestsForRange(count, start, increment, delayBetweenRequests, requestsAhead, heartbeatsAfter);
+    }
+
+    DtcDevice* device() const { return _device; }
+
+  private:
+    DtcDevice*                      _device;
+    TrackerDcsScheduler*            _scheduler;
+    TrackerDcsScheduler::Priority_t _priority;
+    bool                            _owner;
+  };
+}  // namespace mu2e
+
+#endif
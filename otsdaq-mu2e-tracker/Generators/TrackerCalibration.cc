@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// per-straw calibration constants, see TrackerCalibration.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerCalibration").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerCalibration.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerCalibration::TrackerCalibration(fhicl::ParameterSet const& ps) :
+    _defaultPedestal  (ps.get<float>      ("pedestal"   , 0.))
+  , _defaultGain      (ps.get<float>      ("gain"       , 1.))
+  , _defaultTimeOffset(ps.get<float>      ("time_offset", 0.))
+  , _file             (ps.get<std::string>("file"       , "")) {
+
+  setDefaults_();
+
+  for (auto const& t : ps.get<std::vector<fhicl::ParameterSet>>("links", std::vector<fhicl::ParameterSet>())) {
+    int link = t.get<int>("link");
+    if ((link < 0) or (link >= kNLinks)) {
+      TLOG(TLVL_WARNING) << "TrackerCalibration: link " << link << " out of range, ignored";
+      continue;
+    }
+
+    auto pedestal   = t.get<std::vector<float>>("pedestal"   , std::vector<float>());
+    auto gain       = t.get<std::vector<float>>("gain"       , std::vector<float>());
+    auto timeOffset = t.get<std::vector<float>>("time_offset", std::vector<float>());
+    auto masked     = t.get<std::vector<int>>  ("masked"     , std::vector<int>());
+
+    size_t k0 = index(link, 0);
+    std::copy_n(pedestal  .begin(), std::min(pedestal  .size(), size_t(kNChannels)), _pedestal  +k0);
+    std::copy_n(gain      .begin(), std::min(gain      .size(), size_t(kNChannels)), _gain      +k0);
+    std::copy_n(timeOffset.begin(), std::min(timeOffset.size(), size_t(kNChannels)), _timeOffset+k0);
+
+    for (int ch : masked) {
+      if ((ch >= 0) and (ch < kNChannels)) _masked[k0+ch] = 1;
+    }
+  }
+
+  if (_file != "") readFile_(_file);
+
+  TLOG(TLVL_INFO) << "TrackerCalibration: " << nMasked() << " masked channels"
+                  << ((_file != "") ? ", file: " : "") << _file;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerCalibration::setDefaults_() {
+  std::fill_n(_pedestal  , kNStraws, _defaultPedestal  );
+  std::fill_n(_gain      , kNStraws, _defaultGain      );
+  std::fill_n(_timeOffset, kNStraws, _defaultTimeOffset);
+  std::fill_n(_masked    , kNStraws, 0);
+}
+
+//-----------------------------------------------------------------------------
+// parsed into a copy first, a bad line doesn't leave half-updated tables
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerCalibration::readFile_(std::string const& Name) {
+  std::ifstream in(Name);
+  if (not in) {
+    TLOG(TLVL_WARNING) << "TrackerCalibration: can't open " << Name;
+    return false;
+  }
+
+  std::vector<float>   pedestal  (_pedestal  , _pedestal  +kNStraws);
+  std::vector<float>   gain      (_gain      , _gain      +kNStraws);
+  std::vector<float>   timeOffset(_timeOffset, _timeOffset+kNStraws);
+  std::vector<uint8_t> masked    (_masked    , _masked    +kNStraws);
+
+  std::string line;
+  int         nline = 0;
+  while (std::getline(in, line)) {
+    nline++;
+    if (line.empty() or (line[0] == '#')) continue;
+
+    std::istringstream s(line);
+    int   link, channel, mask;
+    float ped, g, t0;
+    if (not (s >> link >> channel >> ped >> g >> t0 >> mask) or
+        (link < 0) or (link >= kNLinks) or (channel < 0) or (channel >= kNChannels)) {
+      TLOG(TLVL_WARNING) << "TrackerCalibration: " << Name << ":" << nline << ": bad line, file ignored";
+      return false;
+    }
+
+    size_t k      = index(link, channel);
+    pedestal  [k] = ped;
+    gain      [k] = g;
+    timeOffset[k] = t0;
+    masked    [k] = (mask != 0);
+  }
+
+  std::copy(pedestal  .begin(), pedestal  .end(), _pedestal  );
+  std::copy(gain      .begin(), gain      .end(), _gain      );
+  std::copy(timeOffset.begin(), timeOffset.end(), _timeOffset);
+  std::copy(masked    .begin(), masked    .end(), _masked    );
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerCalibration::reload() {
+  if (_file == "") return true;
+
+  bool ok = readFile_(_file);
+  TLOG(TLVL_INFO) << "TrackerCalibration: reloaded " << _file << (ok ? "" : " FAILED") << ", " << nMasked() << " masked channels";
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerCalibration::nMasked() const {
+  return std::count(_masked, _masked+kNStraws, 1);
+}
@@ -0,0 +1,70 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerCalibration_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerCalibration_hh
+//-----------------------------------------------------------------------------
+// TrackerCalibration : per-straw constants used by TrackerHitDecoder -
+// pedestal (ADC counts per sample), gain, time offset (ns) and channel mask
+//
+// one ROC (panel) per DTC link, 96 straws per ROC. Each constant is a flat
+// array of kNLinks x kNChannels, index = link*kNChannels + channel, aligned to
+// a cache line, so the decoder applies a whole ROC block with plain indexing
+//
+// the tables come with the board reader configuration (generated from the
+// configuration tree); a file, if given, is re-read at each begin run and
+// overrides them
+//
+// calibration : {
+//   enabled     : false
+//   file        : ""           # lines: link channel pedestal gain time_offset masked
+//   pedestal    : 0.           # defaults for the channels not listed
+//   gain        : 1.
+//   time_offset : 0.
+//   links       : [ { link: 0  pedestal: [ ... ]  gain: [ ... ]  time_offset: [ ... ]  masked: [ 5, 17 ] } ]
+//   ...                        # decoder parameters, see TrackerHitDecoder.hh
+// }
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mu2e {
+  class TrackerCalibration {
+  public:
+    enum {
+      kNLinks    = 6,
+      kNChannels = 96,
+      kNStraws   = kNLinks*kNChannels
+    };
+
+    TrackerCalibration(fhicl::ParameterSet const& ps);
+                                        // re-reads the file, if any. Returns false on error,
+                                        // the tables are left as they were
+    bool   reload      ();
+
+    static size_t index(int Link, int Channel) { return Link*kNChannels+Channel; }
+
+    const float*   pedestal  () const { return _pedestal;   }
+    const float*   gain      () const { return _gain;       }
+    const float*   timeOffset() const { return _timeOffset; }
+    const uint8_t* masked    () const { return _masked;     }
+
+    size_t nMasked     () const;
+
+  private:
+    void   setDefaults_();
+    bool   readFile_   (std::string const& Name);
+
+    alignas(64) float   _pedestal  [kNStraws];
+    alignas(64) float   _gain      [kNStraws];
+    alignas(64) float   _timeOffset[kNStraws];
+    alignas(64) uint8_t _masked    [kNStraws];
+
+    float       _defaultPedestal;
+    float       _defaultGain;
+    float       _defaultTimeOffset;
+    std::string _file;
+  };
+}  // namespace mu2e
+
+#endif
@@ -0,0 +1,208 @@
+///////////////////////////////////////////////////////////////////////////////
+// DTC readout register sweep and profile, see TrackerDmaTuner.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerDmaTuner").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerDmaTuner.hh"
+#include "otsdaq-mu2e-tracker/Generators/DtcDevice.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <fstream>
+#include <iomanip>
+
+const uint16_t mu2e::TrackerDmaTuner::kAddress[kNRegisters] = { 0x9104, 0x9144, 0x91a8 };
+const char*    mu2e::TrackerDmaTuner::kName   [kNRegisters] = { "dma_transfer_length", "dtc_timeout", "ewm_delta_t" };
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerDmaTuner::TrackerDmaTuner(fhicl::ParameterSet const& Tuning, fhicl::ParameterSet const& Profile,
+                                       int FragmentId) :
+    _tuning            (Tuning.get<bool>       ("enabled"             , false))
+  , _settleReads       (Tuning.get<size_t>     ("settle_reads"        ,    16))
+  , _readsPerPoint     (Tuning.get<size_t>     ("reads_per_point"     ,  1000))
+  , _maxTimeoutFraction(Tuning.get<double>     ("max_timeout_fraction",  0.01))
+  , _maxLatency        (Tuning.get<double>     ("max_latency_us"      , 5000.))
+  , _profileFile       (Tuning.get<std::string>("profile_file"        ,    ""))
+  , _point             (0)
+  , _nReads            (0)
+  , _best              ()
+  , _applied           (false)
+  , _pointApplied      (false) {
+
+  if (_profileFile == "") _profileFile = "/tmp/TrackerVST_dtc_profile_" + std::to_string(FragmentId) + ".fcl";
+  if (_readsPerPoint == 0) _readsPerPoint = 1;
+
+  for (int r=0; r<kNRegisters; r++) {
+    _best.value[r] = Profile.get<int64_t>(kName[r], -1);
+    _current   [r] = -1;
+    _written   [r] = -1;
+  }
+//-----------------------------------------------------------------------------
+// all combinations, the first register changes slowest
+//-----------------------------------------------------------------------------
+  if (_tuning) {
+    _points.push_back(Point());
+    for (int r=0; r<kNRegisters; r++) {
+      std::vector<int64_t> values = Tuning.get<std::vector<int64_t>>(kName[r], std::vector<int64_t>());
+      if (values.empty()) values.push_back(-1);
+
+      std::vector<Point> points;
+      for (auto const& p : _points) {
+        for (int64_t v : values) {
+          points.push_back(p);
+          points.back().value[r] = v;
+        }
+      }
+      _points.swap(points);
+    }
+
+    TLOG(TLVL_INFO) << "DTC register tuning: " << _points.size() << " points, " << _readsPerPoint
+                    << " reads each, profile: " << _profileFile;
+  }
+}
+
+//-----------------------------------------------------------------------------
+// every call, writes only what changed since the last one
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDmaTuner::apply(DtcDevice* Device) {
+  if (not _applied) {
+    for (int r=0; r<kNRegisters; r++) _current[r] = Device->ReadRegister(DTCLib::DTC_Register(kAddress[r]));
+    _applied = true;
+  }
+
+  Point const& p = (_tuning) ? _points[_point] : _best;
+  for (int r=0; r<kNRegisters; r++) {
+    if ((p.value[r] < 0) or (p.value[r] == _written[r])) continue;
+    Device->WriteRegister(uint32_t(p.value[r]), DTCLib::DTC_Register(kAddress[r]));
+    _written[r] = p.value[r];
+  }
+
+  if (_tuning) _pointApplied = true;
+}
+
+//-----------------------------------------------------------------------------
+// the run configuration (monica_var_pattern_config) clears 0x91a8
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDmaTuner::invalidate() {
+  for (int r=0; r<kNRegisters; r++) _written[r] = -1;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDmaTuner::requestSent(size_t N) {
+  _sendTimes.insert(_sendTimes.end(), N, std::chrono::steady_clock::now());
+}
+
+//-----------------------------------------------------------------------------
+// requests are answered in order, as in TrackerRateController
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDmaTuner::readDone(size_t Sts, bool Timeout, double ReadSeconds) {
+  auto   now     = std::chrono::steady_clock::now();
+  double latency = 0;
+  if (not _sendTimes.empty()) {
+    latency = std::chrono::duration<double, std::micro>(now-_sendTimes.front()).count();
+    _sendTimes.pop_front();
+  }
+
+  if ((not _tuning) or (not _pointApplied)) return;
+
+  _nReads++;
+  if (_nReads <= _settleReads) return;
+
+  Point& p = _points[_point];
+  p.nReads     += 1;
+  p.nTimeouts  += ((Sts == 0) or Timeout);
+  p.bytes      += Sts;
+  p.sumLatency += latency;
+  p.seconds    += ReadSeconds;
+
+  if (p.nReads >= _readsPerPoint) next_();
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDmaTuner::next_() {
+  Point const& p = _points[_point];
+  TLOG(TLVL_INFO) << "DTC tuning point " << _point << " 0x9104=" << p.value[0] << " 0x9144=" << p.value[1]
+                  << " 0x91a8=" << p.value[2] << " : " << p.throughput()/1.e6 << " MB/s, latency "
+                  << p.meanLatencyUs() << " us, timeouts " << p.timeoutFraction();
+
+  _point++;
+  _nReads       = 0;
+  _pointApplied = false;
+  if (_point < _points.size()) return;
+//-----------------------------------------------------------------------------
+// done: keep the best point, registers not swept stay as they are
+//-----------------------------------------------------------------------------
+  _tuning = false;
+  _point  = best_();
+  _best   = _points[_point];
+
+  TLOG(TLVL_INFO) << "DTC tuning done, best point " << _point << ": 0x9104=" << _best.value[0]
+                  << " 0x9144=" << _best.value[1] << " 0x91a8=" << _best.value[2];
+  writeProfile(_profileFile);
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerDmaTuner::best_() const {
+  size_t best      = 0;
+  bool   qualified = false;
+
+  for (size_t i=0; i<_points.size(); i++) {
+    Point const& p  = _points[i];
+    Point const& b  = _points[best];
+    bool         ok = (p.timeoutFraction() <= _maxTimeoutFraction) and (p.meanLatencyUs() <= _maxLatency);
+
+    if (ok) {
+      if ((not qualified) or (p.throughput() > b.throughput())) best = i;
+      qualified = true;
+    }
+    else if ((not qualified) and (p.timeoutFraction() < b.timeoutFraction())) {
+      best = i;
+    }
+  }
+
+  if (not qualified) TLOG(TLVL_WARNING) << "no DTC tuning point within the limits, took the fewest timeouts";
+  return best;
+}
+
+//-----------------------------------------------------------------------------
+// all points as comments, the best one as the dtc_profile table
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerDmaTuner::writeProfile(std::string const& File) const {
+  std::ofstream out(File, std::ios::trunc);
+  if (not out) {
+    TLOG(TLVL_WARNING) << "can't open " << File;
+    return false;
+  }
+
+  out << "# DTC readout registers, TrackerVST dma_tuning" << std::endl;
+  out << "#" << std::endl;
+  out << "# point   0x9104     0x9144     0x91a8       MB/s   latency_us   timeouts" << std::endl;
+  for (size_t i=0; i<_points.size(); i++) {
+    Point const& p = _points[i];
+    out << "# " << std::setw(5) << i;
+    for (int r=0; r<kNRegisters; r++) {
+      if (p.value[r] >= 0) out << "  0x" << std::hex << std::setw(8) << std::setfill('0') << p.value[r]
+                               << std::dec << std::setfill(' ');
+      else                 out << "  " << std::setw(10) << "-";
+    }
+    out << std::fixed << std::setprecision(2) << std::setw(11) << p.throughput()/1.e6
+        << std::setw(13) << p.meanLatencyUs() << std::setprecision(4) << std::setw(11) << p.timeoutFraction()
+        << std::defaultfloat << std::endl;
+  }
+
+//-----------------------------------------------------------------------------
+// registers not swept: the value they had, so the profile is complete
+//-----------------------------------------------------------------------------
+  out << std::endl << "dtc_profile : {" << std::endl;
+  for (int r=0; r<kNRegisters; r++) {
+    int64_t v = (_best.value[r] >= 0) ? _best.value[r] : _current[r];
+    if (v < 0) continue;
+    out << "  " << std::left << std::setw(20) << kName[r] << std::right << ": " << std::setw(10) << v
+        << "   # 0x" << std::hex << kAddress[r] << " = 0x" << v << std::dec << std::endl;
+  }
+  out << "}" << std::endl;
+
+  TLOG(TLVL_INFO) << "DTC register profile written to " << File;
+  return bool(out);
+}
@@ -0,0 +1,113 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerDmaTuner_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerDmaTuner_hh
+//-----------------------------------------------------------------------------
+// TrackerDmaTuner : DTC readout registers for TrackerVST - DMA transfer length
+// (0x9104), DTC timeout (0x9144, 4 ns units) and EWM deltaT (0x91a8)
+//
+// - tuning : every combination of the listed values is a point. apply() writes
+//   the registers of the current point, the first settle_reads reads after a
+//   change are ignored, the next reads_per_point are measured: throughput
+//   (bytes over the time spent in the reads), request-to-read latency, timeout
+//   fraction. After the last point the best one is kept and written out as a
+//   profile
+// - best : the highest throughput with timeout fraction and latency within
+//   the limits; if no point qualifies, the lowest timeout fraction
+// - the profile is a FHiCL table to #include in the board reader config:
+//   with dtc_profile and no tuning, apply() writes the profile values
+// - a register with no values listed is never written (its current value goes
+//   into the profile). A register is written only when its value changes, or
+//   after invalidate(): the run configuration may have overwritten it
+//
+// dma_tuning : {
+//   enabled              : false
+//   dma_transfer_length  : []     # 0x9104 values to try
+//   dtc_timeout          : []     # 0x9144
+//   ewm_delta_t          : []     # 0x91a8
+//   settle_reads         : 16
+//   reads_per_point      : 1000
+//   max_timeout_fraction : 0.01
+//   max_latency_us       : 5000
+//   profile_file         : ""     # default: /tmp/TrackerVST_dtc_profile_<fragment_id>.fcl
+// }
+//
+// dtc_profile : { dma_transfer_length : .. dtc_timeout : .. ewm_delta_t : .. }
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+  class DtcDevice;
+
+  class TrackerDmaTuner {
+  public:
+    enum {
+      kDmaTransferLength = 0,
+      kDtcTimeout        = 1,
+      kEwmDeltaT         = 2,
+      kNRegisters        = 3
+    };
+
+    struct Point {
+      int64_t  value[kNRegisters];      // -1: not written
+      size_t   nReads;                  // measured ones
+      size_t   nTimeouts;
+      double   bytes;
+      double   seconds;                 // in the reads
+      double   sumLatency;              // us
+
+      double   throughput     () const { return (seconds > 0) ? bytes/seconds : 0; }
+      double   meanLatencyUs  () const { return (nReads > 0) ? sumLatency/nReads : 0; }
+      double   timeoutFraction() const { return (nReads > 0) ? nTimeouts/double(nReads) : 0; }
+    };
+
+    static const uint16_t kAddress[kNRegisters];
+    static const char*    kName   [kNRegisters];
+
+    TrackerDmaTuner(fhicl::ParameterSet const& Tuning, fhicl::ParameterSet const& Profile, int FragmentId);
+                                        // once per getNext_, before the requests
+    void   apply          (DtcDevice* Device);
+                                        // the registers were overwritten, apply() writes them again
+    void   invalidate     ();
+
+                                        // N requests sent at once (SendRequestsForRange)
+    void   requestSent    (size_t N = 1);
+    void   readDone       (size_t Sts, bool Timeout, double ReadSeconds);
+
+    bool   tuning         () const { return _tuning;        }
+    size_t point          () const { return _point;         }
+    size_t nPoints        () const { return _points.size(); }
+    Point const& best     () const { return _best;          }
+
+    bool   writeProfile   (std::string const& File) const;
+
+  private:
+    void   next_          ();
+    size_t best_          () const;
+
+    bool     _tuning;
+    size_t   _settleReads;
+    size_t   _readsPerPoint;
+    double   _maxTimeoutFraction;
+    double   _maxLatency;
+    std::string _profileFile;
+
+    std::vector<Point> _points;
+    size_t   _point;
+    size_t   _nReads;                   // since the current point was applied
+    Point    _best;                     // after tuning, or from dtc_profile
+    int64_t  _current[kNRegisters];     // read back on the first apply()
+    int64_t  _written[kNRegisters];     // -1: unknown, write on the next apply()
+    bool     _applied;
+    bool     _pointApplied;             // reads before it belong to the previous point
+
+    std::deque<std::chrono::steady_clock::time_point> _sendTimes;
+  };
+}  // namespace mu2e
+
+#endif
@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////////////
+// ring of recently read event windows, see TrackerEventCache.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerEventCache").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerEventCache.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerPlacement.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <algorithm>
+#include <cstring>
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerEventCache::TrackerEventCache(fhicl::ParameterSet const& ps, TrackerPlacement* Placement, size_t NSources) :
+    _placement(Placement)
+  , _nWindows (ps.get<size_t>("n_windows" ,  1024))
+  , _nSources (std::max<size_t>(NSources, 1))
+  , _slotBytes(ps.get<size_t>("slot_bytes", 65536))
+  , _maxAge   (ps.get<size_t>("max_age_ms",     0))
+  , _newestTag(_nSources, 0)
+  , _nInserted(0)
+  , _nTooLong (0) {
+
+  if (_nWindows == 0) _nWindows = 1;
+
+  _data = static_cast<uint8_t*>(_placement->allocate(_nWindows*_nSources*_slotBytes));
+  _slot.resize(_nWindows*_nSources, Slot{0, 0, time_point_t()});
+
+  TLOG(TLVL_INFO) << "TrackerEventCache: " << _nWindows << " windows x " << _nSources << " sources x "
+                  << _slotBytes << " bytes";
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerEventCache::~TrackerEventCache() {
+  _placement->deallocate(_data, _nWindows*_nSources*_slotBytes);
+}
+
+//-----------------------------------------------------------------------------
+// the slots of one window are next to each other, one per source
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerEventCache::insert(uint64_t Tag, const void* Data, size_t Size, int Source) {
+  if (Size > _slotBytes) {
+    _nTooLong++;
+    return false;
+  }
+
+  size_t i = (Tag % _nWindows)*_nSources + Source;
+  memcpy(_data+i*_slotBytes, Data, Size);
+
+  _slot[i].tag  = Tag;
+  _slot[i].size = Size;
+  _slot[i].time = std::chrono::steady_clock::now();
+
+  if (Tag > _newestTag[Source]) _newestTag[Source] = Tag;
+  _nInserted++;
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+const uint8_t* mu2e::TrackerEventCache::find(uint64_t Tag, size_t& Size, int Source) const {
+  size_t      i = (Tag % _nWindows)*_nSources + Source;
+  Slot const& s = _slot[i];
+
+  Size = 0;
+  if ((s.size == 0) or (s.tag != Tag)) return nullptr;
+
+  if ((_maxAge.count() > 0) and (std::chrono::steady_clock::now()-s.time > _maxAge)) return nullptr;
+
+  Size = s.size;
+  return _data + i*_slotBytes;
+}
+
+//-----------------------------------------------------------------------------
+uint64_t mu2e::TrackerEventCache::newestTag() const {
+  return *std::min_element(_newestTag.begin(), _newestTag.end());
+}
+
+//-----------------------------------------------------------------------------
+// a range longer than the ring can't be fully there, only its newest part is looked at
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerEventCache::findRange(uint64_t First, uint64_t Last, std::vector<Event_t>& Events) const {
+  Events.clear();
+  if (Last < First) return 0;
+
+  if (Last-First >= _nWindows) First = Last-_nWindows+1;
+
+  for (uint64_t tag=First; tag<=Last; tag++) {
+    for (size_t src=0; src<_nSources; src++) {
+      size_t         size;
+      const uint8_t* data = find(tag, size, src);
+      if (data) Events.emplace_back(data, size);
+    }
+  }
+
+  return Events.size();
+}
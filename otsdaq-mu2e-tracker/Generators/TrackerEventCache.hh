@@ -0,0 +1,81 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerEventCache_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerEventCache_hh
+//-----------------------------------------------------------------------------
+// TrackerEventCache : copies of the most recently read DTC events, indexed by
+// the event window tag. Direct-mapped ring: tag N lives in slot N % n_windows,
+// so insert and lookup are O(1) and a new window overwrites the one n_windows
+// older. Entries older than max_age_ms are reported as missing.
+// With several DTCs read by one TrackerVST (multi_dtc) each window has one
+// slot per DTC (Source), findRange returns the events of all of them.
+// Slot memory comes from TrackerPlacement (NUMA node of the DTC, hugepages)
+//
+// event_cache : {
+//   enabled        : false
+//   n_windows      : 1024
+//   slot_bytes     : 65536     # events longer than that are not cached
+//   max_age_ms     : 0         # 0: no time limit
+//   serve_requests : false     # build fragments from artdaq requests, see TrackerVST;
+//                              # needs window_recovery.enabled
+//   window_before  : 0         # windows served before/after the requested tag
+//   window_after   : 0
+// }
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace mu2e {
+  class TrackerPlacement;
+
+  class TrackerEventCache {
+  public:
+    TrackerEventCache(fhicl::ParameterSet const& ps, TrackerPlacement* Placement, size_t NSources = 1);
+    ~TrackerEventCache();
+
+    typedef std::pair<const uint8_t*, size_t> Event_t;
+
+    bool           insert     (uint64_t Tag, const void* Data, size_t Size, int Source = 0);
+                                        // nullptr if not there (evicted, too old or never read)
+    const uint8_t* find       (uint64_t Tag, size_t& Size, int Source = 0) const;
+                                        // events with First <= tag <= Last from all the sources, in tag
+                                        // then source order. Returns the number found
+    size_t         findRange  (uint64_t First, uint64_t Last, std::vector<Event_t>& Events) const;
+
+    bool           empty      () const { return _nInserted == 0; }
+                                        // newest tag all the sources have delivered
+    uint64_t       newestTag  () const;
+    size_t         nWindows   () const { return _nWindows;  }
+    size_t         nSources   () const { return _nSources;  }
+    size_t         slotBytes  () const { return _slotBytes; }
+    size_t         nInserted  () const { return _nInserted; }
+    size_t         nTooLong   () const { return _nTooLong;  }
+
+  private:
+    typedef std::chrono::steady_clock::time_point time_point_t;
+
+    struct Slot {
+      uint64_t     tag;
+      size_t       size;                // 0: empty
+      time_point_t time;
+    };
+
+    TrackerPlacement*  _placement;
+    size_t             _nWindows;
+    size_t             _nSources;
+    size_t             _slotBytes;
+    std::chrono::milliseconds _maxAge;
+
+    uint8_t*           _data;           // _nWindows x _nSources x _slotBytes
+    std::vector<Slot>  _slot;
+
+    std::vector<uint64_t> _newestTag;   // per source
+    size_t             _nInserted;
+    size_t             _nTooLong;
+  };
+}  // namespace mu2e
+
+#endif
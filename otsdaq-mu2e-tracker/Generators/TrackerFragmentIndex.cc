@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+// ROC block index of a mu2eFragment, see TrackerFragmentIndex.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerFragmentIndex").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerFragmentIndex.hh"
+
+#include "artdaq-core-mu2e/Overlays/mu2eFragment.hh"
+#include "dtcInterfaceLib/DTC.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DTCLib;
+
+//-----------------------------------------------------------------------------
+// walk the sub-events and their ROC blocks, stop at the first inconsistent
+// byte count. Returns the number of ROC blocks indexed
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerFragmentIndex::addEvent(const uint8_t* Event, size_t Offset, size_t Bytes) {
+  size_t n0 = _entries.size();
+
+  if (Bytes < sizeof(DTC_EventHeader)) return 0;
+
+  auto   eh  = reinterpret_cast<const DTC_EventHeader*>(Event);
+  size_t end = std::min(size_t(eh->inclusive_event_byte_count), Bytes);
+  size_t pos = sizeof(DTC_EventHeader);
+
+  while (pos + sizeof(DTC_SubEventHeader) <= end) {
+    auto   sh      = reinterpret_cast<const DTC_SubEventHeader*>(Event+pos);
+    size_t sub_end = pos + sh->inclusive_subevent_byte_count;
+    if ((sh->inclusive_subevent_byte_count == 0) or (sub_end > end)) {
+      TLOG(TLVL_DEBUG+1) << "bad sub-event byte count:" << sh->inclusive_subevent_byte_count << " at offset " << Offset+pos;
+      break;
+    }
+
+    size_t roc = pos + sizeof(DTC_SubEventHeader);
+    for (int i=0; (i<sh->num_rocs) and (roc+16 <= sub_end); i++) {
+//-----------------------------------------------------------------------------
+// ROC data header packet: byte count, valid|link|packet type, packet count, 48-bit EWT
+//-----------------------------------------------------------------------------
+      const uint16_t* w = reinterpret_cast<const uint16_t*>(Event+roc);
+      if ((w[0] < 16) or (roc+w[0] > sub_end)) break;
+
+      Entry e;
+      e.ewt    = uint64_t(w[3]) | (uint64_t(w[4]) << 16) | (uint64_t(w[5]) << 32);
+      e.offset = Offset+roc;
+      e.size   = w[0];
+      e.link   = (w[1] >> 8) & 0x7;
+      e.dtc    = sh->source_dtc_id;
+      _entries.push_back(e);
+
+      roc += w[0];
+    }
+
+    pos = sub_end;
+  }
+
+  return _entries.size()-n0;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerFragmentIndex::write(uint8_t* Dest) const {
+  Header h{kMagic, uint32_t(_entries.size())};
+  memcpy(Dest, &h, sizeof(h));
+  if (_entries.empty()) return;
+
+  memcpy(Dest+sizeof(h), _entries.data(), _entries.size()*sizeof(Entry));
+  Entry* e = reinterpret_cast<Entry*>(Dest+sizeof(h));
+  std::stable_sort(e, e+_entries.size(), [](Entry const& A, Entry const& B) { return A.ewt < B.ewt; });
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerFragmentIndexReader::TrackerFragmentIndexReader(mu2eFragment const& Frag) :
+    _dataBegin(Frag.dataBegin())
+  , _entries  (nullptr)
+  , _nEntries (0) {
+
+  size_t offset = TrackerFragmentIndex::indexOffset(Frag.dataEndBytes());
+  if (offset + sizeof(TrackerFragmentIndex::Header) > Frag.dataSize()) return;
+
+  auto h = reinterpret_cast<const TrackerFragmentIndex::Header*>(_dataBegin+offset);
+  if (h->magic != TrackerFragmentIndex::kMagic) return;
+  if (offset + sizeof(*h) + h->n_entries*sizeof(TrackerFragmentIndex::Entry) > Frag.dataSize()) return;
+
+  _entries  = reinterpret_cast<const TrackerFragmentIndex::Entry*>(h+1);
+  _nEntries = h->n_entries;
+}
+
+//-----------------------------------------------------------------------------
+// the entries are sorted by tag: the first block of the window, then its links
+//-----------------------------------------------------------------------------
+mu2e::TrackerFragmentIndex::Entry const* mu2e::TrackerFragmentIndexReader::find(uint64_t Ewt, int Link) const {
+  const TrackerFragmentIndex::Entry* end = _entries+_nEntries;
+  const TrackerFragmentIndex::Entry* e   = std::lower_bound(_entries, end, Ewt,
+                                             [](TrackerFragmentIndex::Entry const& E, uint64_t T) { return E.ewt < T; });
+
+  for (; (e != end) and (e->ewt == Ewt); e++) {
+    if (e->link == Link) return e;
+  }
+  return nullptr;
+}
@@ -0,0 +1,87 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerFragmentIndex_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerFragmentIndex_hh
+//-----------------------------------------------------------------------------
+// TrackerFragmentIndex : offsets of the ROC data blocks in a mu2eFragment
+//
+// TrackerVST packs several DTC events per fragment, one mu2eFragment block per
+// event. The index is written right after the last block (at dataEndBytes()
+// rounded up to 8 bytes, outside the block list, so the existing readers
+// don't see it):
+//
+//   Header : magic, number of entries
+//   Entry  : event window tag, byte offset and size of the ROC data block
+//            (data header packet included), link, source DTC ID
+//
+// offsets are counted from mu2eFragment::dataBegin(). The entries are written
+// in tag order (a re-requested window may come in late), so a monitor looking
+// at one panel finds its link with find(), a binary search, and decodes only
+// that block.
+//
+// TrackerVST : write_index : false  # default
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mu2e {
+  class mu2eFragment;
+
+  class TrackerFragmentIndex {
+  public:
+    enum { kMagic = 0x54524b49 };       // 'TRKI'
+                                        // where the index starts, from dataBegin()
+    static size_t indexOffset(size_t DataEndBytes) { return (DataEndBytes+7) & ~size_t(7); }
+
+    struct Header {
+      uint32_t magic;
+      uint32_t n_entries;
+    };
+
+    struct Entry {
+      uint64_t ewt;                     // event window tag, 48 bits used
+      uint32_t offset;                  // from mu2eFragment::dataBegin()
+      uint16_t size;                    // bytes, ROC data header packet included
+      uint8_t  link;
+      uint8_t  dtc;
+    };
+//-----------------------------------------------------------------------------
+// writer side: add the DTC events in the order they are added to the fragment
+//-----------------------------------------------------------------------------
+    void   clear     () { _entries.clear(); }
+                                        // Event: DTC event header, Offset: its offset in the fragment data
+    size_t addEvent  (const uint8_t* Event, size_t Offset, size_t Bytes);
+    size_t sizeBytes () const { return sizeof(Header) + _entries.size()*sizeof(Entry); }
+                                        // sorted by tag, the order of the blocks of a window is kept
+    void   write     (uint8_t* Dest) const;
+
+    std::vector<Entry> const& entries() const { return _entries; }
+
+  private:
+    std::vector<Entry> _entries;
+  };
+
+//-----------------------------------------------------------------------------
+// reader side, nothing is copied. valid() is false for fragments written
+// without an index
+//-----------------------------------------------------------------------------
+  class TrackerFragmentIndexReader {
+  public:
+    explicit TrackerFragmentIndexReader(mu2eFragment const& Frag);
+
+    bool           valid  () const { return _entries != nullptr; }
+    size_t         size   () const { return _nEntries; }
+
+    TrackerFragmentIndex::Entry const& entry(size_t I) const { return _entries[I]; }
+
+                                        // nullptr if the fragment has no such block
+    TrackerFragmentIndex::Entry const* find (uint64_t Ewt, int Link) const;
+    const uint8_t*                     data (TrackerFragmentIndex::Entry const& E) const { return _dataBegin + E.offset; }
+
+  private:
+    const uint8_t*                     _dataBegin;
+    const TrackerFragmentIndex::Entry* _entries;
+    size_t                             _nEntries;
+  };
+}  // namespace mu2e
+
+#endif
@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+// preallocated mu2eFragments, see TrackerFragmentPool.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerFragmentPool").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerFragmentPool.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerPlacement.hh"
+
+#include "artdaq-core-mu2e/Overlays/mu2eFragment.hh"
+#include "fhiclcpp/ParameterSet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerSizePredictor::TrackerSizePredictor(size_t MinBytes, double Alpha, double NSigma) :
+    _minBytes (MinBytes)
+  , _alpha    (Alpha)
+  , _nSigma   (NSigma)
+  , _mean     (0)
+  , _var      (0)
+  , _nObserved(0) {
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerSizePredictor::observe(size_t Bytes) {
+  if (_nObserved == 0) {
+    _mean = Bytes;
+    _var  = 0;
+  }
+  else {
+    double diff = Bytes-_mean;
+    _mean      += _alpha*diff;
+    _var        = (1-_alpha)*(_var+_alpha*diff*diff);
+  }
+  _nObserved++;
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerSizePredictor::predicted() const {
+  const size_t page = 4096;
+
+  size_t bytes = std::max(_minBytes, size_t(_mean+_nSigma*std::sqrt(_var)));
+  return ((bytes+page-1)/page)*page;
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerFragmentPool::TrackerFragmentPool(fhicl::ParameterSet const& ps,
+                                               artdaq::Fragment::fragment_id_t Id,
+                                               FragmentType Type) :
+    _id          (Id)
+  , _type        (Type)
+  , _depth       (ps.get<size_t>("depth"    ,     4))
+  , _prefault    (ps.get<bool>  ("prefault" , false))
+  , _hugePages   (false)
+  , _predictor   (ps.get<size_t>("min_bytes", 65536), ps.get<double>("alpha", 0.05), ps.get<double>("n_sigma", 3.))
+  , _lastCapacity(0)
+  , _nAllocated  (0)
+  , _nEmpty      (0)
+  , _nGrown      (0) {
+}
+
+//-----------------------------------------------------------------------------
+// capacity includes the mu2eFragment header (block index) written by mu2eFragmentWriter
+//-----------------------------------------------------------------------------
+artdaq::FragmentPtr mu2e::TrackerFragmentPool::allocate_(size_t Bytes) {
+  mu2eFragment::Metadata metadata;
+  memset(&metadata, 0, sizeof(metadata));
+
+  auto frag = artdaq::Fragment::FragmentBytes(Bytes, 0, _id, _type, metadata);
+  if (_hugePages) TrackerPlacement::adviseHugePages(frag->dataBeginBytes(), Bytes);
+  if (_prefault ) memset(frag->dataBeginBytes(), 0, Bytes);
+  frag->resizeBytes(0);
+
+  _nAllocated++;
+  return frag;
+}
+
+//-----------------------------------------------------------------------------
+artdaq::FragmentPtr mu2e::TrackerFragmentPool::get(artdaq::Fragment::sequence_id_t Seq) {
+  artdaq::FragmentPtr frag;
+
+  if (_free.empty()) {
+    _nEmpty++;
+    _lastCapacity = sizeof(mu2eFragment::Header) + _predictor.predicted();
+    frag          = allocate_(_lastCapacity);
+  }
+  else {
+    _lastCapacity = _free.back().capacity;
+    frag          = std::move(_free.back().frag);
+    _free.pop_back();
+  }
+
+  frag->setSequenceID(Seq);
+  return frag;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerFragmentPool::put(artdaq::FragmentPtr Frag) {
+  Frag->resizeBytes(0);
+  _free.push_back(Entry{std::move(Frag), _lastCapacity});
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerFragmentPool::freeBytes() const {
+  size_t n = 0;
+  for (Entry const& e : _free) n += e.capacity;
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerFragmentPool::observe(size_t Bytes) {
+  if (Bytes+sizeof(mu2eFragment::Header) > _lastCapacity) _nGrown++;
+  _predictor.observe(Bytes);
+}
+
+//-----------------------------------------------------------------------------
+// drop fragments which became too small for the predicted size, then top up
+//-----------------------------------------------------------------------------
+void mu2e::TrackerFragmentPool::refill() {
+  size_t capacity = sizeof(mu2eFragment::Header) + _predictor.predicted();
+
+  _free.erase(std::remove_if(_free.begin(), _free.end(),
+                             [capacity](Entry const& e) { return e.capacity < capacity; }),
+              _free.end());
+
+  while (_free.size() < _depth) {
+    _free.push_back(Entry{allocate_(capacity), capacity});
+  }
+}
@@ -0,0 +1,95 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerFragmentPool_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerFragmentPool_hh
+//-----------------------------------------------------------------------------
+// TrackerFragmentPool : preallocated mu2eFragments for TrackerVST
+//
+// - fragments are created ahead of time (refill(), called by the readout thread
+//   outside the readout loop, so the memory is local to it) with a payload
+//   capacity given by the size predictor, then shrunk to zero: artdaq::Fragment
+//   keeps its capacity, mu2eFragmentWriter::addSpace grows into it without a copy
+// - with prefault the payload is touched once so the pages are mapped ahead of
+//   the readout. That makes depth x predicted size resident, off by default
+// - an emitted fragment is trimmed to the bytes used
+// - a fragment which ends up empty goes back to the pool with put()
+// - emitted fragments belong to artdaq, their memory can't be recycled here
+//
+// TrackerSizePredictor : exponentially weighted mean and variance of the payload
+// size, prediction = mean + n_sigma*sigma rounded up to a page
+//
+// fragment_pool : {
+//   depth      : 4          # fragments kept ready
+//   min_bytes  : 65536      # lower limit on the predicted payload size
+//   alpha      : 0.05       # weight of the last observation
+//   n_sigma    : 3.
+//   prefault   : false
+// }
+//-----------------------------------------------------------------------------
+#include "artdaq-core/Data/Fragment.hh"
+#include "artdaq-core-mu2e/Overlays/FragmentType.hh"
+#include "fhiclcpp/fwd.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace mu2e {
+
+  class TrackerSizePredictor {
+  public:
+    TrackerSizePredictor(size_t MinBytes, double Alpha, double NSigma);
+
+    void   observe  (size_t Bytes);
+    size_t predicted() const;
+
+  private:
+    size_t _minBytes;
+    double _alpha;
+    double _nSigma;
+    double _mean;
+    double _var;
+    size_t _nObserved;
+  };
+
+  class TrackerFragmentPool {
+  public:
+    TrackerFragmentPool(fhicl::ParameterSet const& ps, artdaq::Fragment::fragment_id_t Id, FragmentType Type);
+
+                                        // payload size 0, capacity >= predicted size
+    artdaq::FragmentPtr get    (artdaq::Fragment::sequence_id_t Seq);
+    void                put    (artdaq::FragmentPtr Frag);
+                                        // final payload size of an emitted fragment
+    void                observe(size_t Bytes);
+    void                refill ();
+                                        // madvise the payloads for transparent hugepages
+    void                setHugePages(bool Flag) { _hugePages = Flag; }
+
+    size_t              predictedBytes() const { return _predictor.predicted(); }
+    size_t              nAllocated    () const { return _nAllocated; }
+    size_t              nEmpty        () const { return _nEmpty;     }
+    size_t              nGrown        () const { return _nGrown;     }
+                                        // payload capacity of the fragments in the pool
+    size_t              freeBytes     () const;
+
+  private:
+    artdaq::FragmentPtr allocate_(size_t Bytes);
+
+    artdaq::Fragment::fragment_id_t  _id;
+    FragmentType                     _type;
+    size_t                           _depth;
+    bool                             _prefault;
+    bool                             _hugePages;
+    TrackerSizePredictor             _predictor;
+
+    struct Entry {
+      artdaq::FragmentPtr frag;
+      size_t              capacity;
+    };
+    std::vector<Entry>               _free;
+    size_t                           _lastCapacity;   // capacity of the last fragment handed out
+
+    size_t                           _nAllocated;
+    size_t                           _nEmpty;          // get() found the pool empty
+    size_t                           _nGrown;          // fragments which outgrew their capacity
+  };
+}  // namespace mu2e
+
+#endif
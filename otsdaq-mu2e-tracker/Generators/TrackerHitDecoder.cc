@@ -0,0 +1,192 @@
+///////////////////////////////////////////////////////////////////////////////
+// straw hit decoding and calibration, see TrackerHitDecoder.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerHitDecoder").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerHitDecoder.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerCalibration.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+#include "dtcInterfaceLib/DTC.h"
+
+#include <algorithm>
+
+using namespace DTCLib;
+
+namespace {
+//-----------------------------------------------------------------------------
+// sum of up to N 10-bit samples packed from bit Pos of Data on, Bytes long.
+// A short hit stops at its last whole sample, NSummed is the number summed.
+// The samples go to Samples if given, the missing ones of a short hit are 0
+//-----------------------------------------------------------------------------
+  uint32_t adcSum(const uint8_t* Data, size_t Bytes, size_t Pos, int N, int& NSummed, uint16_t* Samples) {
+    uint32_t sum = 0;
+    NSummed      = 0;
+    for (; (NSummed < N) and (Pos+10 <= 8*Bytes); NSummed++, Pos+=10) {
+      size_t   byte = Pos >> 3;
+      uint32_t w    = Data[byte] | (Data[byte+1] << 8) | ((byte+2 < Bytes) ? (Data[byte+2] << 16) : 0);
+      uint32_t a    = (w >> (Pos & 0x7)) & 0x3ff;
+      sum += a;
+      if (Samples) Samples[NSummed] = a;
+    }
+    if (Samples) std::fill(Samples+NSummed, Samples+N, 0);
+    return sum;
+  }
+//-----------------------------------------------------------------------------
+// one entry per hit of the ROC block being decoded
+//-----------------------------------------------------------------------------
+  struct Scratch {
+    std::vector<uint16_t> index;
+    std::vector<uint32_t> tdc0;
+    std::vector<uint32_t> tdc1;
+    std::vector<uint32_t> adcSum;
+    std::vector<uint8_t>  nSummed;      // samples in adcSum, fewer than n_adc_samples if the hit is short
+    std::vector<uint16_t> flags;
+    std::vector<uint16_t> samples;      // n_adc_samples per hit, with waveforms only
+  };
+
+  thread_local Scratch scratch;
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerHitDecoder::TrackerHitDecoder(fhicl::ParameterSet const& ps, TrackerCalibration const* Calibration) :
+    _calibration (Calibration)
+  , _tdcLsb      (ps.get<float>("tdc_lsb_ns"   , 0.0390625))
+  , _nSamples    (ps.get<int>  ("n_adc_samples", 15))
+  , _minCharge   (ps.get<float>("min_charge"   , -1.e9))
+  , _nDecoded    (0)
+  , _nMasked     (0)
+  , _nBelowCharge(0)
+  , _nBadHits    (0) {
+}
+
+//-----------------------------------------------------------------------------
+// same walk as TrackerFragmentIndex::addEvent
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerHitDecoder::decode(const uint8_t* Event, size_t Bytes, std::vector<Hit>& Hits,
+                                       std::vector<uint16_t>* Waveforms) {
+  size_t nkept = 0;
+
+  if (Bytes < sizeof(DTC_EventHeader)) return 0;
+
+  auto   eh  = reinterpret_cast<const DTC_EventHeader*>(Event);
+  size_t end = std::min(size_t(eh->inclusive_event_byte_count), Bytes);
+  size_t pos = sizeof(DTC_EventHeader);
+
+  while (pos + sizeof(DTC_SubEventHeader) <= end) {
+    auto   sh      = reinterpret_cast<const DTC_SubEventHeader*>(Event+pos);
+    size_t sub_end = pos + sh->inclusive_subevent_byte_count;
+    if ((sh->inclusive_subevent_byte_count == 0) or (sub_end > end)) break;
+
+    size_t roc = pos + sizeof(DTC_SubEventHeader);
+    for (int i=0; (i<sh->num_rocs) and (roc+16 <= sub_end); i++) {
+      const uint16_t* w = reinterpret_cast<const uint16_t*>(Event+roc);
+      if ((w[0] < 16) or (roc+w[0] > sub_end)) break;
+
+      uint64_t ewt  = uint64_t(w[3]) | (uint64_t(w[4]) << 16) | (uint64_t(w[5]) << 32);
+      int      link = (w[1] >> 8) & 0x7;
+      if (link < TrackerCalibration::kNLinks) nkept += decodeBlock_(Event+roc+16, w[0]-16, link, ewt, Hits, Waveforms);
+
+      roc += w[0];
+    }
+
+    pos = sub_end;
+  }
+
+  return nkept;
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerHitDecoder::decodeBlock_(const uint8_t* Block, size_t Bytes, int Link, uint64_t Ewt,
+                                             std::vector<Hit>& Hits, std::vector<uint16_t>* Waveforms) {
+//-----------------------------------------------------------------------------
+// pass 1: unpack
+//-----------------------------------------------------------------------------
+  Scratch& s = scratch;
+  s.index.clear();
+  s.tdc0.clear();
+  s.tdc1.clear();
+  s.adcSum.clear();
+  s.nSummed.clear();
+  s.flags.clear();
+  s.samples.clear();
+
+  size_t pos = 0;
+  while (pos+16 <= Bytes) {
+    const uint16_t* w    = reinterpret_cast<const uint16_t*>(Block+pos);
+    size_t          size = 16*(1 + (w[5] & 0xf));
+    if (pos+size > Bytes) {
+      _nBadHits++;
+      break;
+    }
+
+    int channel = w[0] & 0x7f;
+    if (channel >= TrackerCalibration::kNChannels) {
+      _nBadHits++;
+      pos += size;
+      continue;
+    }
+
+    s.index .push_back(TrackerCalibration::index(Link, channel));
+    s.tdc0  .push_back(w[1] | ((w[2] & 0xff) << 16));
+    s.tdc1  .push_back(w[3] | ((w[4] & 0xff) << 16));
+    s.flags .push_back(w[4] >> 12);
+    uint16_t* samples = nullptr;
+    if (Waveforms) {
+      s.samples.resize(s.samples.size()+_nSamples);
+      samples = s.samples.data() + s.samples.size() - _nSamples;
+    }
+    int nsummed;
+    s.adcSum .push_back(adcSum(Block+pos, size, 94, _nSamples, nsummed, samples));
+    s.nSummed.push_back(nsummed);
+
+    pos += size;
+  }
+//-----------------------------------------------------------------------------
+// pass 2: calibrate the whole block
+//-----------------------------------------------------------------------------
+  size_t n = s.index.size();
+
+  const float*   pedestal   = _calibration->pedestal();
+  const float*   gain       = _calibration->gain();
+  const float*   timeOffset = _calibration->timeOffset();
+  const uint8_t* masked     = _calibration->masked();
+
+  size_t first = Hits.size();
+  Hits.resize(first+n);
+
+  size_t nkept   = 0;
+  size_t nmasked = 0;
+  size_t nbelow  = 0;
+  for (size_t i=0; i<n; i++) {
+    size_t k      = s.index[i];
+    Hit&   hit    = Hits[first+nkept];
+
+    hit.ewt       = Ewt;
+    hit.link      = Link;
+    hit.channel   = k - TrackerCalibration::index(Link, 0);
+    hit.flags     = s.flags[i];
+    hit.time[0]   = s.tdc0[i]*_tdcLsb - timeOffset[k];
+    hit.time[1]   = s.tdc1[i]*_tdcLsb - timeOffset[k];
+    hit.charge    = (s.adcSum[i] - s.nSummed[i]*pedestal[k])*gain[k];
+
+    bool belowCharge = hit.charge < _minCharge;
+    nmasked      += masked[k];
+    nbelow       += (belowCharge and not masked[k]);
+    bool keep     = (not masked[k]) and (not belowCharge);
+    nkept        += keep;
+
+    if (Waveforms and keep) {
+      const uint16_t* samples = s.samples.data() + i*_nSamples;
+      Waveforms->insert(Waveforms->end(), samples, samples+_nSamples);
+    }
+  }
+
+  Hits.resize(first+nkept);
+
+  _nDecoded     += n;
+  _nMasked      += nmasked;
+  _nBelowCharge += nbelow;
+  return nkept;
+}
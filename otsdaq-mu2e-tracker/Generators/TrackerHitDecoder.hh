@@ -0,0 +1,82 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerHitDecoder_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerHitDecoder_hh
+//-----------------------------------------------------------------------------
+// TrackerHitDecoder : decodes the straw hits of the DTC events read by
+// TrackerVST and calibrates them with TrackerCalibration
+//
+// a hit is one 16-byte packet plus NumADCPackets packets, 16-bit words of the
+// first one:
+//   [0]     : straw index, channel = bits [6:0]
+//   [1],[2] : TDC0[15:0], TDC0[23:16] | TOT0 << 8 | EWM counter << 12
+//   [3],[4] : TDC1[15:0], TDC1[23:16] | TOT1 << 8 | error flags << 12
+//   [5]     : NumADCPackets[3:0] | PMP[13:4], then the 10-bit ADC samples,
+//             packed from bit 94 of the hit on
+//
+// the charge is the sum of the first n_adc_samples samples minus the pedestal
+// of each sample summed: a hit too short for all of them gets the pedestal of
+// those it has
+//
+// each ROC block is done in two passes: the raw fields are unpacked into flat
+// scratch arrays, then the constants are applied to all hits of the block in
+// one loop, masked channels and hits below min_charge are dropped there
+//
+// decode() can be called from several threads at once: the scratch arrays are
+// per thread and the counters atomic. With Waveforms, the n_adc_samples ADC
+// samples of each kept hit are appended to it as well
+//
+// parameters, in the calibration table (see TrackerCalibration.hh):
+//   tdc_lsb_ns    : 0.0390625
+//   n_adc_samples : 15
+//   min_charge    : -1.e9      # calibrated ADC sum, lower ones are dropped
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mu2e {
+  class TrackerCalibration;
+
+  class TrackerHitDecoder {
+  public:
+    struct Hit {
+      uint64_t ewt;                     // event window tag
+      uint8_t  link;
+      uint8_t  channel;
+      uint16_t flags;                   // error flags of the hit
+      float    time[2];                 // ns, time offset subtracted
+      float    charge;                  // sum of the ADC samples above pedestal, times the gain
+    };
+
+    TrackerHitDecoder(fhicl::ParameterSet const& ps, TrackerCalibration const* Calibration);
+                                        // one DTC event, the calibrated hits are appended to Hits
+                                        // Returns the number of hits kept
+    size_t decode      (const uint8_t* Event, size_t Bytes, std::vector<Hit>& Hits,
+                        std::vector<uint16_t>* Waveforms = nullptr);
+
+    int    nSamples    () const { return _nSamples;  }
+
+    size_t nDecoded    () const { return _nDecoded;  }
+    size_t nMasked     () const { return _nMasked;   }
+    size_t nBelowCharge() const { return _nBelowCharge; }
+    size_t nBadHits    () const { return _nBadHits;  }
+
+  private:
+    size_t decodeBlock_(const uint8_t* Block, size_t Bytes, int Link, uint64_t Ewt, std::vector<Hit>& Hits,
+                        std::vector<uint16_t>* Waveforms);
+
+    TrackerCalibration const* _calibration;
+    float                     _tdcLsb;
+    int                       _nSamples;
+    float                     _minCharge;
+
+    std::atomic<size_t>       _nDecoded;
+    std::atomic<size_t>       _nMasked;
+    std::atomic<size_t>       _nBelowCharge;
+    std::atomic<size_t>       _nBadHits;      // truncated or channel out of range
+  };
+}  // namespace mu2e
+
+#endif
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// per-event-window latency records, see TrackerLatencyTracer.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerLatencyTracer").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerLatencyTracer.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <unordered_map>
+
+#include <unistd.h>
+
+namespace {
+  std::atomic<uint64_t> nextTracerId(1);
+
+  const char* stageName[mu2e::TrackerLatencyTracer::kNStages] = { "request", "dma", "build", "emit" };
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerLatencyTracer::TrackerLatencyTracer(fhicl::ParameterSet const& ps, int FragmentId) :
+    _id        (nextTracerId++)
+  , _outputFile(ps.get<std::string>("output_file", "")) {
+
+  size_t size = std::max(ps.get<size_t>("ring_size", 65536), size_t(2));
+  size_t n    = 1;
+  while (n < size) n <<= 1;
+  _mask = n-1;
+
+  if (_outputFile.empty()) {
+    _outputFile = "/tmp/TrackerVST_latency_" + std::to_string(FragmentId) + "_" + std::to_string(getpid()) + ".csv";
+  }
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerLatencyTracer::Ring* mu2e::TrackerLatencyTracer::addRing_() {
+  auto ring = std::make_unique<Ring>();
+  ring->records.resize(_mask+1);
+  ring->head = 0;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  ring->thread = _rings.size();
+  _rings.push_back(std::move(ring));
+
+  TLOG(TLVL_DEBUG) << "latency ring " << _rings.back()->thread << " added, " << _mask+1 << " records";
+  return _rings.back().get();
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerLatencyTracer::dump(std::string const& File) const {
+  std::vector<Record> all;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto const& ring : _rings) {
+      uint64_t head = ring->head.load(std::memory_order_acquire);
+      uint64_t n    = std::min<uint64_t>(head, _mask+1);
+      for (uint64_t i=head-n; i<head; i++) all.push_back(ring->records[i & _mask]);
+    }
+  }
+
+  std::sort(all.begin(), all.end(), [](Record const& a, Record const& b) { return a.time < b.time; });
+
+  std::ofstream out(File, std::ios::trunc);
+  if (not out) {
+    TLOG(TLVL_WARNING) << "can't open " << File;
+    return 0;
+  }
+
+  out << "ewt,stage,thread,t_ns\n";
+  for (auto const& r : all) out << r.ewt << "," << r.stage << "," << r.thread << "," << r.time << "\n";
+//-----------------------------------------------------------------------------
+// stage-to-stage latencies. Tags may repeat (TrackerVST restarts the tags each
+// getNext_ call), a new request record starts a new passage of the window
+//-----------------------------------------------------------------------------
+  typedef std::array<int64_t, kNStages> Times_t;
+
+  std::vector<Times_t>                  passages;
+  std::unordered_map<uint64_t, Times_t> current;
+
+  for (auto const& r : all) {
+    auto it = current.find(r.ewt);
+    if (it == current.end()) {
+      it = current.emplace(r.ewt, Times_t()).first;
+      it->second.fill(-1);
+    }
+    else if (r.stage == kRequest) {
+      passages.push_back(it->second);
+      it->second.fill(-1);
+    }
+    if (it->second[r.stage] < 0) it->second[r.stage] = r.time;
+  }
+  for (auto const& c : current) passages.push_back(c.second);
+
+  for (int s=1; s<kNStages; s++) {
+    std::vector<int64_t> dt;
+    for (auto const& t : passages) {
+      if ((t[s-1] >= 0) and (t[s] >= 0)) dt.push_back(t[s]-t[s-1]);
+    }
+    if (dt.empty()) continue;
+    std::sort(dt.begin(), dt.end());
+    TLOG(TLVL_INFO) << stageName[s-1] << " -> " << stageName[s] << " : N=" << dt.size()
+                    << " median=" << dt[dt.size()/2]/1000. << " us"
+                    << " 99%="    << dt[std::min(dt.size()-1, dt.size()*99/100)]/1000. << " us"
+                    << " max="    << dt.back()/1000. << " us";
+  }
+
+  TLOG(TLVL_INFO) << all.size() << " latency records written to " << File;
+  return all.size();
+}
@@ -0,0 +1,95 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerLatencyTracer_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerLatencyTracer_hh
+//-----------------------------------------------------------------------------
+// TrackerLatencyTracer : timestamps of each event window as it goes through
+// TrackerVST - data request sent, DMA read done, added to a fragment, fragment
+// emitted
+//
+// - record() is lock-free: every thread writes into its own ring (registered
+//   on first use), the oldest records are overwritten
+// - dump() writes all rings to a CSV file sorted by time, one line per record:
+//     ewt,stage,thread,t_ns
+//   (stage: 0 request, 1 dma, 2 build, 3 emit; t_ns: steady clock) and prints
+//   the median/99%/max stage-to-stage latencies. Records written while dumping
+//   may be torn, dump after the run (TrackerVST does it in stop())
+//
+// latency_trace : {
+//   enabled     : false
+//   ring_size   : 65536     # records per thread, rounded up to a power of 2
+//   output_file : ""        # default: /tmp/TrackerVST_latency_<fragment_id>_<pid>.csv
+// }
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+  class TrackerLatencyTracer {
+  public:
+    enum Stage_t {
+      kRequest = 0,
+      kDma     = 1,
+      kBuild   = 2,
+      kEmit    = 3,
+      kNStages = 4
+    };
+
+    struct Record {
+      uint64_t ewt;
+      int64_t  time;                    // ns
+      uint32_t stage;
+      uint32_t thread;
+    };
+
+    TrackerLatencyTracer(fhicl::ParameterSet const& ps, int FragmentId);
+
+    void   record   (Stage_t Stage, uint64_t Ewt) {
+      Ring*    ring = ring_();
+      uint64_t i    = ring->head.load(std::memory_order_relaxed);
+      Record&  r    = ring->records[i & _mask];
+      r.ewt    = Ewt;
+      r.time   = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+      r.stage  = Stage;
+      r.thread = ring->thread;
+      ring->head.store(i+1, std::memory_order_release);
+    }
+                                        // returns the number of records written
+    size_t dump     (std::string const& File) const;
+    size_t dump     () const { return dump(_outputFile); }
+
+  private:
+    struct Ring {
+      std::vector<Record>   records;
+      std::atomic<uint64_t> head;       // number of records written so far
+      uint32_t              thread;
+    };
+
+    Ring*  ring_    () {
+      thread_local uint64_t owner(0);
+      thread_local Ring*    ring (nullptr);
+      if (owner != _id) {
+        ring  = addRing_();
+        owner = _id;
+      }
+      return ring;
+    }
+
+    Ring*  addRing_ ();
+
+    uint64_t                           _id;      // unique per tracer, never reused
+    size_t                             _mask;
+    std::string                        _outputFile;
+
+    mutable std::mutex                 _mutex;   // protects _rings, taken once per thread
+    std::vector<std::unique_ptr<Ring>> _rings;
+  };
+}  // namespace mu2e
+
+#endif
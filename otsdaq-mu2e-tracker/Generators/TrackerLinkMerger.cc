@@ -0,0 +1,231 @@
+///////////////////////////////////////////////////////////////////////////////
+// k-way merge of the per-link ROC block streams, see TrackerLinkMerger.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerLinkMerger").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerLinkMerger.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DTCLib;
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerLinkMerger::TrackerLinkMerger(fhicl::ParameterSet const& ps) :
+    _links     (ps.get<std::vector<int>>("links"      , {0}))
+  , _timeout   (ps.get<int>             ("timeout_ms" , 100))
+  , _maxPending(ps.get<size_t>          ("max_pending", 256)) {
+
+  _links.erase(std::remove_if(_links.begin(), _links.end(), [](int L) { return (L < 0) or (L >= kMaxLinks); }),
+               _links.end());
+  std::sort(_links.begin(), _links.end());
+  _links.erase(std::unique(_links.begin(), _links.end()), _links.end());
+
+  clear();
+  _nMerged        = 0;
+  _nIncomplete    = 0;
+  _nMissingBlocks = 0;
+  _nLateBlocks    = 0;
+
+  TLOG(TLVL_INFO) << "TrackerLinkMerger: " << _links.size() << " links, timeout_ms=" << _timeout.count()
+                  << " max_pending=" << _maxPending;
+}
+
+//-----------------------------------------------------------------------------
+// the event window tags may start over after clear(), the counters don't
+//-----------------------------------------------------------------------------
+void mu2e::TrackerLinkMerger::clear() {
+  _streams.clear();
+  _heap = decltype(_heap)();
+  _windows.clear();
+  _dtcs.clear();
+  _queuedBytes = 0;
+  _sent        = false;
+  _lastTag     = 0;
+  _lastMissing = 0;
+}
+
+//-----------------------------------------------------------------------------
+// a stream is in EWT order; a block at its head goes on the heap. A second
+// block for the same window and link is dropped
+//-----------------------------------------------------------------------------
+void mu2e::TrackerLinkMerger::queue_(int Stream, uint64_t Ewt, const uint8_t* Data, size_t Bytes) {
+  std::deque<Block>& q = _streams[Stream];
+
+  auto pos = std::lower_bound(q.begin(), q.end(), Ewt, [](Block const& B, uint64_t T) { return B.ewt < T; });
+  if ((pos != q.end()) and (pos->ewt == Ewt)) {
+    _nLateBlocks++;
+    return;
+  }
+
+  bool head = (pos == q.begin());
+  q.insert(pos, Block{Ewt, std::vector<uint8_t>(Data, Data+Bytes)});
+  _queuedBytes += Bytes;
+  if (head) _heap.push(HeapEntry_t(Ewt, Stream));
+}
+
+//-----------------------------------------------------------------------------
+// same walk as TrackerFragmentIndex::addEvent, stops at the first
+// inconsistent byte count
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerLinkMerger::add(const uint8_t* Event, size_t Bytes, time_point_t Now) {
+  if (Bytes < sizeof(DTC_EventHeader)) return 0;
+
+  auto   eh  = reinterpret_cast<const DTC_EventHeader*>(Event);
+  size_t end = std::min(size_t(eh->inclusive_event_byte_count), Bytes);
+  size_t pos = sizeof(DTC_EventHeader);
+  size_t n   = 0;
+
+  while (pos + sizeof(DTC_SubEventHeader) <= end) {
+    auto   sh      = reinterpret_cast<const DTC_SubEventHeader*>(Event+pos);
+    size_t sub_end = pos + sh->inclusive_subevent_byte_count;
+    if ((sh->inclusive_subevent_byte_count == 0) or (sub_end > end)) break;
+
+    int dtc = sh->source_dtc_id;
+    auto d  = std::lower_bound(_dtcs.begin(), _dtcs.end(), dtc);
+    if ((d == _dtcs.end()) or (*d != dtc)) _dtcs.insert(d, dtc);
+
+    size_t roc = pos + sizeof(DTC_SubEventHeader);
+    for (int i=0; (i<sh->num_rocs) and (roc+16 <= sub_end); i++) {
+      const uint16_t* w = reinterpret_cast<const uint16_t*>(Event+roc);
+      if ((w[0] < 16) or (roc+w[0] > sub_end)) break;
+
+      uint64_t ewt  = uint64_t(w[3]) | (uint64_t(w[4]) << 16) | (uint64_t(w[5]) << 32);
+      int      link = (w[1] >> 8) & 0x7;
+
+      if (_sent and (ewt <= _lastTag)) {
+        _nLateBlocks++;
+      }
+      else {
+        size_t nlate = _nLateBlocks;
+        queue_((dtc << 3) | link, ewt, Event+roc, w[0]);
+        if (_nLateBlocks == nlate) {
+          auto win = _windows.find(ewt);
+          if (win == _windows.end()) win = _windows.emplace(ewt, Window{Now, *eh, {}}).first;
+          win->second.sub.emplace(dtc, *sh);
+          n++;
+        }
+      }
+      roc += w[0];
+    }
+    pos = sub_end;
+  }
+
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+// Tag is the oldest window queued: the streams not empty are past it or at it
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerLinkMerger::ready_(uint64_t Tag, time_point_t Now, bool Flush) {
+  if (Flush or (_windows.size() > _maxPending)) return true;
+  if (Now - _windows[Tag].first >= _timeout)    return true;
+
+  for (int dtc : _dtcs) {
+    for (int link : _links) {
+      auto s = _streams.find((dtc << 3) | link);
+      if ((s == _streams.end()) or s->second.empty()) return false;
+    }
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerLinkMerger::next(std::vector<uint8_t>& Buffer, bool Flush, time_point_t Now) {
+//-----------------------------------------------------------------------------
+// an entry is stale if its block is no longer at the head of the stream
+//-----------------------------------------------------------------------------
+  while (not _heap.empty()) {
+    auto const& top = _heap.top();
+    auto const& q   = _streams[top.second];
+    if ((not q.empty()) and (q.front().ewt == top.first)) break;
+    _heap.pop();
+  }
+  if (_heap.empty()) return false;
+
+  uint64_t tag = _heap.top().first;
+  if (not ready_(tag, Now, Flush)) return false;
+
+  std::map<int, Block> blocks;          // by stream: DTC, then link order
+  while ((not _heap.empty()) and (_heap.top().first == tag)) {
+    int s = _heap.top().second;
+    _heap.pop();
+
+    std::deque<Block>& q = _streams[s];
+    if (q.empty() or (q.front().ewt != tag)) continue;
+    _queuedBytes -= q.front().data.size();
+    blocks[s]     = std::move(q.front());
+    q.pop_front();
+    if (not q.empty()) _heap.push(HeapEntry_t(q.front().ewt, s));
+  }
+//-----------------------------------------------------------------------------
+// DMA byte count, DTC event header, then one sub-event per DTC seen
+//-----------------------------------------------------------------------------
+  Window const& win = _windows[tag];
+  int missing = 0;
+
+  Buffer.clear();
+  Buffer.resize(8 + sizeof(DTC_EventHeader));
+
+  for (int dtc : _dtcs) {
+    size_t sub_pos = Buffer.size();
+    Buffer.resize(sub_pos + sizeof(DTC_SubEventHeader));
+
+    DTC_SubEventHeader sh;
+    auto sub = win.sub.find(dtc);
+    if (sub != win.sub.end()) sh = sub->second;
+    else {
+      memset(&sh, 0, sizeof(sh));
+      sh.source_dtc_id  = dtc;
+      sh.event_tag_low  = tag & 0xffffffff;
+      sh.event_tag_high = (tag >> 32) & 0xffff;
+    }
+
+    int nrocs = 0;
+    for (int link=0; link<kMaxLinks; link++) {
+      auto b = blocks.find((dtc << 3) | link);
+      if (b != blocks.end()) {
+        Buffer.insert(Buffer.end(), b->second.data.begin(), b->second.data.end());
+        nrocs++;
+      }
+      else if (std::binary_search(_links.begin(), _links.end(), link)) {
+//-----------------------------------------------------------------------------
+// missing link: ROC data header with no packets and the valid bit clear
+//-----------------------------------------------------------------------------
+        uint16_t w[8] = {16, uint16_t((link << 8) | (5 << 4)), 0,
+                         uint16_t(tag), uint16_t(tag >> 16), uint16_t(tag >> 32), 0, 0};
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(w);
+        Buffer.insert(Buffer.end(), p, p+sizeof(w));
+        nrocs++;
+        missing++;
+      }
+    }
+
+    sh.num_rocs                      = nrocs;
+    sh.inclusive_subevent_byte_count = Buffer.size() - sub_pos;
+    memcpy(Buffer.data()+sub_pos, &sh, sizeof(sh));
+  }
+
+  DTC_EventHeader eh = win.header;
+  eh.inclusive_event_byte_count = Buffer.size() - 8;
+  memcpy(Buffer.data()+8, &eh, sizeof(eh));
+
+  uint64_t nbytes = Buffer.size() - 8;
+  memcpy(Buffer.data(), &nbytes, sizeof(nbytes));
+
+  _windows.erase(tag);
+  _sent        = true;
+  _lastTag     = tag;
+  _lastMissing = missing;
+  _nMerged++;
+  if (missing > 0) {
+    _nIncomplete++;
+    _nMissingBlocks += missing;
+    TLOG(TLVL_DEBUG+1) << "event window " << tag << " sent with " << missing << " links missing";
+  }
+
+  return true;
+}
@@ -0,0 +1,111 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerLinkMerger_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerLinkMerger_hh
+//-----------------------------------------------------------------------------
+// TrackerLinkMerger : time-ordered merge of the per-link ROC block streams
+// into one DTC event per event window
+//
+// with more than one link read out, the ROC blocks of a window can come in
+// different DMA buffers, and the links get out of step. add() splits a DTC
+// event into its ROC blocks and queues them per (DTC, link) stream, in event
+// window tag (EWT) order. next() is a k-way merge: a min-heap keyed by the EWT
+// at the head of each stream gives the oldest window, which goes out when
+//
+// - every expected stream has a block for it, or has a later one already
+//   (the streams are ordered, that link won't send it any more), or
+// - timeout_ms went by since its first block came in, or
+// - more than max_pending windows are waiting, or the caller flushes
+//
+// the output has the layout of a DMA buffer (8-byte byte count, DTC event
+// header, one sub-event per DTC, its ROC blocks in link order) and goes into
+// the fragment the same way a DMA buffer does. An expected link without a
+// block gets an empty ROC data header (no packets, valid bit clear) so the
+// event builders see which links are missing; nMissingBlocks() counts them.
+// Blocks for a window already sent are dropped and counted as late
+//
+// link_merge : {
+//   enabled     : false
+//   links       : [ 0 ]      # expected links of every DTC seen
+//   timeout_ms  : 100
+//   max_pending : 256        # windows
+// }
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include "dtcInterfaceLib/DTC.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace mu2e {
+  class TrackerLinkMerger {
+  public:
+    typedef std::chrono::steady_clock::time_point time_point_t;
+
+    enum { kMaxLinks = 8 };             // stream key: (DTC ID << 3) | link
+
+    TrackerLinkMerger(fhicl::ParameterSet const& ps);
+                                        // Event: DTC event without the DMA byte count.
+                                        // Returns the number of ROC blocks queued
+    size_t   add           (const uint8_t* Event, size_t Bytes, time_point_t Now = std::chrono::steady_clock::now());
+                                        // the oldest window if it is ready, false if none is
+    bool     next          (std::vector<uint8_t>& Buffer, bool Flush = false,
+                            time_point_t Now = std::chrono::steady_clock::now());
+    void     clear         ();
+
+    size_t   nPending      () const { return _windows.size(); }
+                                        // ROC blocks waiting in the streams
+    size_t   queuedBytes   () const { return _queuedBytes;    }
+    uint64_t lastTag       () const { return _lastTag;        }
+                                        // of the last window sent
+    int      lastMissing   () const { return _lastMissing;    }
+
+    size_t   nMerged       () const { return _nMerged;        }
+    size_t   nIncomplete   () const { return _nIncomplete;    }
+    size_t   nMissingBlocks() const { return _nMissingBlocks; }
+    size_t   nLateBlocks   () const { return _nLateBlocks;    }
+
+  private:
+    struct Block {
+      uint64_t             ewt;
+      std::vector<uint8_t> data;
+    };
+
+    struct Window {
+      time_point_t                            first;        // its first block came in
+      DTCLib::DTC_EventHeader                 header;
+      std::map<int, DTCLib::DTC_SubEventHeader> sub;        // by DTC ID
+    };
+
+    typedef std::pair<uint64_t, int> HeapEntry_t;            // EWT at the head, stream
+
+    bool     ready_        (uint64_t Tag, time_point_t Now, bool Flush);
+    void     queue_        (int Stream, uint64_t Ewt, const uint8_t* Data, size_t Bytes);
+
+    std::vector<int>                  _links;
+    std::chrono::milliseconds         _timeout;
+    size_t                            _maxPending;
+
+    std::map<int, std::deque<Block>>  _streams;
+    std::priority_queue<HeapEntry_t, std::vector<HeapEntry_t>, std::greater<HeapEntry_t>> _heap;
+    std::map<uint64_t, Window>        _windows;                  // waiting to go out
+    std::vector<int>                  _dtcs;                     // seen since clear()
+    size_t                            _queuedBytes;
+    bool                              _sent;                     // _lastTag is valid
+    uint64_t                          _lastTag;
+    int                               _lastMissing;
+
+    size_t                            _nMerged;
+    size_t                            _nIncomplete;
+    size_t                            _nMissingBlocks;
+    size_t                            _nLateBlocks;
+  };
+}  // namespace mu2e
+
+#endif
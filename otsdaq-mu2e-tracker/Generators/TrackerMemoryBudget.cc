@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// memory held by the readout stages, see TrackerMemoryBudget.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerMemoryBudget").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerMemoryBudget.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerMemoryBudget::TrackerMemoryBudget(fhicl::ParameterSet const& ps) :
+    _limit         (ps.get<size_t>("limit_bytes"  ,   0))
+  , _total         (0)
+  , _totalHighWater(0)
+  , _full          (false)
+  , _nFull         (0)
+  , _nDeferred     (0) {
+
+  double high = std::clamp(ps.get<double>("high_fraction", 0.9), 0., 1.);
+  double low  = std::clamp(ps.get<double>("low_fraction" , 0.7), 0., high);
+  _high = size_t(high*_limit);
+  _low  = size_t(low *_limit);
+
+  for (int i=0; i<kNStages; i++) {
+    _used     [i] = 0;
+    _highWater[i] = 0;
+  }
+
+  if (_limit > 0) {
+    TLOG(TLVL_INFO) << "TrackerMemoryBudget: limit_bytes=" << _limit << " full above " << _high
+                    << " bytes, until below " << _low;
+  }
+}
+
+//-----------------------------------------------------------------------------
+const char* mu2e::TrackerMemoryBudget::stageName(int Stage) {
+  static const char* name[kNStages] = {"DMA Buffers", "Link Merger", "Fragments", "Event Cache"};
+  return name[Stage];
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerMemoryBudget::reserve(int Stage, size_t Bytes) {
+  _used[Stage] += Bytes;
+  _total       += Bytes;
+  update_(Stage);
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerMemoryBudget::release(int Stage, size_t Bytes) {
+  Bytes         = std::min(Bytes, _used[Stage]);
+  _used[Stage] -= Bytes;
+  _total       -= Bytes;
+  update_(Stage);
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerMemoryBudget::set(int Stage, size_t Bytes) {
+  _total        = _total - _used[Stage] + Bytes;
+  _used[Stage]  = Bytes;
+  update_(Stage);
+}
+
+//-----------------------------------------------------------------------------
+// hysteresis: full above the high mark, not full again down to the low one
+//-----------------------------------------------------------------------------
+void mu2e::TrackerMemoryBudget::update_(int Stage) {
+  _highWater[Stage] = std::max(_highWater[Stage], _used[Stage]);
+  _totalHighWater   = std::max(_totalHighWater  , _total);
+
+  if (_limit == 0) return;
+
+  if ((not _full) and (_total > _high)) {
+    _full = true;
+    _nFull++;
+    TLOG(TLVL_DEBUG+1) << "memory budget full: " << _total << " bytes used, " << stageName(Stage) << " "
+                       << _used[Stage];
+  }
+  else if (_full and (_total <= _low)) {
+    _full = false;
+  }
+}
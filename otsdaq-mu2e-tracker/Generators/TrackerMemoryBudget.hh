@@ -0,0 +1,70 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerMemoryBudget_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerMemoryBudget_hh
+//-----------------------------------------------------------------------------
+// TrackerMemoryBudget : bytes held by the stages of the TrackerVST readout,
+// checked against one limit
+//
+// a stage reports what it holds either as it goes (reserve/release: the DMA
+// buffers read and not released yet) or as a total (set: the link merger
+// queues, the fragments, the event cache). The budget is full once the sum
+// goes above high_fraction*limit_bytes, and stays full until it drops to
+// low_fraction*limit_bytes. While it is full TrackerVST
+// - sends a data request only when none is in flight
+// - releases a DMA buffer as soon as its task is done
+// limit_bytes=0 : no limit, the usage and high-water marks are only recorded.
+// Not thread safe, used on the getNext_ thread
+//
+// memory_budget : {
+//   limit_bytes   : 0
+//   high_fraction : 0.9
+//   low_fraction  : 0.7
+// }
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include <cstddef>
+
+namespace mu2e {
+  class TrackerMemoryBudget {
+  public:
+    enum Stage_t { kDmaBuffers, kLinkMerger, kFragments, kEventCache, kNStages };
+
+    explicit TrackerMemoryBudget(fhicl::ParameterSet const& ps);
+
+    void   reserve       (int Stage, size_t Bytes);
+    void   release       (int Stage, size_t Bytes);
+    void   set           (int Stage, size_t Bytes);
+                                        // a data request held back while full
+    void   requestDeferred()        { _nDeferred++; }
+
+    bool   full          () const { return _full;             }
+    size_t limitBytes    () const { return _limit;            }
+    size_t used          () const { return _total;            }
+    size_t used          (int Stage) const { return _used[Stage];      }
+    size_t highWater     () const { return _totalHighWater;   }
+    size_t highWater     (int Stage) const { return _highWater[Stage]; }
+                                        // times the budget became full
+    size_t nFull         () const { return _nFull;            }
+    size_t nDeferred     () const { return _nDeferred;        }
+
+    static const char* stageName(int Stage);
+
+  private:
+    void   update_       (int Stage);
+
+    size_t _limit;
+    size_t _high;                       // bytes
+    size_t _low;
+
+    size_t _used     [kNStages];
+    size_t _highWater[kNStages];
+    size_t _total;
+    size_t _totalHighWater;
+    bool   _full;
+
+    size_t _nFull;
+    size_t _nDeferred;
+  };
+}  // namespace mu2e
+
+#endif
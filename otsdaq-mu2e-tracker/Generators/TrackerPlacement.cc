@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+// thread pinning and NUMA-local memory, see TrackerPlacement.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerPlacement").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerPlacement.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+  const int kMpolPreferred = 1;         // from linux/mempolicy.h
+  const int kMpolBind      = 2;
+  const int kMaxNodes      = 64;
+  const size_t kHugePage   = 2*1024*1024;
+
+  const char* roleName[] = { "readout", "request", "build" };
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerPlacement::TrackerPlacement(fhicl::ParameterSet const& ps, int DtcId) :
+    _numaNode  (ps.get<int> ("numa_node"  ,    -1))
+  , _bindMemory(ps.get<bool>("bind_memory",  true))
+  , _hugePages (ps.get<bool>("hugepages"  , false)) {
+
+  _cores[kReadout] = ps.get<std::vector<int>>("readout_cores", std::vector<int>());
+  _cores[kRequest] = ps.get<std::vector<int>>("request_cores", std::vector<int>());
+  _cores[kBuild  ] = ps.get<std::vector<int>>("build_cores"  , std::vector<int>());
+
+  if (_numaNode < 0) _numaNode = dtcNumaNode(DtcId);
+
+  TLOG(TLVL_INFO) << "TrackerPlacement: DTC " << DtcId << " NUMA node=" << _numaNode
+                  << " bind_memory=" << _bindMemory << " hugepages=" << _hugePages;
+}
+
+//-----------------------------------------------------------------------------
+// -1 if unknown (single-socket machines report -1 as well)
+//-----------------------------------------------------------------------------
+int mu2e::TrackerPlacement::dtcNumaNode(int DtcId) {
+  if (DtcId < 0) {
+    const char* env = getenv("DTCLIB_DTC");
+    DtcId = (env != nullptr) ? atoi(env) : 0;
+  }
+
+  std::ifstream in("/sys/class/mu2e/mu2e" + std::to_string(DtcId) + "/device/numa_node");
+  int node = -1;
+  if (in) in >> node;
+  return node;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerPlacement::pinCurrentThread(Role_t Role) {
+  std::vector<int> const& cores = _cores[Role];
+
+  if (not cores.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int core : cores) CPU_SET(core, &set);
+
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+      TLOG(TLVL_WARNING) << "failed to pin the " << roleName[Role] << " thread: " << strerror(rc);
+    }
+    else {
+      TLOG(TLVL_INFO) << roleName[Role] << " thread pinned to " << cores.size() << " core(s), first: " << cores[0];
+    }
+  }
+
+  if (_bindMemory and (_numaNode >= 0) and (_numaNode < kMaxNodes)) {
+    unsigned long mask = 1UL << _numaNode;
+    if (syscall(SYS_set_mempolicy, kMpolPreferred, &mask, kMaxNodes+1) != 0) {
+      TLOG(TLVL_WARNING) << "set_mempolicy(node " << _numaNode << ") failed: " << strerror(errno);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerPlacement::adviseHugePages(void* Ptr, size_t Bytes) {
+  const uintptr_t page  = sysconf(_SC_PAGESIZE);
+  uintptr_t       begin = (reinterpret_cast<uintptr_t>(Ptr)+page-1) & ~(page-1);
+  uintptr_t       end   = (reinterpret_cast<uintptr_t>(Ptr)+Bytes)  & ~(page-1);
+
+  if (end > begin) madvise(reinterpret_cast<void*>(begin), end-begin, MADV_HUGEPAGE);
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerPlacement::mapSize_(size_t Bytes) const {
+  return _hugePages ? ((Bytes+kHugePage-1)/kHugePage)*kHugePage : Bytes;
+}
+
+//-----------------------------------------------------------------------------
+void* mu2e::TrackerPlacement::allocate(size_t Bytes) {
+  void* ptr = MAP_FAILED;
+
+  Bytes = mapSize_(Bytes);
+
+  if (_hugePages) {
+    ptr = mmap(nullptr, Bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr == MAP_FAILED) {
+      TLOG(TLVL_DEBUG) << "MAP_HUGETLB failed for " << Bytes << " bytes, using transparent hugepages";
+    }
+  }
+
+  if (ptr == MAP_FAILED) {
+    ptr = mmap(nullptr, Bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) throw std::bad_alloc();
+    if (_hugePages) adviseHugePages(ptr, Bytes);
+  }
+
+  if (_bindMemory and (_numaNode >= 0) and (_numaNode < kMaxNodes)) {
+    unsigned long mask = 1UL << _numaNode;
+    if (syscall(SYS_mbind, ptr, Bytes, kMpolBind, &mask, kMaxNodes+1, 0) != 0) {
+      TLOG(TLVL_WARNING) << "mbind(node " << _numaNode << ") failed: " << strerror(errno);
+    }
+  }
+
+  return ptr;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerPlacement::deallocate(void* Ptr, size_t Bytes) {
+  if (Ptr != nullptr) munmap(Ptr, mapSize_(Bytes));
+}
@@ -0,0 +1,64 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerPlacement_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerPlacement_hh
+//-----------------------------------------------------------------------------
+// TrackerPlacement : CPU and memory placement for the TrackerVST threads
+//
+// - a thread pins itself to the cores configured for its role and sets its
+//   memory policy to 'preferred' on the NUMA node of the DTC, so everything it
+//   allocates (fragments included) lands next to the card
+// - staging memory : allocate()/deallocate(), mmap'ed and bound to the node,
+//   backed by hugepages if requested and available (MAP_HUGETLB, otherwise
+//   transparent hugepages through madvise)
+// - the DTC node is read from sysfs, /sys/class/mu2e/mu2e<N>/device/numa_node
+//
+// placement : {
+//   readout_cores : []      # getNext_ thread
+//   request_cores : []      # threads sending data requests
+//   build_cores   : []      # threads building/processing fragments
+//   numa_node     : -1      # -1: the node of the DTC PCIe slot
+//   bind_memory   : true
+//   hugepages     : false
+// }
+// no NUMA library is needed, the two system calls are issued directly
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace mu2e {
+  class TrackerPlacement {
+  public:
+    enum Role_t {
+      kReadout = 0,
+      kRequest = 1,
+      kBuild   = 2,
+      kNRoles  = 3
+    };
+
+    TrackerPlacement(fhicl::ParameterSet const& ps, int DtcId);
+
+                                        // pin the calling thread and set its memory policy
+    void   pinCurrentThread(Role_t Role);
+
+    void*  allocate        (size_t Bytes);
+    void   deallocate      (void* Ptr, size_t Bytes);
+
+    int    numaNode        () const { return _numaNode;  }
+    bool   hugePages       () const { return _hugePages; }
+
+                                        // page-aligned part of [Ptr,Ptr+Bytes)
+    static void adviseHugePages(void* Ptr, size_t Bytes);
+    static int  dtcNumaNode    (int DtcId);
+
+  private:
+    size_t           mapSize_      (size_t Bytes) const;
+
+    std::vector<int> _cores[kNRoles];
+    int              _numaNode;
+    bool             _bindMemory;
+    bool             _hugePages;
+  };
+}  // namespace mu2e
+
+#endif
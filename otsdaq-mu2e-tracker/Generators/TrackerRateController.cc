@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// AIMD pacing of the data requests, see TrackerRateController.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerRateController").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerRateController.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerRateController::TrackerRateController(fhicl::ParameterSet const& ps) :
+    _enabled               (ps.get<bool>  ("enabled"                 ,  false))
+  , _delay                 (ps.get<double>("initial_delay_us"        ,   200.))
+  , _minDelay              (ps.get<double>("min_delay_us"            ,     0.))
+  , _maxDelay              (ps.get<double>("max_delay_us"            , 20000.))
+  , _increaseStep          (ps.get<double>("increase_step_us"        ,    10.))
+  , _backoffFactor         (ps.get<double>("backoff_factor"          ,     2.))
+  , _ticksPerUs            (ps.get<double>("ticks_per_us"            ,     1.))
+  , _requestsAhead         (ps.get<int>   ("initial_requests_ahead"  ,      0))
+  , _maxRequestsAhead      (ps.get<int>   ("max_requests_ahead"      ,      8))
+  , _maxTimeoutFraction    (ps.get<double>("max_timeout_fraction"    ,   0.01))
+  , _maxLatency            (ps.get<double>("max_latency_us"          ,  5000.))
+  , _maxOccupancy          (ps.get<double>("max_occupancy"           ,    0.9))
+  , _downstreamBusyFraction(ps.get<double>("downstream_busy_fraction",    0.5))
+  , _updateInterval        (ps.get<size_t>("update_interval"         ,     16))
+  , _nReads                (0)
+  , _nTimeouts             (0)
+  , _sumLatency            (0)
+  , _maxSeenOccupancy      (0)
+  , _fifoFull              (false)
+  , _meanLatency           (0)
+  , _timeoutFraction       (0)
+  , _downstreamBusy        (0) {
+
+  if (_backoffFactor   < 1.) _backoffFactor   = 1.;
+  if (_maxRequestsAhead < 0) _maxRequestsAhead = 0;
+  if (_updateInterval == 0 ) _updateInterval  = 1;
+
+  _delay         = std::clamp(_delay, _minDelay, _maxDelay);
+  _requestsAhead = std::clamp(_requestsAhead, 0, _maxRequestsAhead);
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRateController::requestSent(size_t N) {
+  _sendTimes.insert(_sendTimes.end(), N, std::chrono::steady_clock::now());
+
+  double occupancy = _sendTimes.size()/double(_maxRequestsAhead+1);
+  if (occupancy > _maxSeenOccupancy) _maxSeenOccupancy = occupancy;
+}
+
+//-----------------------------------------------------------------------------
+// requests are answered in order, so the oldest send time belongs to this read
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRateController::readDone(size_t Sts, bool Timeout) {
+  if (not _sendTimes.empty()) {
+    auto now = std::chrono::steady_clock::now();
+    _sumLatency += std::chrono::duration<double, std::micro>(now-_sendTimes.front()).count();
+    _sendTimes.pop_front();
+  }
+
+  _nReads += 1;
+  if ((Sts == 0) or Timeout) _nTimeouts += 1;
+
+  if (_nReads >= _updateInterval) update_();
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRateController::setCycleTimes(double Inside, double Outside) {
+  double total = Inside+Outside;
+  if (total > 0) _downstreamBusy = Outside/total;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRateController::update_() {
+  _meanLatency     = _sumLatency/_nReads;
+  _timeoutFraction = _nTimeouts/double(_nReads);
+
+  if (_enabled) {
+    bool overload = _fifoFull                                      or
+                    (_timeoutFraction  > _maxTimeoutFraction)      or
+                    (_meanLatency      > _maxLatency)              or
+                    (_maxSeenOccupancy > _maxOccupancy)            or
+                    (_downstreamBusy   > _downstreamBusyFraction);
+
+    if (overload) {
+      _delay         = std::min(std::max(_delay, _increaseStep)*_backoffFactor, _maxDelay);
+      _requestsAhead = std::max(_requestsAhead/2, 0);
+    }
+    else {
+      _delay         = std::max(_delay-_increaseStep, _minDelay);
+      _requestsAhead = std::min(_requestsAhead+1, _maxRequestsAhead);
+    }
+
+    TLOG(TLVL_DEBUG+5) << "rate control: overload=" << overload << " fifo_full=" << _fifoFull
+                       << " timeouts=" << _timeoutFraction << " latency=" << _meanLatency << " us"
+                       << " occupancy=" << _maxSeenOccupancy << " downstream_busy=" << _downstreamBusy
+                       << " -> delay=" << _delay << " us requests_ahead=" << _requestsAhead;
+  }
+
+  _nReads           = 0;
+  _nTimeouts        = 0;
+  _sumLatency       = 0;
+  _maxSeenOccupancy = 0;
+  _fifoFull         = false;
+}
@@ -0,0 +1,100 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerRateController_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerRateController_hh
+//-----------------------------------------------------------------------------
+// TrackerRateController : closed-loop (AIMD) control of the data request pacing
+// in TrackerVST. Two knobs:
+//  - delay : pause between consecutive reads/requests, also used (in ticks) as
+//            the CFO delay between requests in SendRequestsForRange
+//  - requests ahead : number of data requests kept in flight
+//
+// inputs, accumulated over 'update_interval' reads:
+//  - occupancy  : requests in flight / max_requests_ahead
+//  - latency    : time from a request to the DMA read of its buffer
+//  - timeouts   : reads returning nothing or a 0xcafe/0xdead buffer
+//  - ROC FIFO   : SIZE_FIFO_FULL seen by the caller
+//  - downstream : fraction of wall time spent outside getNext_, artdaq doesn't
+//                 call back while its buffers are full
+// any sign of overload -> multiplicative back-off, otherwise additive speed-up.
+// With enabled=false the knobs stay at their initial values
+//
+// rate_control : {
+//   enabled                  : false
+//   initial_delay_us         : 200
+//   min_delay_us             : 0
+//   max_delay_us             : 20000
+//   increase_step_us         : 10
+//   backoff_factor           : 2.
+//   ticks_per_us             : 1.
+//   initial_requests_ahead   : 0
+//   max_requests_ahead       : 8
+//   max_timeout_fraction     : 0.01
+//   max_latency_us           : 5000
+//   max_occupancy            : 0.9
+//   downstream_busy_fraction : 0.5
+//   update_interval          : 16
+// }
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace mu2e {
+  class TrackerRateController {
+  public:
+    explicit TrackerRateController(fhicl::ParameterSet const& ps);
+
+                                        // N requests sent at once (SendRequestsForRange)
+    void     requestSent    (size_t N = 1);
+                                        // Sts: number of bytes read, 0 if nothing came back
+    void     readDone       (size_t Sts, bool Timeout);
+    void     setFifoFull    ()                { _fifoFull = true; }
+                                        // time spent inside and outside getNext_ since the last call
+    void     setCycleTimes  (double Inside, double Outside);
+
+    bool     enabled        () const { return _enabled;         }
+    size_t   delayUs        () const { return size_t(_delay);   }
+    uint32_t requestDelay   () const { return uint32_t(_delay*_ticksPerUs); }
+    int      requestsAhead  () const { return _requestsAhead;   }
+    size_t   inFlight       () const { return _sendTimes.size(); }
+    double   meanLatencyUs  () const { return _meanLatency;     }
+    double   timeoutFraction() const { return _timeoutFraction; }
+    double   downstreamBusy () const { return _downstreamBusy;  }
+
+  private:
+    void     update_        ();
+
+    typedef std::chrono::steady_clock::time_point time_point_t;
+
+    bool     _enabled;
+    double   _delay;                    // us
+    double   _minDelay;
+    double   _maxDelay;
+    double   _increaseStep;
+    double   _backoffFactor;
+    double   _ticksPerUs;
+    int      _requestsAhead;
+    int      _maxRequestsAhead;
+    double   _maxTimeoutFraction;
+    double   _maxLatency;
+    double   _maxOccupancy;
+    double   _downstreamBusyFraction;
+    size_t   _updateInterval;
+
+    std::deque<time_point_t> _sendTimes;
+                                        // accumulated since the last update
+    size_t   _nReads;
+    size_t   _nTimeouts;
+    double   _sumLatency;
+    double   _maxSeenOccupancy;
+    bool     _fifoFull;
+                                        // results of the last update
+    double   _meanLatency;
+    double   _timeoutFraction;
+    double   _downstreamBusy;
+  };
+}  // namespace mu2e
+
+#endif
@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////
+// periodic sampling of the ROC counters, see TrackerRocMonitor.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerRocMonitor").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerRocMonitor.hh"
+#include "otsdaq-mu2e-tracker/Generators/DtcDevice.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <cstring>
+#include <string>
+
+namespace {
+                                        // low register of each counter, the high 16 bits are in the next one
+  const int lowRegister[mu2e::TrackerRocMonitor::kNCounters] = { 64, 27, 29, 31, 33, 35, 37, 39, 41, 23, 25 };
+
+  const char* counterName[mu2e::TrackerRocMonitor::kNCounters] = {
+    "EWM", "HBT", "Null HBT", "HBT Hold", "Prefetch", "Data Request",
+    "Read DDR", "Sent DTC", "Null Data", "FIFO Store", "FIFO Fetch"
+  };
+
+  const uint32_t kFifoCountMask = 0xfffff;   // STORE_CNT/FETCH_CNT[19:0]
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerRocMonitor::TrackerRocMonitor(fhicl::ParameterSet const& ps, DtcDevice* Device) :
+    _device            (Device)
+  , _links             (ps.get<std::vector<int>>("links"               , std::vector<int>{0}))
+  , _interval          (ps.get<int>             ("interval_ms"         , 1000))
+  , _historyDepth      (ps.get<size_t>          ("history"             ,  600))
+  , _maxRequestMismatch(ps.get<uint32_t>        ("max_request_mismatch",    0))
+  , _stop              (false)
+  , _fifoFullSeen      (false) {
+
+  if (_historyDepth == 0) _historyDepth = 1;
+
+  _history.resize(_links.size());
+  for (auto& ring : _history) {
+    ring.samples.resize(_historyDepth);
+    ring.next = 0;
+    ring.n    = 0;
+  }
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerRocMonitor::~TrackerRocMonitor() {
+  stop();
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRocMonitor::start() {
+  if (_thread.joinable()) return;
+
+  _stop   = false;
+  _thread = std::thread(&TrackerRocMonitor::run_, this);
+  TLOG(TLVL_INFO) << "ROC monitor started: " << _links.size() << " link(s) every " << _interval << " ms";
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRocMonitor::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _cv.notify_all();
+  if (_thread.joinable()) _thread.join();
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRocMonitor::run_() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (not _stop) {
+    lock.unlock();
+    sample();
+    lock.lock();
+    _cv.wait_for(lock, std::chrono::milliseconds(_interval), [this] { return _stop; });
+  }
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRocMonitor::readLink_(int Link, Sample& S) {
+  const int tmo_ms(10);
+
+  DTCLib::DTC_Link_ID link = DTCLib::DTC_Link_ID(Link);
+
+  for (int i=0; i<kNCounters; i++) {
+    uint32_t lo = _device->ReadROCRegister(link, lowRegister[i]  , tmo_ms);
+    uint32_t hi = _device->ReadROCRegister(link, lowRegister[i]+1, tmo_ms);
+    S.counter[i] = (hi << 16) | lo;
+  }
+
+  S.time  = std::chrono::steady_clock::now();
+  S.flags = (S.counter[kStore] & (1 << 28)) ? kFifoFull : 0;
+}
+
+//-----------------------------------------------------------------------------
+// registers are read outside the lock, only the bookkeeping is serialized
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRocMonitor::sample() {
+  for (size_t il=0; il<_links.size(); il++) {
+    int    link = _links[il];
+    Sample s;
+    memset(s.delta, 0, sizeof(s.delta));
+    for (double& r : s.rate) r = 0;
+
+    readLink_(link, s);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    Ring&   ring     = _history[il];
+    int64_t mismatch = 0;
+
+    if (ring.n > 0) {
+      Sample const& prev = ring.samples[(ring.next+_historyDepth-1) % _historyDepth];
+      double        dt   = std::chrono::duration<double>(s.time-prev.time).count();
+
+      for (int i=0; i<kNCounters; i++) {
+        if ((i == kStore) or (i == kFetch)) {
+          s.delta[i] = ((s.counter[i] & kFifoCountMask) - (prev.counter[i] & kFifoCountMask)) & kFifoCountMask;
+        }
+        else if (s.counter[i] < prev.counter[i]) {
+          s.flags   |= kCountersReset;
+          s.delta[i] = s.counter[i];
+        }
+        else {
+          s.delta[i] = s.counter[i]-prev.counter[i];
+        }
+        s.rate[i] = (dt > 0) ? s.delta[i]/dt : 0;
+      }
+//-----------------------------------------------------------------------------
+// every data request is either sent to the DTC or answered with null data
+//-----------------------------------------------------------------------------
+      mismatch = int64_t(s.delta[kDataReq]) - s.delta[kSentDtc] - s.delta[kNullData];
+      if ((mismatch > int64_t(_maxRequestMismatch)) or (-mismatch > int64_t(_maxRequestMismatch))) s.flags |= kRequestLoss;
+      if (s.delta[kEwm] > s.delta[kHbt]) s.flags |= kEwmWithoutHbt;
+    }
+
+    if (s.flags & kFifoFull) _fifoFullSeen = true;
+
+    ring.samples[ring.next] = s;
+    ring.next               = (ring.next+1) % _historyDepth;
+    if (ring.n < _historyDepth) ring.n++;
+
+    if (s.flags & (kRequestLoss | kEwmWithoutHbt | kCountersReset)) {
+      TLOG(TLVL_WARNING) << "link " << link << " flags: 0x" << std::hex << s.flags << std::dec
+                         << " data req:" << s.delta[kDataReq] << " sent:" << s.delta[kSentDtc]
+                         << " null:" << s.delta[kNullData] << " EWM:" << s.delta[kEwm] << " HBT:" << s.delta[kHbt];
+    }
+
+    if (metricMan and (ring.n > 1)) {
+      std::string prefix = "ROC" + std::to_string(link) + " ";
+      for (int i : {kEwm, kDataReq, kSentDtc, kNullData}) {
+        metricMan->sendMetric(prefix + counterName[i] + " Rate", s.rate[i], "Hz", 1, artdaq::MetricMode::Average);
+      }
+      metricMan->sendMetric(prefix + "Request Loss", int(mismatch), "requests", 1, artdaq::MetricMode::Accumulate);
+      metricMan->sendMetric(prefix + "FIFO Full"   , (s.flags & kFifoFull) ? 1 : 0, "", 1, artdaq::MetricMode::Maximum);
+      metricMan->sendMetric(prefix + "Flags"       , s.flags, "", 1, artdaq::MetricMode::LastPoint);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRocMonitor::history(int Link, std::vector<Sample>& Samples) const {
+  Samples.clear();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (size_t il=0; il<_links.size(); il++) {
+    if (_links[il] != Link) continue;
+    Ring const& ring = _history[il];
+    for (size_t i=0; i<ring.n; i++) {
+      Samples.push_back(ring.samples[(ring.next+_historyDepth-ring.n+i) % _historyDepth]);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerRocMonitor::last(int Link, Sample& S) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (size_t il=0; il<_links.size(); il++) {
+    if ((_links[il] != Link) or (_history[il].n == 0)) continue;
+    Ring const& ring = _history[il];
+    S = ring.samples[(ring.next+_historyDepth-1) % _historyDepth];
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,107 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerRocMonitor_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerRocMonitor_hh
+//-----------------------------------------------------------------------------
+// TrackerRocMonitor : background sampling of the ROC counters printed once by
+// TrackerVST::printROCRegisters (32-bit counters split over register pairs)
+//
+// every interval_ms, for each monitored link:
+// - reads the counters, computes the deltas (32-bit wrap-around) and rates
+// - flags: SIZE_FIFO_FULL set, data requests not accounted for by the sent +
+//   null-data counts, EWMs without a heartbeat, counters reset
+// - keeps the last 'history' samples in a ring, publishes through metricMan
+//
+// roc_monitor : {
+//   enabled              : false
+//   interval_ms          : 1000
+//   links                : [ 0 ]
+//   history              : 600
+//   max_request_mismatch : 0     # per interval
+// }
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mu2e {
+  class DtcDevice;
+
+  class TrackerRocMonitor {
+  public:
+    enum Counter_t {
+      kEwm      = 0,                    // N(EWM) seen          , registers 64,65
+      kHbt      = 1,                    // N(HBT) seen          , 27,28
+      kNullHbt  = 2,                    // N(null HBT)          , 29,30
+      kHbtHold  = 3,                    // N(HBT on hold)       , 31,32
+      kPrefetch = 4,                    // N(prefetch)          , 33,34
+      kDataReq  = 5,                    // N(data req)          , 35,36
+      kReadDdr  = 6,                    // N(data req read DDR) , 37,38
+      kSentDtc  = 7,                    // N(data req sent DTC) , 39,40
+      kNullData = 8,                    // N(data req null dat) , 41,42
+      kStore    = 9,                    // STORE_CNT[19:0]      , 23,24
+      kFetch    = 10,                   // FETCH_CNT[19:0]      , 25,26
+      kNCounters
+    };
+
+    enum Flag_t {
+      kFifoFull       = 0x1,
+      kRequestLoss    = 0x2,
+      kEwmWithoutHbt  = 0x4,
+      kCountersReset  = 0x8
+    };
+
+    struct Sample {
+      std::chrono::steady_clock::time_point time;
+      uint32_t counter[kNCounters];
+      uint32_t delta  [kNCounters];     // since the previous sample
+      double   rate   [kNCounters];     // Hz
+      int      flags;
+    };
+
+    TrackerRocMonitor(fhicl::ParameterSet const& ps, DtcDevice* Device);
+    ~TrackerRocMonitor();
+
+    void   start      ();
+    void   stop       ();
+                                        // one sample of all links, also called by the thread
+    void   sample     ();
+                                        // oldest first
+    void   history    (int Link, std::vector<Sample>& Samples) const;
+    bool   last       (int Link, Sample& S) const;
+                                        // true if any sample had kFifoFull since the previous call
+    bool   fifoFullSeen() { return _fifoFullSeen.exchange(false); }
+
+    std::vector<int> const& links() const { return _links; }
+
+  private:
+    struct Ring {
+      std::vector<Sample> samples;
+      size_t              next;
+      size_t              n;
+    };
+
+    void   run_       ();
+    void   readLink_  (int Link, Sample& S);
+
+    DtcDevice*              _device;
+    std::vector<int>        _links;
+    int                     _interval;          // ms
+    size_t                  _historyDepth;
+    uint32_t                _maxRequestMismatch;
+
+    mutable std::mutex      _mutex;
+    std::condition_variable _cv;
+    std::thread             _thread;
+    bool                    _stop;
+
+    std::vector<Ring>       _history;           // one per monitored link
+    std::atomic<bool>       _fifoFullSeen;
+  };
+}  // namespace mu2e
+
+#endif
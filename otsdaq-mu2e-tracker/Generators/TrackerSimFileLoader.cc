@@ -0,0 +1,327 @@
+///////////////////////////////////////////////////////////////////////////////
+// simulation file upload to the DTC DDR, see TrackerSimFileLoader.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerSimFileLoader").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerSimFileLoader.hh"
+
+#include "dtcInterfaceLib/DTC.h"
+#include "fhiclcpp/ParameterSet.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <vector>
+
+namespace {
+  const uint64_t kFnvOffset   = 0xcbf29ce484222325ULL;
+  const uint64_t kFnvPrime    = 0x100000001b3ULL;
+  const size_t   kMinDmaBytes = 80;             // shorter DMAs are padded, as in DTC::WriteSimFileToDTC
+  const uint64_t kDdrBytes    = 0xffffffffULL;
+
+//-----------------------------------------------------------------------------
+// 64-bit FNV-1a, updated block by block
+//-----------------------------------------------------------------------------
+  void fnv1a(uint64_t& Hash, const uint8_t* Data, size_t N) {
+    for (size_t i=0; i<N; i++) {
+      Hash ^= Data[i];
+      Hash *= kFnvPrime;
+    }
+  }
+
+  struct Chunk {
+    std::vector<uint8_t> data;
+    size_t               used;
+    bool                 last;
+  };
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerSimFileLoader::TrackerSimFileLoader(fhicl::ParameterSet const& ps, DTCLib::DTC* Dtc, int DtcId) :
+    _dtc             (Dtc)
+  , _stateFile       (ps.get<std::string>("state_file"          , ""))
+  , _chunkBytes      (ps.get<size_t>     ("chunk_bytes"         , 4*1024*1024))
+  , _nChunks         (ps.get<size_t>     ("n_chunks"            , 2))
+  , _progressInterval(ps.get<int>        ("progress_interval_ms", 1000))
+  , _forceReload     (ps.get<bool>       ("force_reload"        , false))
+  , _loaded          (true)
+  , _skipped         (false)
+  , _bytesLoaded     (0) {
+
+  if (_stateFile.empty()) _stateFile = "/tmp/TrackerVST_sim_file_dtc" + std::to_string(DtcId) + ".state";
+
+  _chunkBytes       = std::max(_chunkBytes, sizeof(mu2e_databuff_t));
+  _nChunks          = std::max(_nChunks, size_t(2));
+  _progressInterval = std::max(_progressInterval, 1);
+}
+
+//-----------------------------------------------------------------------------
+// the upload can't be interrupted, wait for it rather than leave it with a deleted DTC
+//-----------------------------------------------------------------------------
+mu2e::TrackerSimFileLoader::~TrackerSimFileLoader() {
+  if (_uploader.joinable()) _uploader.join();
+}
+
+//-----------------------------------------------------------------------------
+// changes at each boot of the host
+//-----------------------------------------------------------------------------
+std::string mu2e::TrackerSimFileLoader::bootId() {
+  std::string   id("unknown");
+  std::ifstream in("/proc/sys/kernel/random/boot_id");
+  in >> id;
+  return id;
+}
+
+//-----------------------------------------------------------------------------
+// the file name goes last, it may contain blanks
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerSimFileLoader::readState_(State_t& State) const {
+  std::ifstream in(_stateFile);
+  if (not (in >> std::hex >> State.hash >> State.ddrEnd >> std::dec >> State.size >> State.mtime >> State.bootId)) {
+    return false;
+  }
+  std::getline(in >> std::ws, State.file);
+  return not State.file.empty();
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerSimFileLoader::writeState_(State_t const& State) const {
+  std::ofstream out(_stateFile, std::ios::trunc);
+  out << std::hex << State.hash << " " << State.ddrEnd << std::dec << " " << State.size << " "
+      << State.mtime << " " << State.bootId << " " << State.file << std::endl;
+  if (not out) TLOG(TLVL_WARNING) << "can't write " << _stateFile;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerSimFileLoader::load(std::string const& SimFile) {
+  if (_uploader.joinable()) _uploader.join();
+
+  _loaded      = false;
+  _skipped     = false;
+  _bytesLoaded = 0;
+
+  _uploader = std::thread([this, SimFile] {
+    State_t state{0, 0, 0, 0, bootId(), SimFile};
+
+    struct stat st;
+    if (stat(SimFile.c_str(), &st) == 0) {
+      state.size  = st.st_size;
+      state.mtime = st.st_mtime;
+    }
+//-----------------------------------------------------------------------------
+// the DDR content is trusted only if the DTC still has the end address of the
+// last upload, and the host did not reboot since
+//-----------------------------------------------------------------------------
+    State_t old;
+    if ((not _forceReload) and (state.size > 0) and readState_(old) and
+        (old.file == state.file) and (old.size == state.size) and (old.mtime == state.mtime) and
+        (old.bootId == state.bootId) and (_dtc->ReadDDRDataLocalEndAddress() == old.ddrEnd)) {
+      TLOG(TLVL_INFO) << "simulation file " << SimFile << " (hash 0x" << std::hex << old.hash << std::dec
+                      << ") is already in the DTC memory, skip the upload";
+      _bytesLoaded = old.ddrEnd+1;
+      _skipped     = true;
+    }
+    else if (upload_(SimFile, state)) {
+      writeState_(state);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _loaded = true;
+    _cv.notify_all();
+  });
+}
+
+//-----------------------------------------------------------------------------
+// returns true if the whole file is in the DDR, State.hash and State.ddrEnd are set
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerSimFileLoader::upload_(std::string const& SimFile, State_t& State) {
+  std::remove(_stateFile.c_str());
+
+  std::ifstream in(SimFile, std::ios::binary);
+  if (not in) {
+    TLOG(TLVL_ERROR) << "can't open simulation file " << SimFile;
+    return false;
+  }
+
+  _dtc->ResetDDR();
+  _dtc->ResetDTC();
+
+  _dtc->DisableDetectorEmulator();
+  _dtc->DisableDetectorEmulatorMode();
+  _dtc->SetDDRDataLocalStartAddress(0x0);
+  _dtc->SetDDRDataLocalEndAddress(0xFFFFFFFF);
+  _dtc->EnableDetectorEmulatorMode();
+  _dtc->SetDetectorEmulationDMACount(1);
+  _dtc->SetDetectorEmulationDMADelayCount(250);  // 1 us
+
+  TLOG(TLVL_INFO) << "Starting read of simulation file " << SimFile << " (" << State.size << " bytes)."
+                  << " Please wait to start the run until finished.";
+
+  auto start = std::chrono::steady_clock::now();
+//-----------------------------------------------------------------------------
+// the reader fills the free chunks with whole DMA blocks and hashes them,
+// the uploader writes the full ones; a chunk always holds at least one block
+//-----------------------------------------------------------------------------
+  std::mutex              mutex;
+  std::condition_variable cv;
+  std::vector<Chunk>      chunks(_nChunks);
+  std::deque<Chunk*>      freeChunks, fullChunks;
+  bool                    stop      (false);
+  bool                    readError (false);
+  uint64_t                hash      (kFnvOffset);
+
+  for (auto& c : chunks) {
+    c.data.resize(_chunkBytes);
+    freeChunks.push_back(&c);
+  }
+
+  std::thread reader([&] {
+    bool     header(false);             // a block byte count read, block not stored yet
+    uint64_t sz    (0);
+    bool     done  (false);
+    while (not done) {
+      Chunk* c;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return stop or not freeChunks.empty(); });
+        if (stop) return;
+        c = freeChunks.front();
+        freeChunks.pop_front();
+      }
+
+      c->used = 0;
+      while (true) {
+        if (not header) {
+          if (not in.read(reinterpret_cast<char*>(&sz), sizeof(sz))) {
+            done = true;
+            break;
+          }
+          if ((sz <= sizeof(sz)) or (sz > sizeof(mu2e_databuff_t))) {
+            TLOG(TLVL_ERROR) << SimFile << ": bad DMA byte count " << sz;
+            readError = done = true;
+            break;
+          }
+          header = true;
+        }
+
+        size_t nbytes = std::max(size_t(sz), kMinDmaBytes);
+        if (c->used+nbytes > c->data.size()) break;
+
+        uint8_t* p = c->data.data()+c->used;
+        memcpy(p, &sz, sizeof(sz));
+        if (not in.read(reinterpret_cast<char*>(p)+sizeof(sz), sz-sizeof(sz))) {
+          TLOG(TLVL_ERROR) << SimFile << ": truncated DMA block";
+          readError = done = true;
+          break;
+        }
+        header = false;
+        fnv1a(hash, p, sz);
+
+        if (sz < kMinDmaBytes) {
+          uint64_t dma(kMinDmaBytes), block(64);  // the values DTCLib writes
+          memset(p+sz, 0, nbytes-sz);
+          memcpy(p                 , &dma  , sizeof(dma));
+          memcpy(p+sizeof(uint64_t), &block, sizeof(block));
+        }
+        c->used += nbytes;
+      }
+
+      c->last = done;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        fullChunks.push_back(c);
+      }
+      cv.notify_all();
+    }
+  });
+
+  uint64_t total   (0);
+  bool     ddrFull (false);
+  auto     report  (start);
+  while (true) {
+    Chunk* c;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&] { return not fullChunks.empty(); });
+      c = fullChunks.front();
+      fullChunks.pop_front();
+    }
+
+    for (size_t pos=0; pos<c->used; ) {
+      uint64_t sz;
+      memcpy(&sz, c->data.data()+pos, sizeof(sz));
+      if (total+sz > kDdrBytes) {
+        TLOG(TLVL_ERROR) << SimFile << " doesn't fit in the DTC DDR memory, stop after " << total << " bytes";
+        ddrFull = true;
+        break;
+      }
+      _dtc->WriteDetectorEmulatorData(reinterpret_cast<mu2e_databuff_t*>(c->data.data()+pos), sz);
+      pos         += sz;
+      total       += sz;
+      _bytesLoaded = total;
+    }
+
+    bool last = c->last;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      freeChunks.push_back(c);
+      stop = last or ddrFull;
+    }
+    cv.notify_all();
+    if (stop) break;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now-report >= std::chrono::milliseconds(_progressInterval)) {
+      progress_(total, State.size, std::chrono::duration<double>(now-start).count());
+      report = now;
+    }
+  }
+  reader.join();
+
+  if (total > 0) _dtc->SetDDRDataLocalEndAddress(uint32_t(total-1));
+
+  double dt = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  progress_(total, State.size, dt);
+  TLOG(TLVL_INFO) << "Done reading simulation file into DTC memory: " << total << " bytes in " << dt << " s"
+                  << ", hash 0x" << std::hex << hash << std::dec;
+
+  if (readError or ddrFull or (total == 0)) return false;
+
+  State.hash   = hash;
+  State.ddrEnd = _dtc->ReadDDRDataLocalEndAddress();
+  if (State.ddrEnd != uint32_t(total-1)) {
+    TLOG(TLVL_ERROR) << "DDR end address read back 0x" << std::hex << State.ddrEnd
+                     << ", expected 0x" << total-1 << std::dec;
+    return false;
+  }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// bytes written to the DTC, padding included
+//-----------------------------------------------------------------------------
+void mu2e::TrackerSimFileLoader::progress_(size_t Bytes, size_t Size, double Dt) {
+  TLOG(TLVL_INFO) << "simulation file upload: " << Bytes << "/" << Size << " bytes, "
+                  << (Dt > 0 ? Bytes/Dt/1.e6 : 0.) << " MB/s";
+  if (metricMan) {
+    metricMan->sendMetric("Sim File Bytes Loaded", Bytes, "bytes", 1, artdaq::MetricMode::LastPoint);
+    metricMan->sendMetric("Sim File Load Rate"   , Dt > 0 ? Bytes/Dt : 0., "B/s", 1, artdaq::MetricMode::LastPoint);
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerSimFileLoader::wait(std::function<bool()> Stop) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (not _loaded) {
+    if (Stop()) return false;
+    _cv.wait_for(lock, std::chrono::milliseconds(100));
+  }
+  return true;
+}
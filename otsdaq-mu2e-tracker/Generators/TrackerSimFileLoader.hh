@@ -0,0 +1,94 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerSimFileLoader_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerSimFileLoader_hh
+//-----------------------------------------------------------------------------
+// TrackerSimFileLoader : loads the simulation file into the DTC DDR memory
+// (detector emulator) in a background thread
+//
+// - the upload is pipelined: a reader thread fills n_chunks buffers of
+//   chunk_bytes with whole DMA blocks from the file while the uploader writes
+//   the previous chunk to the DTC, block by block. The DDR setup follows
+//   DTC::WriteSimFileToDTC, DMA blocks shorter than 80 bytes are padded
+// - the file content hash (64-bit FNV-1a) is computed on the blocks as they
+//   are read, the file is read only once
+// - what was loaded last is kept in a state file per DTC: hash, size and
+//   modification time of the file, boot ID of the host and the DDR end address.
+//   The upload is skipped only if the file, the boot and the end address read
+//   back from the DTC all match, so a DTC power cycle or a reboot reloads it
+// - the state file is removed before an upload starts, so an interrupted upload
+//   is never taken for a good one
+// - the upload progress is reported (TRACE and metrics) every progress_interval_ms
+// - wait() blocks on a condition variable until the upload is done or the
+//   caller's stop predicate becomes true
+//
+// sim_loader : {
+//   state_file           : ""      # default: /tmp/TrackerVST_sim_file_dtc<N>.state
+//   chunk_bytes          : 4194304 # at least one DMA buffer (64 KB)
+//   n_chunks             : 2
+//   progress_interval_ms : 1000    # at least 1
+//   force_reload         : false   # ignore the state file
+// }
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace DTCLib {
+  class DTC;
+}
+
+namespace mu2e {
+  class TrackerSimFileLoader {
+  public:
+
+    struct State_t {
+      uint64_t    hash;
+      size_t      size;
+      time_t      mtime;
+      uint32_t    ddrEnd;                   // DDR end address after the upload
+      std::string bootId;
+      std::string file;
+    };
+
+    TrackerSimFileLoader(fhicl::ParameterSet const& ps, DTCLib::DTC* Dtc, int DtcId);
+    ~TrackerSimFileLoader();
+                                        // resets the DDR and starts the upload, unless already there
+    void   load       (std::string const& SimFile);
+                                        // true when loaded, false if Stop() returned true first
+    bool   wait       (std::function<bool()> Stop);
+
+    bool   loaded     () const { return _loaded;      }
+    bool   skipped    () const { return _skipped;     }
+    size_t bytesLoaded() const { return _bytesLoaded; }
+
+    static std::string bootId();
+
+  private:
+    bool   upload_    (std::string const& SimFile, State_t& State);
+    void   progress_  (size_t Bytes, size_t Size, double Dt);
+    bool   readState_ (State_t& State) const;
+    void   writeState_(State_t const& State) const;
+
+    DTCLib::DTC*            _dtc;
+    std::string             _stateFile;
+    size_t                  _chunkBytes;
+    size_t                  _nChunks;
+    int                     _progressInterval;  // ms
+    bool                    _forceReload;
+
+    std::thread             _uploader;
+    std::mutex              _mutex;
+    std::condition_variable _cv;
+    std::atomic<bool>       _loaded;
+    std::atomic<bool>       _skipped;
+    std::atomic<size_t>     _bytesLoaded;
+  };
+}  // namespace mu2e
+
+#endif
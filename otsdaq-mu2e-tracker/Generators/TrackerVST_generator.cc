@@ -16,6 +16,7 @@
 #include "artdaq-core-mu2e/Overlays/mu2eFragment.hh"
 #include "artdaq-core-mu2e/Overlays/mu2eFragmentWriter.hh"
 
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iterator>
@@ -38,10 +39,41 @@
 #include "dtcInterfaceLib/DTC.h"
 #include "dtcInterfaceLib/DTCSoftwareCFO.h"
 
+#include "otsdaq-mu2e-tracker/Generators/DtcDevice.hh"
+#include "otsdaq-mu2e-tracker/Generators/DtcMockDevice.hh"
+#include "otsdaq-mu2e-tracker/Generators/DtcCachedDevice.hh"
+#include "otsdaq-mu2e-tracker/Generators/DtcScheduledDevice.hh"
+#include "otsdaq-mu2e-tracker/Generators/DtcMultiDevice.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerRateController.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerFragmentPool.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerMemoryBudget.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerPlacement.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerEventCache.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerFragmentIndex.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerSimFileLoader.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerRocMonitor.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerLatencyTracer.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerCalibration.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerHitDecoder.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerWindowTracker.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerDmaTuner.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerLinkMerger.hh"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerLog.hh"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerStatus.hh"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerTaskPool.hh"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerDcsScheduler.hh"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerHitFile.hh"
+
+#include "artdaq/DAQrate/RequestBuffer.hh"
+
 #include <atomic>
 #include <chrono>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <thread>
 #include <vector>
 
 using namespace DTCLib;
@@ -61,14 +93,40 @@ namespace mu2e {
 
     bool sendEmpty_(artdaq::FragmentPtrs& output);
 
-    void start      () override {}
+    void start      () override;
     void stopNoMutex() override {}
     void stop       () override;
 
-    void readSimFile_(std::string sim_file);
-    mu2e_databuff_t* readDTCBuffer(mu2edev* device, bool& success, bool& timeout, size_t& sts, bool continuedMode);
+    mu2e_databuff_t* readDTCBuffer(DtcDevice* device, bool& success, bool& timeout, size_t& sts, bool continuedMode);
+    DtcDevice*       openDtc_      (fhicl::ParameterSet const& ps, int DtcId, DTC*& Dtc, DTCSoftwareCFO*& Cfo);
+    uint64_t         eventWindowTag_(const mu2e_databuff_t* Buffer);
+//-----------------------------------------------------------------------------
+// one DTC event of the fragment being built: where it goes and what the task
+// processing it found
+//-----------------------------------------------------------------------------
+    struct BufferSlot {
+      const uint8_t*                      src;          // DMA buffer or event cache
+      uint8_t*                            dest;         // in the fragment
+      size_t                              nbytes;
+      bool                                corrupt;
+      std::vector<TrackerHitDecoder::Hit> hits;
+      std::vector<uint16_t>               waveforms;    // with hit_output.waveforms only
+      std::atomic<bool>                   done;
+    };
+
+    BufferSlot*      addBuffer_     (mu2eFragmentWriter& Frag, const mu2e_databuff_t* Buffer, size_t Sts);
+    void             addMerged_     (artdaq::Fragment& Frag, mu2eFragmentWriter& Writer, bool Flush);
+    void             processBuffer_ (BufferSlot* Slot);
+    void             releaseBuffers_(DtcDevice* Device, size_t MaxHeld);
+    void             updateBudget_  (mu2eFragmentWriter const* Writer);
+    artdaq::FragmentPtr newFragment_(artdaq::Fragment::sequence_id_t Seq);
+    void             finishFragment_(artdaq::Fragment& Frag, mu2eFragmentWriter& Writer, bool Live);
+    void             writeIndex_    (artdaq::Fragment& Frag, mu2eFragmentWriter& Writer);
+    void             serveRequests_ (artdaq::FragmentPtrs& Frags);
 
     void printROCRegisters();
+    void reportROCRegisters_(const roc_data_t* R);
+    void publishStatus_   ();
     void printDTCRegisters();
 
     void monica_var_pattern_config();
@@ -94,7 +152,6 @@ namespace mu2e {
     size_t          timestamp_loops_{0}; // For playback mode, so that we continually generate unique timestamps
     DTC_SimMode     mode_;
     uint8_t         board_id_;
-    bool            simFileRead_;
     bool            rawOutput_;
     std::string     rawOutputFile_;
     std::ofstream   rawOutputStream_;
@@ -107,13 +164,70 @@ namespace mu2e {
     int             dtc_id_;
     uint            roc_mask_;
     
-    DTC*            _dtc;
+    std::string     _deviceType;        // "dtc" or "mock"
+    DTC*            _dtc;               // null in mock mode
     DTCSoftwareCFO* _cfo;
+    DtcDevice*      _dev;               // all readout and DCS calls go through it
+    DtcMultiDevice* _multiDev;          // null with one DTC
+    std::vector<DTC*>            _extraDtc;     // multi_dtc.dtc_ids, hardware only
+    std::vector<DTCSoftwareCFO*> _extraCfo;
+    DtcCachedDevice* _registerCache;    // _dev itself if the register cache is on, null otherwise
+    TrackerDcsScheduler* _dcs;          // null if disabled: DCS on the calling threads
+    DtcDevice*      _dcsDevice;         // behind the scheduler, for the jobs submitted directly
+    DtcDevice*      _monitorDev;        // the ROC monitor's way to the scheduler
+    std::vector<std::pair<int, std::future<uint32_t>>> _rocReads;   // diagnostics in flight
+    std::vector<std::future<uint32_t>> _statusReads;                // status DTC registers in flight
+    TrackerRateController* _rateController;
+    TrackerFragmentPool*   _fragmentPool;
+    TrackerMemoryBudget*   _budget;
+    TrackerPlacement*      _placement;
+    TrackerSimFileLoader*  _simLoader;          // null in mock mode
+    TrackerRocMonitor*     _rocMonitor;         // null if disabled
+    TrackerLatencyTracer*  _tracer;             // null if disabled
+    TrackerStatus*         _status;             // null if disabled
+    TrackerCalibration*    _calibration;        // null if disabled
+    TrackerHitDecoder*     _hitDecoder;         // null if disabled
+    std::vector<TrackerHitDecoder::Hit> _fragHits;  // hits of the fragment being built, in block order
+    bool                   _hitOutput;
+    std::string            _hitOutputDir;
+    bool                   _hitOutputWaveforms;
+    size_t                 _hitOutputChunk;     // hits per chunk
+    TrackerHitWriter*      _hitWriter;          // open between start and stop
+    TrackerTaskPool*       _taskPool;           // per-buffer work, inline with 0 threads
+    size_t                 _maxHeldBuffers;     // DMA buffers not released yet
+    std::vector<std::unique_ptr<BufferSlot>> _slots;
+    size_t                 _nSlots;             // used by the fragment being built
+                                                // DMA buffers in read order and their sizes,
+                                                // nullptr: nothing to wait for
+    std::deque<std::pair<BufferSlot*, size_t>> _held;
+    size_t                 _nCorrupt;
+    TrackerWindowTracker*  _windows;            // null if disabled: the link is reset on every call
+    uint64_t               _nextTag;            // next event window to request, with recovery on
+    size_t                 _nLinkResets;
+    TrackerDmaTuner*       _dmaTuner;           // null without dma_tuning or dtc_profile
+    TrackerLinkMerger*     _linkMerger;         // null if disabled: one block per DMA buffer
+    std::deque<std::vector<uint8_t>> _merged;   // merged events of the fragment being built
+    size_t                 _nMerged;
+    int                    _statusInterval;     // ms
+    std::vector<uint16_t>  _statusDtcRegisters;
+    int                    _statusBlock[3];     // readout, DTC registers, ROC registers
+    std::vector<int>       _statusRateBlock;    // one per monitored link
+    std::chrono::steady_clock::time_point _lastStatusTime;
+    std::vector<uint64_t>  _fragTags;           // event windows in the fragment being built
+    TrackerEventCache*     _eventCache;         // null if disabled
+    bool                   _serveRequests;
+    uint64_t               _windowBefore;
+    uint64_t               _windowAfter;
+    size_t                 _nRequestsServed;
+    size_t                 _nWindowsMissed;     // one per window and DTC
+    bool                   _writeIndex;
+    TrackerFragmentIndex   _index;              // ROC blocks of the fragment being built
     int             _firstTime;
     int             _nbuffers;
     
     std::chrono::steady_clock::time_point lastReportTime_;
     std::chrono::steady_clock::time_point procStartTime_;
+    std::chrono::steady_clock::time_point _lastReturnTime;   // end of the previous getNext_
 
     double _timeSinceLastSend() {
       auto now        = std::chrono::steady_clock::now();
@@ -151,57 +265,281 @@ mu2e::TrackerVST::TrackerVST(fhicl::ParameterSet const& ps) :
   , _heartbeatsAfter (ps.get<size_t>     ("null_heartbeats_after_requests",    16)) 
   , dtc_id_          (ps.get<int>        ("dtc_id"                        ,    -1)) 
   , roc_mask_        (ps.get<int>        ("roc_mask"                      ,     0))
+  , _deviceType      (ps.get<std::string>("device_type"                   , "dtc"))
   , lastReportTime_  (std::chrono::steady_clock::now()) {
     
     TLOG(TLVL_DEBUG) << "TrackerVST_generator CONSTRUCTOR";
     // mode_ can still be overridden by environment!
     
     roc_mask_ = 1; // first link
-    _dtc = new DTC(mode_,dtc_id_,roc_mask_,
-		   "", 
-		   false, 
-		   ps.get<std::string>("simulator_memory_file_name","mu2esim.bin"));
-    
-    fhicl::ParameterSet cfoConfig = ps.get<fhicl::ParameterSet>("cfo_config", fhicl::ParameterSet());
-    
-    _cfo = new DTCSoftwareCFO(_dtc, 
-			      cfoConfig.get<bool>("use_dtc_cfo_emulator", true), 
-			      cfoConfig.get<size_t>("debug_packet_count", 0), 
-			      DTC_DebugTypeConverter::ConvertToDebugType(cfoConfig.get<std::string>("debug_type", "2")), 
-			      cfoConfig.get<bool>("sticky_debug_type", false), 
-			      cfoConfig.get<bool>("quiet", false), 
-			      cfoConfig.get<bool>("asyncRR", false), 
-			      cfoConfig.get<bool>("force_no_debug_mode", false), 
-			      cfoConfig.get<bool>("useCFODRP", false));
-    mode_ = _dtc->ReadSimMode();
-    _nbuffers = 2;     // N(buffers) per call
+    _nbuffers = ps.get<int>("buffers_per_call", 2);
+
+    _rateController = new TrackerRateController(ps.get<fhicl::ParameterSet>("rate_control", fhicl::ParameterSet()));
+    _fragmentPool   = new TrackerFragmentPool  (ps.get<fhicl::ParameterSet>("fragment_pool", fhicl::ParameterSet()),
+                                                fragment_ids_[0], fragment_type_);
+    _placement      = new TrackerPlacement     (ps.get<fhicl::ParameterSet>("placement", fhicl::ParameterSet()), dtc_id_);
+    _fragmentPool->setHugePages(_placement->hugePages());
+    _budget         = new TrackerMemoryBudget  (ps.get<fhicl::ParameterSet>("memory_budget", fhicl::ParameterSet()));
+
+    fhicl::ParameterSet cacheConfig = ps.get<fhicl::ParameterSet>("event_cache", fhicl::ParameterSet());
+//-----------------------------------------------------------------------------
+// with multi_dtc the cache keeps one event per window and DTC
+//-----------------------------------------------------------------------------
+    size_t nDtcs = 1 + ps.get<fhicl::ParameterSet>("multi_dtc", fhicl::ParameterSet())
+                         .get<std::vector<int>>("dtc_ids", std::vector<int>()).size();
+
+    _eventCache      = cacheConfig.get<bool>("enabled", false) ? new TrackerEventCache(cacheConfig, _placement, nDtcs) : nullptr;
+    if (_eventCache) _budget->set(TrackerMemoryBudget::kEventCache,
+                                  _eventCache->nWindows()*_eventCache->nSources()*_eventCache->slotBytes());
+    _serveRequests   = (_eventCache != nullptr) and cacheConfig.get<bool>("serve_requests", false);
+    _windowBefore    = cacheConfig.get<uint64_t>("window_before", 0);
+    _windowAfter     = cacheConfig.get<uint64_t>("window_after" , 0);
+    _nRequestsServed = 0;
+    _nWindowsMissed  = 0;
+
+    _writeIndex      = ps.get<bool>("write_index", false);
+//-----------------------------------------------------------------------------
+// hot-path messages (TRK_LOG) end up in TRACE, written by the TrackerLog thread
+//-----------------------------------------------------------------------------
+    TrackerLog::setLevel(ps.get<int>("log_level", TrackerLog::kInfo));
+    TrackerLog::instance()->acquireSink([](int Level, const char* Text) {
+      switch (Level) {
+      case TrackerLog::kError  : TLOG(TLVL_ERROR  ) << Text; break;
+      case TrackerLog::kWarning: TLOG(TLVL_WARNING) << Text; break;
+      case TrackerLog::kInfo   : TLOG(TLVL_INFO   ) << Text; break;
+      default                  : TLOG(TLVL_DEBUG  ) << Text; break;
+      }
+    });
+
+    fhicl::ParameterSet traceConfig = ps.get<fhicl::ParameterSet>("latency_trace", fhicl::ParameterSet());
+    _tracer = traceConfig.get<bool>("enabled", false) ? new TrackerLatencyTracer(traceConfig, fragment_ids_[0]) : nullptr;
+//-----------------------------------------------------------------------------
+// straw hits decoded and calibrated at the board reader
+//-----------------------------------------------------------------------------
+    fhicl::ParameterSet calibConfig = ps.get<fhicl::ParameterSet>("calibration", fhicl::ParameterSet());
+    if (calibConfig.get<bool>("enabled", false)) {
+      _calibration = new TrackerCalibration(calibConfig);
+      _hitDecoder  = new TrackerHitDecoder (calibConfig, _calibration);
+    }
+    else {
+      _calibration = nullptr;
+      _hitDecoder  = nullptr;
+    }
+//-----------------------------------------------------------------------------
+// decoded hits also written to a column file per run,
+// <directory>/trk_hits_run<run>_frag<fragment_id>.trkh, see TrackerHitFile.hh
+//
+// hit_output : {
+//   enabled    : false     # needs calibration.enabled
+//   directory  : "/tmp"
+//   waveforms  : false     # also the n_adc_samples ADC samples of each hit
+//   chunk_hits : 65536
+// }
+//-----------------------------------------------------------------------------
+    fhicl::ParameterSet hitConfig = ps.get<fhicl::ParameterSet>("hit_output", fhicl::ParameterSet());
+    _hitOutput          = hitConfig.get<bool>       ("enabled"   , false);
+    _hitOutputDir       = hitConfig.get<std::string>("directory" , "/tmp");
+    _hitOutputWaveforms = hitConfig.get<bool>       ("waveforms" , false);
+    _hitOutputChunk     = hitConfig.get<size_t>     ("chunk_hits", 65536);
+    _hitWriter          = nullptr;
+    if (_hitOutput and (_hitDecoder == nullptr)) {
+      TLOG(TLVL_WARNING) << "hit_output needs calibration.enabled, no hit file written";
+      _hitOutput = false;
+    }
+//-----------------------------------------------------------------------------
+// per-buffer work (copy into the fragment, integrity scan, hit decoding) on a
+// work-stealing pool; the getNext_ thread only reads, reserves and releases
+//
+// task_pool : {
+//   n_threads        : 0    # 0: everything on the getNext_ thread
+//   max_held_buffers : 8    # DMA buffers in flight before the reader waits
+// }
+//-----------------------------------------------------------------------------
+    fhicl::ParameterSet poolConfig = ps.get<fhicl::ParameterSet>("task_pool", fhicl::ParameterSet());
+    _taskPool = new TrackerTaskPool(poolConfig.get<int>("n_threads", 0),
+                                    [this](int) { _placement->pinCurrentThread(TrackerPlacement::kBuild); });
+    _maxHeldBuffers = poolConfig.get<size_t>("max_held_buffers", 8);
+    _nSlots         = 0;
+    _nCorrupt       = 0;
+//-----------------------------------------------------------------------------
+// event windows which didn't come back are requested again; the link reset
+// done on every call without it becomes the last resort
+//-----------------------------------------------------------------------------
+    fhicl::ParameterSet windowConfig = ps.get<fhicl::ParameterSet>("window_recovery", fhicl::ParameterSet());
+    _windows     = windowConfig.get<bool>("enabled", false) ? new TrackerWindowTracker(windowConfig) : nullptr;
+    _nextTag     = 1;
+    _nLinkResets = 0;
+//-----------------------------------------------------------------------------
+// without window recovery the link is reset and the tags start over on every
+// call: a requested tag could be served from the wrong window
+//-----------------------------------------------------------------------------
+    if (_serveRequests and (_windows == nullptr)) {
+      TLOG(TLVL_WARNING) << "event_cache.serve_requests needs window_recovery.enabled, serving requests disabled";
+      _serveRequests = false;
+    }
+//-----------------------------------------------------------------------------
+// ROC blocks of several links merged into one DTC event per event window,
+// in window order, see TrackerLinkMerger.hh
+//-----------------------------------------------------------------------------
+    fhicl::ParameterSet mergeConfig = ps.get<fhicl::ParameterSet>("link_merge", fhicl::ParameterSet());
+    _linkMerger = mergeConfig.get<bool>("enabled", false) ? new TrackerLinkMerger(mergeConfig) : nullptr;
+    _nMerged    = 0;
+//-----------------------------------------------------------------------------
+// DTC readout registers: swept by dma_tuning, or taken from a profile it wrote
+//-----------------------------------------------------------------------------
+    fhicl::ParameterSet tuneConfig = ps.get<fhicl::ParameterSet>("dma_tuning", fhicl::ParameterSet());
+    if (tuneConfig.get<bool>("enabled", false) or ps.has_key("dtc_profile")) {
+      _dmaTuner = new TrackerDmaTuner(tuneConfig, ps.get<fhicl::ParameterSet>("dtc_profile", fhicl::ParameterSet()),
+                                      fragment_ids_[0]);
+    }
+    else {
+      _dmaTuner = nullptr;
+    }
+
+    if (_deviceType == "mock") {
+//-----------------------------------------------------------------------------
+// no hardware: DTC stand-in with a configurable timing model
+//-----------------------------------------------------------------------------
+      _dtc         = nullptr;
+      _cfo         = nullptr;
+      _dev         = new DtcMockDevice(ps.get<fhicl::ParameterSet>("mock_config", fhicl::ParameterSet()));
+      _simLoader   = nullptr;
+
+      if (ps.get<bool>("load_sim_file", false)) {
+	TLOG(TLVL_WARNING) << "load_sim_file ignored in mock mode";
+      }
+    }
+    else {
+      _dev  = openDtc_(ps, dtc_id_, _dtc, _cfo);
+      mode_ = _dtc->ReadSimMode();
     
-    TLOG(TLVL_INFO) << "The DTC Firmware version string is: " << _dtc->ReadDesignVersion();
+      TLOG(TLVL_INFO) << "The DTC Firmware version string is: " << _dtc->ReadDesignVersion();
     
-    if (ps.get<bool>("load_sim_file", false)) {
+      _simLoader = new TrackerSimFileLoader(ps.get<fhicl::ParameterSet>("sim_loader", fhicl::ParameterSet()), _dtc, dtc_id_);
+
+      if (ps.get<bool>("load_sim_file", false)) {
 
-      _dtc->SetDetectorEmulatorInUse();
-      _dtc->ResetDDR();
-      _dtc->ResetDTC();
+	_dtc->SetDetectorEmulatorInUse();
       
-      char* file_c = getenv("DTCLIB_SIM_FILE");
+	char* file_c = getenv("DTCLIB_SIM_FILE");
       
-      auto sim_file = ps.get<std::string>("sim_file", "");
-      if (file_c != nullptr) {
-	sim_file = std::string(file_c);
+	auto sim_file = ps.get<std::string>("sim_file", "");
+	if (file_c != nullptr) {
+	  sim_file = std::string(file_c);
+	}
+//-----------------------------------------------------------------------------
+// DDR reset and upload in the background, skipped if the same file is already loaded
+//-----------------------------------------------------------------------------
+	if (sim_file.size() > 0) {
+	  _simLoader->load(sim_file);
+	}
       }
-      if (sim_file.size() > 0) {
-	simFileRead_ = false;
-	std::thread reader(&mu2e::TrackerVST::readSimFile_, this, sim_file);
-	reader.detach();
+      else {
+	_dtc->ClearDetectorEmulatorInUse();  // Needed if we're doing ROC Emulator...make sure Detector Emulation
+					     // is disabled
       }
     }
-    else {
-      _dtc->ClearDetectorEmulatorInUse();  // Needed if we're doing ROC Emulator...make sure Detector Emulation
-					   // is disabled
-      simFileRead_ = true;
+//-----------------------------------------------------------------------------
+// more DTCs read by the same thread, polled together, see DtcMultiDevice.hh.
+// The sim file is loaded into the first DTC only; in mock mode each extra
+// DTC gets mock_config with its own dtc_id
+//-----------------------------------------------------------------------------
+    fhicl::ParameterSet multiConfig = ps.get<fhicl::ParameterSet>("multi_dtc", fhicl::ParameterSet());
+    std::vector<int>    extraIds    = multiConfig.get<std::vector<int>>("dtc_ids", std::vector<int>());
+    _multiDev = nullptr;
+    if (not extraIds.empty()) {
+      std::vector<DtcDevice*> devices = {_dev};
+      for (int id : extraIds) {
+	if (_deviceType == "mock") {
+	  fhicl::ParameterSet mockConfig = ps.get<fhicl::ParameterSet>("mock_config", fhicl::ParameterSet());
+	  mockConfig.put_or_replace("dtc_id", id);
+	  devices.push_back(new DtcMockDevice(mockConfig));
+	}
+	else {
+	  DTC*            dtc;
+	  DTCSoftwareCFO* cfo;
+	  devices.push_back(openDtc_(ps, id, dtc, cfo));
+	  _extraDtc.push_back(dtc);
+	  _extraCfo.push_back(cfo);
+	}
+      }
+      _multiDev = new DtcMultiDevice(devices, multiConfig);
+      _dev      = _multiDev;
     }
-    
+//-----------------------------------------------------------------------------
+// registers which don't change on their own are read once, not every call
+//-----------------------------------------------------------------------------
+    fhicl::ParameterSet registerConfig = ps.get<fhicl::ParameterSet>("register_cache", fhicl::ParameterSet());
+    _registerCache = nullptr;
+    if (registerConfig.get<bool>("enabled", false)) {
+      _registerCache = new DtcCachedDevice(_dev, registerConfig);
+      _dev           = _registerCache;
+    }
+//-----------------------------------------------------------------------------
+// DCS transactions on their own thread, with priorities and rate limits, so
+// the ROC registers can be read with the event window markers on:
+// run control (kHigh) waits for nothing, the ROC monitor (kNormal) and the
+// per-call register dump (kLow) are rate limited
+//
+// dcs_scheduler : {
+//   enabled     : false
+//   normal_rate : 1000.   # transactions/s, 0: unlimited
+//   low_rate    : 200.
+//   burst       : 16
+//   min_gap_us  : 0       # between any two transactions
+// }
+//-----------------------------------------------------------------------------
+    fhicl::ParameterSet dcsConfig = ps.get<fhicl::ParameterSet>("dcs_scheduler", fhicl::ParameterSet());
+    _dcs        = nullptr;
+    _dcsDevice  = _dev;
+    _monitorDev = _dev;
+    if (dcsConfig.get<bool>("enabled", false)) {
+      double burst = dcsConfig.get<double>("burst", 16);
+      _dcs = new TrackerDcsScheduler();
+      _dcs->setRateLimit(TrackerDcsScheduler::kNormal, dcsConfig.get<double>("normal_rate", 1000.), burst);
+      _dcs->setRateLimit(TrackerDcsScheduler::kLow   , dcsConfig.get<double>("low_rate"   ,  200.), burst);
+      _dcs->setMinGapUs (dcsConfig.get<int>("min_gap_us", 0));
+
+      _monitorDev = new DtcScheduledDevice(_dcsDevice, _dcs, TrackerDcsScheduler::kNormal, false);
+      _dev        = new DtcScheduledDevice(_dcsDevice, _dcs, TrackerDcsScheduler::kHigh  , true );
+    }
+//-----------------------------------------------------------------------------
+// ROC counters sampled in the background, between start and stop
+//-----------------------------------------------------------------------------
+    fhicl::ParameterSet monitorConfig = ps.get<fhicl::ParameterSet>("roc_monitor", fhicl::ParameterSet());
+    _rocMonitor = monitorConfig.get<bool>("enabled", false) ? new TrackerRocMonitor(monitorConfig, _monitorDev) : nullptr;
+//-----------------------------------------------------------------------------
+// status export: the latest register snapshots and rates in shared memory,
+// for GUIs and scripts which otherwise would have to go through DCS
+//-----------------------------------------------------------------------------
+    fhicl::ParameterSet statusConfig = ps.get<fhicl::ParameterSet>("status_export", fhicl::ParameterSet());
+    _status = nullptr;
+    if (statusConfig.get<bool>("enabled", false)) {
+      std::string segment = statusConfig.get<std::string>("segment", "/trk_status_dtc"+std::to_string(dtc_id_));
+      _status = TrackerStatus::create(segment);
+      if (_status == nullptr) TLOG(TLVL_WARNING) << "can't create status segment " << segment << ", status export disabled";
+    }
+    _statusInterval     = statusConfig.get<int>("interval_ms", 1000);
+    _statusDtcRegisters = statusConfig.get<std::vector<uint16_t>>("dtc_registers", {0x9000, 0x9004, 0x9100, 0x9104, 0x9144, 0x91a8});
+    _lastStatusTime     = std::chrono::steady_clock::now();
+
+    if (_status) {
+      _statusBlock[0] = _status->block("readout", TrackerStatus::kValues,
+                                       "request_delay_us,requests_ahead,read_latency_us,timeout_fraction,"
+                                       "fragment_size_predicted,fragments_grown,fragment_pool_empty,"
+                                       "requests_served,windows_missed,memory_used,memory_high_water,"
+                                       "requests_deferred");
+      _statusBlock[1] = _status->block("dtc.registers"  , TrackerStatus::kRegisters);
+      _statusBlock[2] = _status->block("roc0.registers" , TrackerStatus::kRegisters);
+      if (_rocMonitor) {
+        for (int link : _rocMonitor->links()) {
+          _statusRateBlock.push_back(_status->block("roc"+std::to_string(link)+".rates", TrackerStatus::kValues,
+                                                    "ewm,hbt,null_hbt,hbt_hold,prefetch,data_req,read_ddr,"
+                                                    "sent_dtc,null_data,store,fetch,flags"));
+        }
+      }
+    }
+
     if (rawOutput_) rawOutputStream_.open(rawOutputFile_, std::ios::out | std::ios::app | std::ios::binary);
 
     _firstTime = 1;
@@ -209,24 +547,60 @@ mu2e::TrackerVST::TrackerVST(fhicl::ParameterSet const& ps) :
     TLOG(TLVL_INFO) << "P,Murat: VST board reader created" ;
   }
 
-//-----------------------------------------------------------------------------
-void mu2e::TrackerVST::readSimFile_(std::string sim_file) {
-  TLOG(TLVL_INFO) << "Starting read of simulation file " << sim_file << "."
-		  << " Please wait to start the run until finished.";
-  _dtc->WriteSimFileToDTC(sim_file, true, true);
-  simFileRead_ = true;
-  TLOG(TLVL_INFO) << "Done reading simulation file into DTC memory.";
-}
-
 //-----------------------------------------------------------------------------
 mu2e::TrackerVST::~TrackerVST() {
   rawOutputStream_.close();
+  TrackerLog::instance()->releaseSink();
+  delete _status;
+  delete _taskPool;
+  delete _windows;
+  delete _linkMerger;
+  delete _dmaTuner;
+  delete _hitWriter;
+  delete _hitDecoder;
+  delete _calibration;
+  delete _tracer;
+  delete _rocMonitor;
+  delete _dcs;                          // drops the diagnostics still queued
+  if (_monitorDev != _dev) delete _monitorDev;
+  delete _simLoader;
+  delete _eventCache;
+  delete _placement;
+  delete _fragmentPool;
+  delete _budget;
+  delete _rateController;
+  delete _dev;
+  for (auto cfo : _extraCfo) delete cfo;
+  for (auto dtc : _extraDtc) delete dtc;
   delete _cfo;
   delete _dtc;
 }
 
+//-----------------------------------------------------------------------------
+void mu2e::TrackerVST::start() {
+  if (_calibration) _calibration->reload();
+
+  if (_hitOutput) {
+    std::string file = _hitOutputDir + "/trk_hits_run" + std::to_string(run_number()) +
+                       "_frag" + std::to_string(fragment_ids_[0]) + ".trkh";
+    delete _hitWriter;
+    _hitWriter = new TrackerHitWriter(file, _hitOutputWaveforms ? _hitDecoder->nSamples() : 0, _hitOutputChunk);
+    if (_hitWriter->isOpen()) TLOG(TLVL_INFO) << "writing hits to " << file;
+    else                      TLOG(TLVL_WARNING) << "can't open " << file;
+  }
+  if (_rocMonitor) _rocMonitor->start();
+}
+
 //-----------------------------------------------------------------------------
 void mu2e::TrackerVST::stop() {
+  if (_rocMonitor) _rocMonitor->stop();
+  if (_tracer    ) _tracer->dump();
+  if (_hitWriter ) {
+    TLOG(TLVL_INFO) << _hitWriter->nHits() << " hits in " << _hitWriter->nChunks() << " chunks written";
+    delete _hitWriter;                  // closes the file
+    _hitWriter = nullptr;
+  }
+  if (_dtc == nullptr) return;
   _dtc->DisableDetectorEmulator();
   _dtc->DisableCFOEmulation();
 }
@@ -237,13 +611,19 @@ bool mu2e::TrackerVST::getNext_(artdaq::FragmentPtrs& frags) {
 
   const char* oname = "mu2e::TrackerVST::getNext_: ";
 
-  TLOG(TLVL_DEBUG) << oname << "P.Murat: START";
+  TRK_LOG(TrackerLog::kDebug, oname << "P.Murat: START");
 
-  while (!simFileRead_ and !should_stop()) {
-    usleep(5000);
-  }
+  if (_simLoader) _simLoader->wait([this] { return should_stop(); });
 
   if (should_stop() or ev_counter() > nEvents_) return false;
+//-----------------------------------------------------------------------------
+// time artdaq kept us waiting since the previous call : a measure of the downstream backpressure
+//-----------------------------------------------------------------------------
+  if (ev_counter() > 1) {
+    auto now = std::chrono::steady_clock::now();
+    _rateController->setCycleTimes(std::chrono::duration<double>(_lastReturnTime-procStartTime_).count(),
+                                   std::chrono::duration<double>(now-_lastReturnTime).count());
+  }
 
   // if (sendEmpties_) {
   //   int mod = ev_counter() % nSkip_;
@@ -260,7 +640,15 @@ bool mu2e::TrackerVST::getNext_(artdaq::FragmentPtrs& frags) {
   
   _startProcTimer();
   
-  TLOG(TLVL_DEBUG    ) << oname << "after startProcTimer";
+  TRK_LOG(TrackerLog::kTrace, oname << "after startProcTimer");
+//-----------------------------------------------------------------------------
+// artdaq calls getNext_ from its own thread, pin it on the first call and
+// preallocate the fragments from it, next to the DTC
+//-----------------------------------------------------------------------------
+  if (_firstTime) {
+    _placement->pinCurrentThread(TrackerPlacement::kReadout);
+    _fragmentPool->refill();
+  }
   
   TLOG(TLVL_TRACE + 5) << oname << "Starting CFO thread";
 
@@ -283,9 +671,9 @@ bool mu2e::TrackerVST::getNext_(artdaq::FragmentPtrs& frags) {
 // #endif
 //   }
 
-//   _dtc->WriteROCRegister(DTCLib::DTC_Link_0,11,1,true, 0);
+//   _dev->WriteROCRegister(DTCLib::DTC_Link_0,11,1,true, 0);
 
-//   DTCLib::roc_data_t r11 = _dtc->ReadROCRegister(DTCLib::DTC_Link_0, 11, 0);
+//   DTCLib::roc_data_t r11 = _dev->ReadROCRegister(DTCLib::DTC_Link_0, 11, 0);
 //   TLOG(TLVL_DEBUG) << "pasha reading regster 11: value=" << r11 ; 
 	
 
@@ -308,8 +696,16 @@ bool mu2e::TrackerVST::getNext_(artdaq::FragmentPtrs& frags) {
 //   TLOG(TLVL_TRACE + 5) << oname << "Reserving space for 16 * 201 * BLOCK_COUNT_MAX bytes";
 //   newfrag.addSpace(mu2e::BLOCK_COUNT_MAX * 16 * 201);
 
-  _dtc->GetDevice()->ResetDeviceTime();
+  _dev->ResetDeviceTime();
   size_t totalSize = 0;
+//-----------------------------------------------------------------------------
+// the fragment comes from the pool with its payload capacity already mapped,
+// reserve the predicted size at once instead of growing it block by block
+//-----------------------------------------------------------------------------
+  artdaq::FragmentPtr frag = newFragment_(ev_counter());
+
+  mu2eFragmentWriter newfrag(*frag);
+  newfrag.addSpace(_fragmentPool->predictedBytes());
   //  bool first = true;
 
 //   while (newfrag.hdr_block_count() < mu2e::BLOCK_COUNT_MAX) {
@@ -317,10 +713,10 @@ bool mu2e::TrackerVST::getNext_(artdaq::FragmentPtrs& frags) {
 //       break;
 //     }
 
-  TLOG(TLVL_TRACE + 5) << oname << "Getting DTC Data for block " 
+  TRK_LOG(TrackerLog::kTrace, oname << "Getting DTC Data for block " 
     // << newfrag.hdr_block_count() 
 		       << "/" << mu2e::BLOCK_COUNT_MAX
-		       << ", sz=" << totalSize;
+		       << ", sz=" << totalSize);
 
   // std::vector<std::unique_ptr<DTCLib::DTC_Event>> data;
   // int retryCount = 5;
@@ -409,7 +805,7 @@ bool mu2e::TrackerVST::getNext_(artdaq::FragmentPtrs& frags) {
 //     newfrag.endSubEvt(offset - newfrag.dataEndBytes());
 //   }
   
-  TLOG(TLVL_TRACE + 5) << oname << "Incrementing event counter";
+  TRK_LOG(TrackerLog::kTrace, oname << "Incrementing event counter");
   ev_counter_inc();
   
 //   TLOG(TLVL_TRACE + 5) << oname << "Reporting Metrics";
@@ -429,31 +825,42 @@ bool mu2e::TrackerVST::getNext_(artdaq::FragmentPtrs& frags) {
 //-----------------------------------------------------------------------------
 // try to go simple way first - just copy code from Mu2eUtil
 //-----------------------------------------------------------------------------
-  unsigned long timestampOffset = 1;
+  unsigned long timestampOffset = (_windows) ? _nextTag : 1;
 
   //  _cfo->SendRequestForTimestamp(DTC_EventWindowTag(timestampOffset + 1, _heartbeatsAfter));
 
 //-----------------------------------------------------------------------------
 // to begin with, reproduce Monica's var_pattern_config
 //-----------------------------------------------------------------------------
-  monica_var_pattern_config();
+  if ((_windows == nullptr) or _firstTime) {
+    monica_var_pattern_config();
+    if (_windows) _windows->reset(timestampOffset);
+    if (_dmaTuner) _dmaTuner->invalidate();
+  }
 
-  auto device   = _dtc->GetDevice();
+  if (_dmaTuner) _dmaTuner->apply(_dev);
+
+  auto device   = _dev;
   //  auto initTime = device->GetDeviceTime();
   device->ResetDeviceTime();
 
   // auto afterInit = std::chrono::steady_clock::now();
   if (_firstTime) {
-    int  requests_ahead(0);
+    int  requests_ahead(_rateController->requestsAhead());
     bool increment_time_stamp(true);
-    uint cfo_delay(200);
+    uint cfo_delay(_rateController->requestDelay());
 
-    _cfo->SendRequestsForRange(_nbuffers, 
-			       DTC_EventWindowTag(timestampOffset), 
+    _dev->SendRequestsForRange(_nbuffers, 
+			       DTC_EventWindowTag(uint64_t(timestampOffset)), 
 			       increment_time_stamp, 
 			       cfo_delay, 
 			       requests_ahead, 
 			       _heartbeatsAfter);
+    _rateController->requestSent(_nbuffers);
+    if (_dmaTuner) _dmaTuner->requestSent(_nbuffers);
+    if (_tracer) {
+      for (int i=0; i<_nbuffers; i++) _tracer->record(TrackerLatencyTracer::kRequest, timestampOffset+i);
+    }
     _firstTime = 0;
   }
   
@@ -465,29 +872,130 @@ bool mu2e::TrackerVST::getNext_(artdaq::FragmentPtrs& frags) {
   // mu2e_databuff_t* buffer;
 
   printROCRegisters();
+  if (_rocMonitor and _rocMonitor->fifoFullSeen()) _rateController->setFifoFull();
 
   // TLOG(TLVL_TRACE) << "util - before read for DAQ";
   // sts = device->read_data(DTC_DMA_Engine_DAQ, reinterpret_cast<void**>(&buffer), tmo_ms);
   // TLOG(TLVL_TRACE) << "util - after read for DAQ sts=" << sts << ", buffer=" << (void*)buffer;
   uint extraReads(1);
+  uint ndev   = (_multiDev) ? _multiDev->nDevices() : 1;
+  uint nwin   = _nbuffers + extraReads;  // event windows requested
+  uint nreads = nwin*ndev;               // one buffer per window and DTC
+  uint nsent  = 0;
+  uint nretry = 0;                      // re-requested windows, one more read per DTC each
+  std::vector<uint64_t> retryTags;
+                                        // the reads of the window being collected, one per DTC
+  uint   winReads   = 0;
+  size_t winBytes   = 0;
+  bool   winTimeout = false;
+  double winTime    = 0;
+
+  for (unsigned i=0; i<nreads+nretry; ++i) {
+//-----------------------------------------------------------------------------
+// keep up to 1+requestsAhead requests in flight, the rate controller decides how many
+//-----------------------------------------------------------------------------
+    while ((nsent < nwin) and (nsent*ndev <= i + _rateController->requestsAhead()*ndev)) {
+//-----------------------------------------------------------------------------
+// memory budget full: no new request while one is in flight
+//-----------------------------------------------------------------------------
+      if (_budget->full() and (nsent*ndev > i)) {
+        _budget->requestDeferred();
+        break;
+      }
+      // auto startRequest = std::chrono::steady_clock::now();
+      _dev->SendRequestForTimestamp(DTC_EventWindowTag(uint64_t(timestampOffset+nsent)), _heartbeatsAfter);
+      if (_tracer) _tracer->record(TrackerLatencyTracer::kRequest, timestampOffset+nsent);
+      if (_windows) _windows->requested(timestampOffset+nsent);
+      _rateController->requestSent();
+      if (_dmaTuner) _dmaTuner->requestSent();
+      nsent++;
+      // auto endRequest = std::chrono::steady_clock::now();
+      // readoutRequestTime +=
+      //   std::chrono::duration_cast<std::chrono::duration<double, std::ratio<1>>>(endRequest - startRequest).count();
+    }
 
-  for (unsigned i=0; i<_nbuffers + extraReads; ++i) {
-
-    // auto startRequest = std::chrono::steady_clock::now();
-    _cfo->SendRequestForTimestamp(DTC_EventWindowTag(timestampOffset+i, _heartbeatsAfter));
-    // auto endRequest = std::chrono::steady_clock::now();
-    // readoutRequestTime +=
-    //   std::chrono::duration_cast<std::chrono::duration<double, std::ratio<1>>>(endRequest - startRequest).count();
-
-    TLOG(TLVL_DEBUG + 4) << "Buffer Read " << std::dec << i << std::endl;
+    TRK_LOG(TrackerLog::kTrace, "Buffer Read " << std::dec << i);
     
+    auto readStart = std::chrono::steady_clock::now();
     mu2e_databuff_t* buffer = readDTCBuffer(device, readSuccess, timeout, sts, false);
+    double readTime = std::chrono::duration<double>(std::chrono::steady_clock::now()-readStart).count();
+
+//-----------------------------------------------------------------------------
+// requests are counted per window: with several DTCs the rate controller and
+// the tuner see one read per window, once all the DTCs have been read
+//-----------------------------------------------------------------------------
+    winBytes   += sts;
+    winTimeout  = winTimeout or timeout or (sts == 0);
+    winTime    += readTime;
+    if (++winReads == ndev) {
+      _rateController->readDone(winBytes, winTimeout);
+      if (_dmaTuner) _dmaTuner->readDone(winBytes, winTimeout, winTime);
+      winReads   = 0;
+      winBytes   = 0;
+      winTimeout = false;
+      winTime    = 0;
+    }
+
+    if (_windows) {
+//-----------------------------------------------------------------------------
+// with several DTCs the window continuity is followed on the first one
+//-----------------------------------------------------------------------------
+      if (readSuccess and (not timeout)) {
+	if ((_multiDev == nullptr) or (_multiDev->lastSource() == 0)) _windows->received(eventWindowTag_(buffer));
+      }
+      else {
+	_windows->timedOut();
+      }
+
+      retryTags.clear();
+      _windows->retries(retryTags);
+      for (uint64_t tag : retryTags) {
+	TRK_LOG(TrackerLog::kDebug, "re-request event window " << tag);
+	_dev->SendRequestForTimestamp(DTC_EventWindowTag(tag), _heartbeatsAfter);
+	_windows->requested(tag);
+	_rateController->requestSent();
+	if (_dmaTuner) _dmaTuner->requestSent();
+	nretry += ndev;
+      }
+    }
+
+    BufferSlot* slot = nullptr;
+    if (readSuccess and (not timeout)) {
+      uint64_t tag = eventWindowTag_(buffer);
+      if (_eventCache) _eventCache->insert(tag, buffer, sts, (_multiDev) ? _multiDev->lastSource() : 0);
+//-----------------------------------------------------------------------------
+// when serving requests, fragments are built from the cache in serveRequests_.
+// With link_merge, the merger keeps a copy of the ROC blocks and the DMA
+// buffer can go back right away
+//-----------------------------------------------------------------------------
+      if (not _serveRequests) {
+	if (_linkMerger) {
+	  if (sts > 8) _linkMerger->add(reinterpret_cast<const uint8_t*>(buffer)+8, sts-8);
+	  addMerged_(*frag, newfrag, false);
+	}
+	else {
+	  if (newfrag.hdr_block_count() == 0) frag->setTimestamp(tag);
+	  slot = addBuffer_(newfrag, buffer, sts);
+	}
+      }
+    }
     
-    DTCLib::Utilities::PrintBuffer(buffer, sts, 128);
-    
-    device->read_release(DTC_DMA_Engine_DAQ, 1);
+    if ((TRK_LOG_MAX_LEVEL >= TrackerLog::kTrace) and TrackerLog::enabled(TrackerLog::kTrace)) {
+      DTCLib::Utilities::PrintBuffer(buffer, sts, 128);
+    }
+//-----------------------------------------------------------------------------
+// the DMA buffers go back in read order, each one once its task has copied it.
+// A read which got no buffer (sts=0) has nothing to give back: releasing for
+// it would return the next buffer, maybe still being copied
+//-----------------------------------------------------------------------------
+    if (sts > 0) {
+      _held.push_back(std::make_pair(slot, sts));
+      _budget->reserve(TrackerMemoryBudget::kDmaBuffers, sts);
+    }
+    releaseBuffers_(device, _budget->full() ? 0 : _maxHeldBuffers);
+    updateBudget_(&newfrag);
 
-    int delay = 200;
+    size_t delay = _rateController->delayUs();
     if (delay > 0) usleep(delay);
   }
   // if (sts > 0)    {
@@ -519,9 +1027,45 @@ bool mu2e::TrackerVST::getNext_(artdaq::FragmentPtrs& frags) {
   //   }
   // }
   
-  device->read_release(DTC_DMA_Engine_DAQ, 1);
+  _taskPool->wait();
+  releaseBuffers_(device, 0);
+
+//-----------------------------------------------------------------------------
+// too many windows lost in a row: reset the link and start over
+//-----------------------------------------------------------------------------
+  if (_windows) {
+    _nextTag = timestampOffset+nsent;
+    if (_windows->resetNeeded()) {
+      TLOG(TLVL_WARNING) << "event windows lost in a row, reset the link before window " << _nextTag;
+      monica_var_pattern_config();
+      _windows->reset(_nextTag);
+      if (_dmaTuner) _dmaTuner->invalidate();
+      _nLinkResets++;
+    }
+  }
 
   device->release_all(DTC_DMA_Engine_DAQ);
+//-----------------------------------------------------------------------------
+// windows past their timeout go out now. Without window recovery the tags
+// start over on the next call: send everything and forget the streams
+//-----------------------------------------------------------------------------
+  if (_linkMerger) {
+    addMerged_(*frag, newfrag, _windows == nullptr);
+    if (_windows == nullptr) _linkMerger->clear();
+  }
+
+  if (newfrag.hdr_block_count() > 0) {
+    _fragmentPool->observe(newfrag.dataEndBytes());
+    finishFragment_(*frag, newfrag, true);
+    frags.emplace_back(std::move(frag));
+    if (_tracer) for (uint64_t tag : _fragTags) _tracer->record(TrackerLatencyTracer::kEmit, tag);
+  }
+  else {
+    _fragmentPool->put(std::move(frag));
+  }
+
+  if (_serveRequests) serveRequests_(frags);
+  updateBudget_(nullptr);
   
   // auto totalBytesRead    = device->GetReadSize();
   // auto totalBytesWritten = device->GetWriteSize();
@@ -590,11 +1134,84 @@ bool mu2e::TrackerVST::getNext_(artdaq::FragmentPtrs& frags) {
   //   }
   // }
   
-  TLOG(TLVL_DEBUG) << oname << "after readDTC: suceess=" << readSuccess << " timeout: "<< timeout;
+  TRK_LOG(TrackerLog::kDebug, oname << "after readDTC: suceess=" << readSuccess << " timeout: "<< timeout);
+
+  if (metricMan) {
+    metricMan->sendMetric("Request Delay"   , _rateController->delayUs()        , "us"      , 1, artdaq::MetricMode::LastPoint);
+    metricMan->sendMetric("Requests Ahead"  , _rateController->requestsAhead()  , "requests", 1, artdaq::MetricMode::LastPoint);
+    metricMan->sendMetric("Read Latency"    , _rateController->meanLatencyUs()  , "us"      , 1, artdaq::MetricMode::Average);
+    metricMan->sendMetric("Timeout Fraction", _rateController->timeoutFraction(), ""        , 1, artdaq::MetricMode::Average);
+    metricMan->sendMetric("Fragment Size Predicted", _fragmentPool->predictedBytes(), "bytes"    , 1, artdaq::MetricMode::LastPoint);
+    metricMan->sendMetric("Fragments Grown"        , _fragmentPool->nGrown()        , "fragments", 1, artdaq::MetricMode::LastPoint);
+    metricMan->sendMetric("Fragment Pool Empty"    , _fragmentPool->nEmpty()        , "fragments", 1, artdaq::MetricMode::LastPoint);
+    metricMan->sendMetric("Memory Used"            , _budget->used()                , "bytes"    , 1, artdaq::MetricMode::LastPoint);
+    metricMan->sendMetric("Memory High Water"      , _budget->highWater()           , "bytes"    , 1, artdaq::MetricMode::LastPoint);
+    for (int k=0; k<TrackerMemoryBudget::kNStages; k++) {
+      std::string name = std::string("Memory ")+TrackerMemoryBudget::stageName(k);
+      metricMan->sendMetric(name              , _budget->used(k)     , "bytes", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric(name+" High Water", _budget->highWater(k), "bytes", 1, artdaq::MetricMode::LastPoint);
+    }
+    if (_budget->limitBytes() > 0) {
+      metricMan->sendMetric("Memory Budget Full"   , _budget->nFull()               , "times"    , 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Requests Deferred"    , _budget->nDeferred()           , "requests" , 1, artdaq::MetricMode::LastPoint);
+    }
+    if (_eventCache) {
+      metricMan->sendMetric("Requests Served"  , _nRequestsServed         , "requests", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Windows Missed"   , _nWindowsMissed          , "windows" , 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Windows Too Long" , _eventCache->nTooLong()  , "windows" , 1, artdaq::MetricMode::LastPoint);
+    }
+    if (_hitDecoder) {
+      metricMan->sendMetric("Hits Decoded"     , _hitDecoder->nDecoded()    , "hits", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Hits Masked"      , _hitDecoder->nMasked()     , "hits", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Hits Below Charge", _hitDecoder->nBelowCharge(), "hits", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Hits Bad"         , _hitDecoder->nBadHits()    , "hits", 1, artdaq::MetricMode::LastPoint);
+    }
+    metricMan->sendMetric("Events Corrupt"     , _nCorrupt                  , "events", 1, artdaq::MetricMode::LastPoint);
+    if (_windows) {
+      metricMan->sendMetric("Windows Missing"  , _windows->nMissing()       , "windows", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Windows Retried"  , _windows->nRetried()       , "windows", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Windows Recovered", _windows->nRecovered()     , "windows", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Windows Lost"     , _windows->nLost()          , "windows", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Windows Dropped"  , _windows->nDropped()       , "windows", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Link Resets"      , _nLinkResets               , "resets" , 1, artdaq::MetricMode::LastPoint);
+    }
+    if (_linkMerger) {
+      metricMan->sendMetric("Windows Merged"     , _linkMerger->nMerged()       , "windows", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Windows Incomplete" , _linkMerger->nIncomplete()   , "windows", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Link Blocks Missing", _linkMerger->nMissingBlocks(), "blocks" , 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("Link Blocks Late"   , _linkMerger->nLateBlocks()   , "blocks" , 1, artdaq::MetricMode::LastPoint);
+    }
+    if (_registerCache) {
+      metricMan->sendMetric("ROC Register Cache Hit Rate", _registerCache->rocCache().hitRate(), "", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("DTC Register Cache Hit Rate", _registerCache->dtcCache().hitRate(), "", 1, artdaq::MetricMode::LastPoint);
+    }
+    if (_dcs) {
+      metricMan->sendMetric("DCS Wait Normal"  , _dcs->meanWaitUs(TrackerDcsScheduler::kNormal), "us", 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("DCS Wait Low"     , _dcs->meanWaitUs(TrackerDcsScheduler::kLow)   , "us", 1, artdaq::MetricMode::LastPoint);
+    }
+    if (_dmaTuner and _dmaTuner->tuning()) {
+      metricMan->sendMetric("DTC Tuning Point" , _dmaTuner->point()         , "points" , 1, artdaq::MetricMode::LastPoint);
+    }
+    if (_multiDev) {
+      metricMan->sendMetric("DTC Idle Polls"   , _multiDev->nIdlePolls()    , "polls" , 1, artdaq::MetricMode::LastPoint);
+      metricMan->sendMetric("DTC Stray Releases", _multiDev->nStrayReleases(), "releases", 1, artdaq::MetricMode::LastPoint);
+    }
+    if (_taskPool->nThreads() > 0) {
+      metricMan->sendMetric("Tasks Stolen"     , _taskPool->nStolen()       , "tasks" , 1, artdaq::MetricMode::LastPoint);
+    }
+  }
+
+  if (_status) publishStatus_();
+//-----------------------------------------------------------------------------
+// top up the fragment pool after the readout, not in the middle of it
+//-----------------------------------------------------------------------------
+  _fragmentPool->refill();
+
+  _lastReturnTime = std::chrono::steady_clock::now();
 
   // device->read_release(DTC_DMA_Engine_DAQ, 1);
   
-  TLOG(TLVL_TRACE + 5) << oname << "P.Murat: END of getNext_, return true";
+  TRK_LOG(TrackerLog::kDebug, oname << "P.Murat: END of getNext_, return true");
   return true;
 }
 
@@ -617,32 +1234,75 @@ void mu2e::TrackerVST::printROCRegisters() {
 
   TLOG(TLVL_DEBUG) << "-------------- mu2e::TrackerVst::" << __func__ ;
 
-  // Monica starts from disabling EWM's : my_cntl write 0x91a8 0x0
+  roc_data_t r[256]; 
 
-  _dtc->WriteRegister_(0,DTC_Register_CFOEmulation_HeartbeatInterval); // 0x91a8
+  int tmo_ms(10);
 
-// step 1 : read everything : registers 0,8,18,23-59,64,65
+  if (_dcs) {
+//-----------------------------------------------------------------------------
+// with the scheduler, the markers stay on: the reads are queued at low
+// priority and reported by the first call which finds them all done
+//-----------------------------------------------------------------------------
+    if (not _rocReads.empty()) {
+      for (auto& rd : _rocReads) {
+	if (rd.second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+      }
 
-  roc_data_t r[256]; 
+      try {
+	for (auto& rd : _rocReads) r[rd.first] = rd.second.get();
+	_rocReads.clear();
+      }
+      catch (std::exception const& e) {
+	TLOG(TLVL_WARNING) << "ROC register read failed: " << e.what();
+	_rocReads.clear();
+	return;
+      }
+      reportROCRegisters_(r);
+    }
 
-  int tmo_ms(10);
+    std::vector<int> address{0, 8, 18, 64, 65};
+    for (int i=23; i<60; i++) address.push_back(i);
+
+    DtcDevice* dev = _dcsDevice;
+    for (int i : address) {
+      _rocReads.emplace_back(i, _dcs->submit(TrackerDcsScheduler::kLow,
+					     [dev, i, tmo_ms] { return dev->ReadROCRegister(DTC_Link_0, i, tmo_ms); }));
+    }
+    return;
+  }
+
+  // Monica starts from disabling EWM's : my_cntl write 0x91a8 0x0
 
-  r[ 0]  = _dtc->ReadROCRegister(DTC_Link_0, 0,tmo_ms);
-  r[ 8]  = _dtc->ReadROCRegister(DTC_Link_0, 8,tmo_ms);
-  r[18]  = _dtc->ReadROCRegister(DTC_Link_0,18,tmo_ms);
+  _dev->WriteRegister(0,DTC_Register_CFOEmulation_HeartbeatInterval); // 0x91a8
+
+// step 1 : read everything : registers 0,8,18,23-59,64,65
+
+  r[ 0]  = _dev->ReadROCRegister(DTC_Link_0, 0,tmo_ms);
+  r[ 8]  = _dev->ReadROCRegister(DTC_Link_0, 8,tmo_ms);
+  r[18]  = _dev->ReadROCRegister(DTC_Link_0,18,tmo_ms);
 
   for (int i=23; i<60; i++) {
-    r[i] = _dtc->ReadROCRegister(DTC_Link_0, i,tmo_ms);
+    r[i] = _dev->ReadROCRegister(DTC_Link_0, i,tmo_ms);
   }
 
-  r[64]  = _dtc->ReadROCRegister(DTC_Link_0,64,tmo_ms);
-  r[65]  = _dtc->ReadROCRegister(DTC_Link_0,65,tmo_ms);
+  r[64]  = _dev->ReadROCRegister(DTC_Link_0,64,tmo_ms);
+  r[65]  = _dev->ReadROCRegister(DTC_Link_0,65,tmo_ms);
+
+  reportROCRegisters_(r);
+}
+
+//-----------------------------------------------------------------------------
+// registers 0,8,18,23-59,64,65 of link 0
+//-----------------------------------------------------------------------------
+void mu2e::TrackerVST::reportROCRegisters_(const roc_data_t* r) {
 //-----------------------------------------------------------------------------
 // now the hard part - formatted printout
 //-----------------------------------------------------------------------------
   int w1                  = (r[24]<<16) | r[23] ;
   int w2                  = (r[26]<<16) | r[25] ;
   int n_evm_seen          = (r[65]<<16) | r[64] ;
+
+  if (w1 & (1 << 28)) _rateController->setFifoFull();     // SIZE_FIFO_FULL
   int n_hbt_seen          = (r[28]<<16) | r[27] ;
   int n_null_hbt          = (r[30]<<16) | r[29] ;
   int n_hbt_hold          = (r[32]<<16) | r[31] ;
@@ -682,6 +1342,96 @@ void mu2e::TrackerVST::printROCRegisters() {
 		   << std::endl 
                    << "Last spill tag)     : 0x" << std::hex << last_spill_tag
     ;
+//-----------------------------------------------------------------------------
+// already read, export them as they are
+//-----------------------------------------------------------------------------
+  if (_status) {
+    uint16_t address[64];
+    uint32_t value  [64];
+    size_t   n = 0;
+
+    for (int i : {0, 8, 18}) { address[n] = i; value[n] = r[i]; n++; }
+    for (int i=23; i<60; i++) { address[n] = i; value[n] = r[i]; n++; }
+    for (int i : {64, 65})    { address[n] = i; value[n] = r[i]; n++; }
+
+    _status->publishRegisters(_statusBlock[2], address, value, n);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// readout state every call, DTC registers (PCIe, no DCS) and ROC rates at most
+// once per interval
+//-----------------------------------------------------------------------------
+void mu2e::TrackerVST::publishStatus_() {
+  double readout[] = {
+    double(_rateController->delayUs()),
+    double(_rateController->requestsAhead()),
+    double(_rateController->meanLatencyUs()),
+    double(_rateController->timeoutFraction()),
+    double(_fragmentPool->predictedBytes()),
+    double(_fragmentPool->nGrown()),
+    double(_fragmentPool->nEmpty()),
+    double(_nRequestsServed),
+    double(_nWindowsMissed),
+    double(_budget->used()),
+    double(_budget->highWater()),
+    double(_budget->nDeferred())
+  };
+  _status->publishValues(_statusBlock[0], readout, sizeof(readout)/sizeof(double));
+
+  auto now = std::chrono::steady_clock::now();
+  if (now-_lastStatusTime < std::chrono::milliseconds(_statusInterval)) return;
+  _lastStatusTime = now;
+
+  std::vector<uint32_t> value(_statusDtcRegisters.size());
+  if (_dcs) {
+//-----------------------------------------------------------------------------
+// with the scheduler the DTC registers are read at low priority, published by
+// the first call which finds the reads done, then read again
+//-----------------------------------------------------------------------------
+    bool done = true;
+    for (auto& rd : _statusReads) {
+      done = done and (rd.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    }
+
+    if (done) {
+      if (not _statusReads.empty()) {
+	try {
+	  for (size_t i=0; i<_statusReads.size(); i++) value[i] = _statusReads[i].get();
+	  _status->publishRegisters(_statusBlock[1], _statusDtcRegisters.data(), value.data(), value.size());
+	}
+	catch (std::exception const& e) {
+	  TLOG(TLVL_WARNING) << "DTC register read failed: " << e.what();
+	}
+	_statusReads.clear();
+      }
+
+      DtcDevice* dev = _dcsDevice;
+      for (uint16_t address : _statusDtcRegisters) {
+	_statusReads.push_back(_dcs->submit(TrackerDcsScheduler::kLow,
+					    [dev, address] { return dev->ReadRegister(DTC_Register(address)); }));
+      }
+    }
+  }
+  else {
+    for (size_t i=0; i<_statusDtcRegisters.size(); i++) {
+      value[i] = _dev->ReadRegister(DTC_Register(_statusDtcRegisters[i]));
+    }
+    _status->publishRegisters(_statusBlock[1], _statusDtcRegisters.data(), value.data(), value.size());
+  }
+
+  if (_rocMonitor) {
+    TrackerRocMonitor::Sample sample;
+    for (size_t i=0; i<_rocMonitor->links().size(); i++) {
+      if (not _rocMonitor->last(_rocMonitor->links()[i], sample)) continue;
+
+      double rate[TrackerRocMonitor::kNCounters+1];
+      for (int k=0; k<TrackerRocMonitor::kNCounters; k++) rate[k] = sample.rate[k];
+      rate[TrackerRocMonitor::kNCounters] = sample.flags;
+
+      _status->publishValues(_statusRateBlock[i], rate, TrackerRocMonitor::kNCounters+1);
+    }
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -695,30 +1445,32 @@ void mu2e::TrackerVST::monica_var_pattern_config() {
   int tmo_ms(1500);
   TLOG(TLVL_DEBUG) << "-------------- mu2e::TrackerVst::" << __func__ ;
 
-  // 1. disable EWM
-  _dtc->WriteRegister_(0,DTC_Register_CFOEmulation_HeartbeatInterval); // 0x91a8
-
-  // 2. reset link
-  _dtc->WriteROCRegister(DTC_Link_0,14, 0x1, false, tmo_ms);
+  // 1. disable EWM, 2. reset link : with the DCS scheduler the markers stay on,
+  // both only before the first data request (a later call, after lost windows,
+  // redoes the ROC setup only)
+  if ((_dcs == nullptr) or _firstTime) {
+    _dev->WriteRegister(0,DTC_Register_CFOEmulation_HeartbeatInterval); // 0x91a8
+    _dev->WriteROCRegister(DTC_Link_0,14, 0x1, false, tmo_ms);
+  }
   
   // 3. setup ROC for simulated increasing counter pattern
-  _dtc->WriteROCRegister(DTC_Link_0, 8,0x10,false,tmo_ms);
+  _dev->WriteROCRegister(DTC_Link_0, 8,0x10,false,tmo_ms);
 
   // 4. set mode, mode=0: STATUS_BIT=0x55
-  _dtc->WriteROCRegister(DTC_Link_0,30,0x0,false,tmo_ms);
+  _dev->WriteROCRegister(DTC_Link_0,30,0x0,false,tmo_ms);
 }
 
 //-----------------------------------------------------------------------------
 // this is to make an organized transition
 //-----------------------------------------------------------------------------
-mu2e_databuff_t* mu2e::TrackerVST::readDTCBuffer(mu2edev* device, bool& readSuccess, bool& timeout, 
+mu2e_databuff_t* mu2e::TrackerVST::readDTCBuffer(DtcDevice* device, bool& readSuccess, bool& timeout, 
 						 size_t& sts, bool continuedMode) {
   mu2e_databuff_t* buffer;
   auto tmo_ms = 1500;
   readSuccess = false;
-  TLOG(TLVL_TRACE) << "util - before read for DAQ";
+  TRK_LOG(TrackerLog::kTrace, "util - before read for DAQ");
   sts = device->read_data(DTC_DMA_Engine_DAQ, reinterpret_cast<void**>(&buffer), tmo_ms);
-  TLOG(TLVL_TRACE) << "util - after read for DAQ sts=" << sts << ", buffer=" << (void*)buffer;
+  TRK_LOG(TrackerLog::kTrace, "util - after read for DAQ sts=" << sts << ", buffer=" << (void*)buffer);
   
   if (sts > 0)    {
     readSuccess = true;
@@ -726,11 +1478,9 @@ mu2e_databuff_t* mu2e::TrackerVST::readDTCBuffer(mu2edev* device, bool& readSucc
     uint16_t bufSize = static_cast<uint16_t>(*static_cast<uint64_t*>(readPtr));
     readPtr = static_cast<uint8_t*>(readPtr) + 8;
 
-    TLOG(TLVL_DEBUG + 4) << "Buffer reports DMA size of " 
+    TRK_LOG(TrackerLog::kTrace, "Buffer reports DMA size of " 
 			 << std::dec << bufSize << " bytes. Device driver reports read of "
-			 << sts << " bytes," << std::endl;
-    
-    TLOG(TLVL_TRACE) << "util - bufSize is " << bufSize;
+			 << sts << " bytes");
 
     timeout = false;
     if (!continuedMode && sts > sizeof(DTC_EventHeader) + sizeof(DTC_SubEventHeader) + 8) {
@@ -739,10 +1489,10 @@ mu2e_databuff_t* mu2e::TrackerVST::readDTCBuffer(mu2edev* device, bool& readSucc
       std::vector<size_t> wordsToCheck{ 1, 2, 3, 7, 8 };
       for (auto& word : wordsToCheck) 	{
 	auto wordPtr = static_cast<uint16_t*>(readPtr) + (word - 1);
-	TLOG(TLVL_TRACE + 1) << word << (word == 1 ? "st" : word == 2 ? "nd"
+	TRK_LOG(TrackerLog::kTrace, word << (word == 1 ? "st" : word == 2 ? "nd"
 					 : word == 3 ? "rd"
 					 : "th")
-			     << " word of buffer: " << *wordPtr;
+			     << " word of buffer: " << *wordPtr);
 	if (*wordPtr == 0xcafe || *wordPtr == 0xdead) 	  {
 	  TLOG(TLVL_WARNING) << "Buffer Timeout detected! " 
 			     << word << (word == 1 ? "st" : word == 2 ? "nd"
@@ -754,10 +1504,285 @@ mu2e_databuff_t* mu2e::TrackerVST::readDTCBuffer(mu2edev* device, bool& readSucc
 	}
       }
     }
+    if (_tracer and (not timeout)) _tracer->record(TrackerLatencyTracer::kDma, eventWindowTag_(buffer));
   }
   return buffer;
 }
 
 
+//-----------------------------------------------------------------------------
+// a DTC and its software CFO, configured the same way for all the DTCs read
+//-----------------------------------------------------------------------------
+mu2e::DtcDevice* mu2e::TrackerVST::openDtc_(fhicl::ParameterSet const& ps, int DtcId, DTC*& Dtc, DTCSoftwareCFO*& Cfo) {
+  Dtc = new DTC(mode_,DtcId,roc_mask_,
+		"", 
+		false, 
+		ps.get<std::string>("simulator_memory_file_name","mu2esim.bin"));
+    
+  fhicl::ParameterSet cfoConfig = ps.get<fhicl::ParameterSet>("cfo_config", fhicl::ParameterSet());
+    
+  Cfo = new DTCSoftwareCFO(Dtc, 
+			   cfoConfig.get<bool>("use_dtc_cfo_emulator", true), 
+			   cfoConfig.get<size_t>("debug_packet_count", 0), 
+			   DTC_DebugTypeConverter::ConvertToDebugType(cfoConfig.get<std::string>("debug_type", "2")), 
+			   cfoConfig.get<bool>("sticky_debug_type", false), 
+			   cfoConfig.get<bool>("quiet", false), 
+			   cfoConfig.get<bool>("asyncRR", false), 
+			   cfoConfig.get<bool>("force_no_debug_mode", false), 
+			   cfoConfig.get<bool>("useCFODRP", false));
+
+  return new DtcHardwareDevice(Dtc, Cfo);
+}
+
+//-----------------------------------------------------------------------------
+// the 8-byte DMA byte count is followed by the DTC event header
+//-----------------------------------------------------------------------------
+uint64_t mu2e::TrackerVST::eventWindowTag_(const mu2e_databuff_t* Buffer) {
+  auto eh = reinterpret_cast<const DTC_EventHeader*>(reinterpret_cast<const uint8_t*>(Buffer) + 8);
+  return (uint64_t(eh->event_tag_high) << 32) | eh->event_tag_low;
+}
+
+//-----------------------------------------------------------------------------
+// copy one DTC event into the next block of the fragment, grow it only if
+// the size predictor was short
+//-----------------------------------------------------------------------------
+mu2e::TrackerVST::BufferSlot* mu2e::TrackerVST::addBuffer_(mu2eFragmentWriter& Frag, const mu2e_databuff_t* Buffer, size_t Sts) {
+  if (Sts <= 8) return nullptr;
+
+  auto   begin  = reinterpret_cast<const uint8_t*>(Buffer) + 8;
+  size_t nbytes = Sts - 8;
+  size_t offset = Frag.dataEndBytes();
+
+  if (offset + nbytes > Frag.dataSize()) {
+//-----------------------------------------------------------------------------
+// growing may move the payload, let the copies in flight finish first
+//-----------------------------------------------------------------------------
+    _taskPool->wait();
+    TLOG(TLVL_TRACE + 8) << "growing fragment by " << offset + nbytes - Frag.dataSize() << " bytes";
+    Frag.addSpace(offset + nbytes - Frag.dataSize());
+  }
+//-----------------------------------------------------------------------------
+// the index only needs the headers, it is built from the source in read order
+//-----------------------------------------------------------------------------
+  if (_writeIndex) _index.addEvent(begin, offset, nbytes);
+  if (rawOutput_) rawOutputStream_.write((const char*) begin, nbytes);
+
+  if (_nSlots == _slots.size()) _slots.emplace_back(new BufferSlot);
+  BufferSlot* slot = _slots[_nSlots++].get();
+
+  slot->src     = begin;
+  slot->dest    = Frag.dataAtBytes(offset);
+  slot->nbytes  = nbytes;
+  slot->corrupt = false;
+  slot->hits.clear();
+  slot->waveforms.clear();
+  slot->done.store(false, std::memory_order_relaxed);
+
+  Frag.endSubEvt(nbytes);
+
+  _taskPool->submit([this, slot] { processBuffer_(slot); });
+
+  if (_tracer) {
+    uint64_t tag = eventWindowTag_(Buffer);
+    _tracer->record(TrackerLatencyTracer::kBuild, tag);
+    _fragTags.push_back(tag);
+  }
+
+  return slot;
+}
+
+//-----------------------------------------------------------------------------
+// the windows the merger has ready go into the fragment like DMA buffers;
+// _merged holds them until the fragment is finished
+//-----------------------------------------------------------------------------
+void mu2e::TrackerVST::addMerged_(artdaq::Fragment& Frag, mu2eFragmentWriter& Writer, bool Flush) {
+  while (true) {
+    if (_nMerged == _merged.size()) _merged.emplace_back();
+    std::vector<uint8_t>& ev = _merged[_nMerged];
+    if (not _linkMerger->next(ev, Flush)) break;
+
+    _nMerged++;
+    if (Writer.hdr_block_count() == 0) Frag.setTimestamp(_linkMerger->lastTag());
+    addBuffer_(Writer, reinterpret_cast<const mu2e_databuff_t*>(ev.data()), ev.size());
+  }
+}
+
+//-----------------------------------------------------------------------------
+// runs on a pool thread: everything here only touches the slot
+//-----------------------------------------------------------------------------
+void mu2e::TrackerVST::processBuffer_(BufferSlot* Slot) {
+  memcpy(Slot->dest, Slot->src, Slot->nbytes);
+//-----------------------------------------------------------------------------
+// integrity: the event, sub-event and ROC byte counts add up
+//-----------------------------------------------------------------------------
+  auto eh = reinterpret_cast<const DTC_EventHeader*>(Slot->dest);
+  Slot->corrupt = (Slot->nbytes < sizeof(DTC_EventHeader)) or (eh->inclusive_event_byte_count > Slot->nbytes);
+  if (not Slot->corrupt) {
+    size_t end = eh->inclusive_event_byte_count;
+    size_t pos = sizeof(DTC_EventHeader);
+    while ((pos + sizeof(DTC_SubEventHeader) <= end) and (not Slot->corrupt)) {
+      auto   sh      = reinterpret_cast<const DTC_SubEventHeader*>(Slot->dest+pos);
+      size_t sub_end = pos + sh->inclusive_subevent_byte_count;
+      if ((sh->inclusive_subevent_byte_count == 0) or (sub_end > end)) {
+        Slot->corrupt = true;
+        break;
+      }
+
+      size_t roc = pos + sizeof(DTC_SubEventHeader);
+      for (int i=0; i<sh->num_rocs; i++) {
+        const uint16_t* w = reinterpret_cast<const uint16_t*>(Slot->dest+roc);
+        if ((roc+16 > sub_end) or (w[0] != 16*(w[2]+1)) or (roc+w[0] > sub_end)) {
+          Slot->corrupt = true;
+          break;
+        }
+        roc += w[0];
+      }
+      pos = sub_end;
+    }
+  }
+
+  if (_hitDecoder and (not Slot->corrupt)) {
+    _hitDecoder->decode(Slot->dest, Slot->nbytes, Slot->hits, (_hitOutputWaveforms) ? &Slot->waveforms : nullptr);
+  }
+
+  Slot->done.store(true, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+// read_release(1) gives back the oldest buffer: release from the front while
+// the tasks are done, wait for the oldest one if more than MaxHeld are out
+//-----------------------------------------------------------------------------
+void mu2e::TrackerVST::releaseBuffers_(DtcDevice* Device, size_t MaxHeld) {
+  while (not _held.empty()) {
+    BufferSlot* slot = _held.front().first;
+    if (slot and (not slot->done.load(std::memory_order_acquire))) {
+      if (_held.size() <= MaxHeld) break;
+      if (not _taskPool->runOne()) std::this_thread::yield();
+      continue;
+    }
+    Device->read_release(DTC_DMA_Engine_DAQ, 1);
+    _budget->release(TrackerMemoryBudget::kDmaBuffers, _held.front().second);
+    _held.pop_front();
+  }
+}
+
+//-----------------------------------------------------------------------------
+// the stages holding their memory as a whole: the merger queues with the
+// merged events kept for reuse, the fragment pool and the fragment being built
+//-----------------------------------------------------------------------------
+void mu2e::TrackerVST::updateBudget_(mu2eFragmentWriter const* Writer) {
+  if (_linkMerger) {
+    size_t n = _linkMerger->queuedBytes();
+    for (auto const& ev : _merged) n += ev.capacity();
+    _budget->set(TrackerMemoryBudget::kLinkMerger, n);
+  }
+  _budget->set(TrackerMemoryBudget::kFragments, _fragmentPool->freeBytes() + ((Writer) ? Writer->dataSize() : 0));
+}
+
+//-----------------------------------------------------------------------------
+artdaq::FragmentPtr mu2e::TrackerVST::newFragment_(artdaq::Fragment::sequence_id_t Seq) {
+  artdaq::FragmentPtr frag = _fragmentPool->get(Seq);
+
+  auto metadata        = frag->metadata<mu2eFragment::Metadata>();
+  metadata->sim_mode   = static_cast<int>(mode_);
+  metadata->run_number = run_number();
+  metadata->board_id   = board_id_;
+
+  _index.clear();
+  _fragTags.clear();
+  _fragHits.clear();
+  _nSlots  = 0;
+  _nMerged = 0;
+  return frag;
+}
+
+//-----------------------------------------------------------------------------
+// the tasks of the fragment are done, collect their results in block order.
+// Live : the windows were just read out. A fragment served from the event
+//        cache repeats windows already counted and written to the hit file
+//-----------------------------------------------------------------------------
+void mu2e::TrackerVST::finishFragment_(artdaq::Fragment& Frag, mu2eFragmentWriter& Writer, bool Live) {
+  _taskPool->wait();
+
+  for (size_t i=0; i<_nSlots; i++) {
+    BufferSlot const* slot = _slots[i].get();
+    if (slot->corrupt and Live) _nCorrupt++;
+    _fragHits.insert(_fragHits.end(), slot->hits.begin(), slot->hits.end());
+
+    if (_hitWriter and Live) {
+      int             ns = _hitOutputWaveforms ? _hitDecoder->nSamples() : 0;
+      const uint16_t* wf = slot->waveforms.data();
+      for (auto const& h : slot->hits) {
+        _hitWriter->add(h.ewt, h.link, h.channel, h.flags, h.time[0], h.time[1], h.charge, (ns > 0) ? wf : nullptr);
+        wf += ns;
+      }
+    }
+  }
+
+                                        // the payload was sized by the predictor, ship only what is used
+  Frag.resizeBytes(sizeof(mu2eFragment::Header) + Writer.dataEndBytes());
+  writeIndex_(Frag, Writer);
+}
+
+//-----------------------------------------------------------------------------
+// append the ROC block index after the last block, the fragment ends with it,
+// see TrackerFragmentIndex.hh for the layout
+//-----------------------------------------------------------------------------
+void mu2e::TrackerVST::writeIndex_(artdaq::Fragment& Frag, mu2eFragmentWriter& Writer) {
+  if (not _writeIndex) return;
+
+  size_t offset = TrackerFragmentIndex::indexOffset(Writer.dataEndBytes());
+  Frag.resizeBytes(sizeof(mu2eFragment::Header) + offset + _index.sizeBytes());
+  _index.write(Writer.dataAtBytes(offset));
+
+  TLOG(TLVL_DEBUG + 7) << "fragment " << Frag.sequenceID() << ": " << _index.entries().size() << " ROC blocks indexed";
+}
+
+//-----------------------------------------------------------------------------
+// answer the pending artdaq data requests from the event cache, one fragment
+// per request with the windows [tag-window_before, tag+window_after], from
+// all the DTCs. A request for windows not read yet from every DTC stays
+// pending, windows no longer in the cache are counted as missed, once per
+// DTC, and the fragment goes out without them.
+// Late and repeated requests are served without touching the hardware.
+// Use artdaq request_mode "SequenceID", the fragment has the request sequence ID
+//-----------------------------------------------------------------------------
+void mu2e::TrackerVST::serveRequests_(artdaq::FragmentPtrs& Frags) {
+  auto requestBuffer = GetRequestBuffer();
+  if ((requestBuffer == nullptr) or _eventCache->empty()) return;
+
+  std::vector<TrackerEventCache::Event_t> events;
+
+  for (auto const& req : requestBuffer->GetRequests()) {
+    uint64_t tag   = req.second;
+    uint64_t first = (tag > _windowBefore) ? tag-_windowBefore : 0;
+    uint64_t last  = tag+_windowAfter;
+
+    if (last > _eventCache->newestTag()) continue;
+
+    _eventCache->findRange(first, last, events);
+    _nWindowsMissed += (last-first+1)*_eventCache->nSources() - events.size();
+
+    artdaq::FragmentPtr frag = newFragment_(req.first);
+    frag->setTimestamp(tag);
+    {
+      mu2eFragmentWriter newfrag(*frag);
+      newfrag.addSpace(_fragmentPool->predictedBytes());
+      for (auto const& ev : events) {
+	addBuffer_(newfrag, reinterpret_cast<const mu2e_databuff_t*>(ev.first), ev.second);
+      }
+      _fragmentPool->observe(newfrag.dataEndBytes());
+      finishFragment_(*frag, newfrag, false);
+    }
+    Frags.emplace_back(std::move(frag));
+    if (_tracer) for (uint64_t tag : _fragTags) _tracer->record(TrackerLatencyTracer::kEmit, tag);
+
+    requestBuffer->RemoveRequest(req.first);
+    _nRequestsServed++;
+  }
+
+  TLOG(TLVL_DEBUG + 6) << "served " << _nRequestsServed << " requests, missed " << _nWindowsMissed << " windows";
+}
+
 // The following macro is defined in artdaq's GeneratorMacros.hh header
 DEFINE_ARTDAQ_COMMANDABLE_GENERATOR(mu2e::TrackerVST)
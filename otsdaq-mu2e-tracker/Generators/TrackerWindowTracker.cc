@@ -0,0 +1,211 @@
+///////////////////////////////////////////////////////////////////////////////
+// event window continuity and re-requests, see TrackerWindowTracker.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "artdaq/DAQdata/Globals.hh"
+#define TRACE_NAME (app_name + "_TrackerWindowTracker").c_str()
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerWindowTracker.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerWindowTracker::TrackerWindowTracker(fhicl::ParameterSet const& ps) :
+    _maxRetries    (ps.get<int>   ("max_retries"     ,    2))
+  , _retryRate     (ps.get<double>("retries_per_s"   , 100.))
+  , _retryBurst    (ps.get<double>("retry_burst"     ,   16))
+  , _resetAfterLost(ps.get<int>   ("reset_after_lost",    8))
+  , _done          (kSize/64, 0)
+  , _nTries        (kSize, 0)
+  , _nReceived     (0)
+  , _nMissing      (0)
+  , _nRetried      (0)
+  , _nRecovered    (0)
+  , _nLost         (0)
+  , _nUnexpected   (0)
+  , _nDropped      (0) {
+
+  _maxRetries = std::min(std::max(_maxRetries, 0), 254);
+  reset(0);
+
+  TLOG(TLVL_INFO) << "TrackerWindowTracker: max_retries=" << _maxRetries << " retries_per_s=" << _retryRate
+                  << " retry_burst=" << _retryBurst << " reset_after_lost=" << _resetAfterLost;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerWindowTracker::reset(uint64_t Next) {
+  _next = Next;
+  _end  = Next;
+  std::fill(_done.begin()  , _done.end()  , 0);
+  std::fill(_nTries.begin(), _nTries.end(), 0);
+  _outstanding.clear();
+  _retryQueue.clear();
+
+  _tokens      = _retryBurst;
+  _tokenTime   = std::chrono::steady_clock::now();
+  _lostInRow   = 0;
+  _resetNeeded = false;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerWindowTracker::setDone_(uint64_t Tag) {
+  _done[(Tag/64) % (kSize/64)] |= uint64_t(1) << (Tag % 64);
+}
+
+//-----------------------------------------------------------------------------
+// the bit and the counter of a window are cleared when it leaves the bitmap,
+// ready for the window kSize later
+//-----------------------------------------------------------------------------
+void mu2e::TrackerWindowTracker::advance_() {
+  while ((_next < _end) and isDone_(_next)) {
+    _done[(_next/64) % (kSize/64)] &= ~(uint64_t(1) << (_next % 64));
+    _nTries[_next % kSize] = 0;
+    _next++;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerWindowTracker::requested(uint64_t Tag) {
+  if ((Tag < _next) or ((Tag < _end) and isDone_(Tag))) return;
+
+  if (Tag >= _end) {
+//-----------------------------------------------------------------------------
+// a request kSize windows or more ahead of next() pushes everything still
+// unresolved out, it counts as lost
+//-----------------------------------------------------------------------------
+    if (Tag-_next >= kSize) {
+      for (uint64_t t=_next; t<_end; t++) {
+        if (not isDone_(t)) _nLost++;
+      }
+      std::fill(_done.begin()  , _done.end()  , 0);
+      std::fill(_nTries.begin(), _nTries.end(), 0);
+      _outstanding.clear();
+      _retryQueue.clear();
+      _next = Tag;
+      _end  = Tag;
+    }
+//-----------------------------------------------------------------------------
+// windows skipped by the requests are not ours to track
+//-----------------------------------------------------------------------------
+    for (uint64_t t=_end; t<Tag; t++) setDone_(t);
+    _end = Tag+1;
+    advance_();
+  }
+
+//-----------------------------------------------------------------------------
+// kSize requests without an answer: the oldest one is not coming
+//-----------------------------------------------------------------------------
+  if (_outstanding.size() >= kSize) {
+    uint64_t t = _outstanding.front();
+    _outstanding.pop_front();
+    _nDropped++;
+    if ((t >= _next) and (not isDone_(t))) missing_(t);
+    retire_();
+  }
+
+  uint8_t& n = _nTries[Tag % kSize];
+  if (n < 255) n++;
+  _outstanding.push_back(Tag);
+}
+
+//-----------------------------------------------------------------------------
+// requests of windows done in the meantime (re-requested, then late) wait for
+// nothing
+//-----------------------------------------------------------------------------
+void mu2e::TrackerWindowTracker::retire_() {
+  while ((not _outstanding.empty()) and ((_outstanding.front() < _next) or isDone_(_outstanding.front()))) {
+    _outstanding.pop_front();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerWindowTracker::missing_(uint64_t Tag) {
+  _nMissing++;
+
+  if (_nTries[Tag % kSize] <= _maxRetries) {
+    _retryQueue.push_back(Tag);
+    return;
+  }
+
+  TLOG(TLVL_DEBUG + 5) << "window " << Tag << " lost after " << int(_nTries[Tag % kSize]) << " requests";
+  setDone_(Tag);
+  _nLost++;
+  _lostInRow++;
+  if ((_resetAfterLost > 0) and (_lostInRow >= _resetAfterLost)) {
+    _resetNeeded = true;
+    _lostInRow   = 0;
+  }
+  advance_();
+}
+
+//-----------------------------------------------------------------------------
+// the DTC answers in order: the requests in front of this one are not coming
+//-----------------------------------------------------------------------------
+void mu2e::TrackerWindowTracker::received(uint64_t Tag) {
+  _nReceived++;
+
+  if ((Tag < _next) or (Tag >= _end) or isDone_(Tag)) {
+    _nUnexpected++;
+    return;
+  }
+
+  bool outstanding = std::find(_outstanding.begin(), _outstanding.end(), Tag) != _outstanding.end();
+  if (outstanding) {
+    while (_outstanding.front() != Tag) {
+      uint64_t t = _outstanding.front();
+      _outstanding.pop_front();
+      if ((t >= _next) and (not isDone_(t))) missing_(t);
+    }
+    _outstanding.pop_front();
+  }
+//-----------------------------------------------------------------------------
+// not outstanding: already declared missing, made it anyway
+//-----------------------------------------------------------------------------
+  if ((_nTries[Tag % kSize] > 1) or (not outstanding)) _nRecovered++;
+
+  setDone_(Tag);
+  _lostInRow = 0;
+  advance_();
+  retire_();
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerWindowTracker::timedOut() {
+  while (not _outstanding.empty()) {
+    uint64_t t = _outstanding.front();
+    _outstanding.pop_front();
+    if ((t >= _next) and (not isDone_(t))) {
+      missing_(t);
+      break;
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerWindowTracker::retries(std::vector<uint64_t>& Tags) {
+  auto now = std::chrono::steady_clock::now();
+  _tokens    = std::min(_retryBurst, _tokens + _retryRate*std::chrono::duration<double>(now-_tokenTime).count());
+  _tokenTime = now;
+
+  size_t n = 0;
+  while ((not _retryQueue.empty()) and (_tokens >= 1)) {
+    uint64_t t = _retryQueue.front();
+    _retryQueue.pop_front();
+    if ((t < _next) or isDone_(t)) continue;
+
+    Tags.push_back(t);
+    _tokens -= 1;
+    _nRetried++;
+    n++;
+  }
+
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerWindowTracker::resetNeeded() {
+  bool r = _resetNeeded;
+  _resetNeeded = false;
+  return r;
+}
@@ -0,0 +1,101 @@
+#ifndef otsdaq_mu2e_tracker_Generators_TrackerWindowTracker_hh
+#define otsdaq_mu2e_tracker_Generators_TrackerWindowTracker_hh
+//-----------------------------------------------------------------------------
+// TrackerWindowTracker : event window tag continuity for TrackerVST and the
+// recovery of the windows which did not come back
+//
+// - a sliding bitmap of kSize windows from the oldest unresolved one (next())
+//   says which windows are done (received or given up): late and duplicate
+//   buffers are recognized with one bit test, next() moves over the done ones
+// - the DTC answers the requests in order, the outstanding ones are kept in
+//   request order: a buffer for a later window or a read timeout makes the
+//   windows in front of it missing right away. Entries of windows already done
+//   are retired as the front of the queue moves; at most kSize requests are
+//   kept, the oldest one is dropped (and taken as missing) to make room
+// - a missing window is re-requested up to max_retries times; re-requests
+//   are limited by a token bucket (retries_per_s, retry_burst) so a dead link
+//   doesn't flood the DTC
+// - a window out of retries is lost. reset_after_lost lost windows in a row
+//   ask for a link reset (resetNeeded()), the escalation
+//
+// window_recovery : {
+//   enabled          : false
+//   max_retries      : 2
+//   retries_per_s    : 100.
+//   retry_burst      : 16
+//   reset_after_lost : 8       # 0: never reset
+// }
+//-----------------------------------------------------------------------------
+#include "fhiclcpp/fwd.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace mu2e {
+  class TrackerWindowTracker {
+  public:
+    enum { kSize = 4096 };              // windows tracked, power of 2
+
+    TrackerWindowTracker(fhicl::ParameterSet const& ps);
+                                        // forget everything, Next is the first window to come
+    void     reset        (uint64_t Next);
+
+    void     requested    (uint64_t Tag);
+    void     received     (uint64_t Tag);
+                                        // a read without data, or with a DTC timeout marker
+    void     timedOut     ();
+                                        // missing windows to request again now, within the budget
+    size_t   retries      (std::vector<uint64_t>& Tags);
+                                        // true once per escalation
+    bool     resetNeeded  ();
+
+    uint64_t next         () const { return _next; }
+    size_t   nOutstanding () const { return _outstanding.size(); }
+
+    size_t   nReceived    () const { return _nReceived;   }
+    size_t   nMissing     () const { return _nMissing;    }
+    size_t   nRetried     () const { return _nRetried;    }
+    size_t   nRecovered   () const { return _nRecovered;  }
+    size_t   nLost        () const { return _nLost;       }
+    size_t   nUnexpected  () const { return _nUnexpected; }
+    size_t   nDropped     () const { return _nDropped;    }
+
+  private:
+    bool     isDone_      (uint64_t Tag) const { return (_done[(Tag/64) % (kSize/64)] >> (Tag % 64)) & 0x1; }
+    void     setDone_     (uint64_t Tag);
+    void     missing_     (uint64_t Tag);
+    void     advance_     ();
+    void     retire_      ();
+
+    int      _maxRetries;
+    double   _retryRate;                // tokens per second
+    double   _retryBurst;
+    int      _resetAfterLost;
+
+    uint64_t _next;                     // oldest window not done
+    uint64_t _end;                      // newest requested + 1
+    std::vector<uint64_t> _done;        // kSize bits, window Tag at bit Tag % kSize
+    std::vector<uint8_t>  _nTries;      // requests sent, per window
+    std::deque<uint64_t>  _outstanding; // in request order
+    std::deque<uint64_t>  _retryQueue;
+
+    double   _tokens;
+    std::chrono::steady_clock::time_point _tokenTime;
+
+    int      _lostInRow;
+    bool     _resetNeeded;
+
+    size_t   _nReceived;
+    size_t   _nMissing;
+    size_t   _nRetried;
+    size_t   _nRecovered;
+    size_t   _nLost;
+    size_t   _nUnexpected;
+    size_t   _nDropped;                 // outstanding requests pushed out by the cap
+  };
+}  // namespace mu2e
+
+#endif
@@ -0,0 +1,280 @@
+///////////////////////////////////////////////////////////////////////////////
+// DCS request coalescing per DTC, see TrackerDcsCoalescer.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "otsdaq-mu2e-tracker/Utilities/TrackerDcsCoalescer.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+//-----------------------------------------------------------------------------
+std::shared_ptr<mu2e::TrackerDcsCoalescer> mu2e::TrackerDcsCoalescer::get(const void* Key) {
+  static std::mutex                                                     mutex;
+  static std::map<const void*, std::weak_ptr<TrackerDcsCoalescer>>     all;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  std::shared_ptr<TrackerDcsCoalescer> c = all[Key].lock();
+  if (c == nullptr) {
+    for (auto it=all.begin(); it!=all.end(); ) {
+      if (it->second.expired()) it = all.erase(it);
+      else                      ++it;
+    }
+    c        = std::make_shared<TrackerDcsCoalescer>();
+    all[Key] = c;
+  }
+  return c;
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerDcsCoalescer::TrackerDcsCoalescer() :
+    _maxBlock     (16)
+  , _lastLink     (-1)
+  , _busyLink     (-1)
+  , _stop         (false)
+  , _nRequests    (0)
+  , _nTransactions(0)
+  , _nCoalesced   (0)
+  , _nBatched     (0) {
+
+  _thread = std::thread(&TrackerDcsCoalescer::run_, this);
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerDcsCoalescer::~TrackerDcsCoalescer() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _cv.notify_all();
+  _thread.join();
+}
+
+//-----------------------------------------------------------------------------
+// the functions of a link are not replaced under a running transaction
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDcsCoalescer::addLink(int Link, read_t Read, block_t Block, write_t Write) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _idle.wait(lock, [&] { return _busyLink != Link; });
+
+  TrackerDcsCoalescer::Link& l = _links[Link];
+  l.read  = std::move(Read);
+  l.block = std::move(Block);
+  l.write = std::move(Write);
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDcsCoalescer::removeLink(int Link) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _idle.wait(lock, [&] { return _busyLink != Link; });
+  _links.erase(Link);
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDcsCoalescer::setNoCoalesce(uint16_t Address) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _noCoalesce.insert(Address);
+}
+
+//-----------------------------------------------------------------------------
+// look back over the reads queued after the last write or block read
+//-----------------------------------------------------------------------------
+std::future<uint16_t> mu2e::TrackerDcsCoalescer::read(int Link, uint16_t Address) {
+  std::promise<uint16_t> p;
+  std::future<uint16_t>  f = p.get_future();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto l = _links.find(Link);
+    if (l == _links.end()) {
+      p.set_exception(std::make_exception_ptr(std::invalid_argument("DCS link " + std::to_string(Link) + " not registered")));
+      return f;
+    }
+    _nRequests++;
+
+    bool alone = (_noCoalesce.count(Address) > 0);
+    if (not alone) {
+      for (auto op=l->second.ops.rbegin(); (op != l->second.ops.rend()) and (op->type == kRead); ++op) {
+        if ((op->address == Address) and (not op->alone)) {
+          op->readers.push_back(std::move(p));
+          _nCoalesced++;
+          return f;
+        }
+      }
+    }
+
+    Op op;
+    op.type      = kRead;
+    op.address   = Address;
+    op.value     = 0;
+    op.increment = false;
+    op.alone     = alone;
+    op.readers.push_back(std::move(p));
+    l->second.ops.push_back(std::move(op));
+  }
+  _cv.notify_one();
+  return f;
+}
+
+//-----------------------------------------------------------------------------
+std::future<std::vector<uint16_t>> mu2e::TrackerDcsCoalescer::readBlock(int Link, uint16_t Address, uint16_t Count,
+                                                                        bool Increment) {
+  Op op;
+  op.type      = kBlock;
+  op.address   = Address;
+  op.value     = Count;
+  op.increment = Increment;
+  op.alone     = false;
+  std::future<std::vector<uint16_t>> f = op.block.get_future();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto l = _links.find(Link);
+    if (l == _links.end()) {
+      op.block.set_exception(std::make_exception_ptr(std::invalid_argument("DCS link " + std::to_string(Link) + " not registered")));
+      return f;
+    }
+    _nRequests++;
+    l->second.ops.push_back(std::move(op));
+  }
+  _cv.notify_one();
+  return f;
+}
+
+//-----------------------------------------------------------------------------
+std::future<void> mu2e::TrackerDcsCoalescer::write(int Link, uint16_t Address, uint16_t Data) {
+  Op op;
+  op.type      = kWrite;
+  op.address   = Address;
+  op.value     = Data;
+  op.increment = false;
+  op.alone     = false;
+  std::future<void> f = op.written.get_future();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto l = _links.find(Link);
+    if (l == _links.end()) {
+      op.written.set_exception(std::make_exception_ptr(std::invalid_argument("DCS link " + std::to_string(Link) + " not registered")));
+      return f;
+    }
+    _nRequests++;
+    l->second.ops.push_back(std::move(op));
+  }
+  _cv.notify_one();
+  return f;
+}
+
+//-----------------------------------------------------------------------------
+// Reads: one link, in address order. Runs of adjacent addresses go in one
+// block read; an exception goes to all the readers of the transaction
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDcsCoalescer::doReads_(Link const& L, std::vector<Op>& Reads) {
+  std::stable_sort(Reads.begin(), Reads.end(), [](Op const& A, Op const& B) { return A.address < B.address; });
+
+  size_t n        = Reads.size();
+  size_t maxBlock = _maxBlock;
+
+  for (size_t i=0; i<n; ) {
+    size_t j = i+1;
+    if (not Reads[i].alone) {
+      while ((j < n) and (j-i < maxBlock) and (not Reads[j].alone) and (Reads[j].address == Reads[j-1].address+1)) j++;
+    }
+
+    try {
+      if (j-i > 1) {
+        std::vector<uint16_t> data;
+        L.block(data, Reads[i].address, j-i, true);
+        _nTransactions++;
+        if (data.size() < j-i) throw std::runtime_error("DCS block read returned " + std::to_string(data.size()) + " words");
+        _nBatched += j-i;
+        for (size_t k=i; k<j; k++) {
+          for (auto& p : Reads[k].readers) p.set_value(data[k-i]);
+        }
+      }
+      else {
+        uint16_t value = L.read(Reads[i].address);
+        _nTransactions++;
+        for (auto& p : Reads[i].readers) p.set_value(value);
+      }
+    }
+    catch (...) {
+      std::exception_ptr e = std::current_exception();
+      for (size_t k=i; k<j; k++) {
+        for (auto& p : Reads[k].readers) p.set_exception(e);
+      }
+    }
+
+    i = j;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDcsCoalescer::run_() {
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  std::vector<Op> reads;
+
+  while (not _stop) {
+//-----------------------------------------------------------------------------
+// the next link with work, after the one served last
+//-----------------------------------------------------------------------------
+    auto l = _links.upper_bound(_lastLink);
+    for (size_t k=0; k<=_links.size(); k++, ++l) {
+      if (l == _links.end()) l = _links.begin();
+      if ((l == _links.end()) or (not l->second.ops.empty())) break;
+    }
+    if ((l == _links.end()) or l->second.ops.empty()) {
+      _cv.wait(lock);
+      continue;
+    }
+
+    Link& link = l->second;
+    _lastLink  = l->first;
+    _busyLink  = l->first;
+//-----------------------------------------------------------------------------
+// all the reads at the front of the queue, or the write / block read there
+//-----------------------------------------------------------------------------
+    reads.clear();
+    Op other;
+    bool single = (link.ops.front().type != kRead);
+    if (single) {
+      other = std::move(link.ops.front());
+      link.ops.pop_front();
+    }
+    else {
+      while ((not link.ops.empty()) and (link.ops.front().type == kRead)) {
+        reads.push_back(std::move(link.ops.front()));
+        link.ops.pop_front();
+      }
+    }
+
+    lock.unlock();
+
+    if (not single) {
+      doReads_(link, reads);
+    }
+    else if (other.type == kWrite) {
+      try {
+        link.write(other.address, other.value);
+        _nTransactions++;
+        other.written.set_value();
+      }
+      catch (...) {
+        other.written.set_exception(std::current_exception());
+      }
+    }
+    else {
+      try {
+        std::vector<uint16_t> data;
+        link.block(data, other.address, other.value, other.increment);
+        _nTransactions++;
+        other.block.set_value(std::move(data));
+      }
+      catch (...) {
+        other.block.set_exception(std::current_exception());
+      }
+    }
+
+    lock.lock();
+    _busyLink = -1;
+    _idle.notify_all();
+  }
+}
@@ -0,0 +1,112 @@
+#ifndef otsdaq_mu2e_tracker_Utilities_TrackerDcsCoalescer_hh
+#define otsdaq_mu2e_tracker_Utilities_TrackerDcsCoalescer_hh
+//-----------------------------------------------------------------------------
+// TrackerDcsCoalescer : one thread doing the ROC register (DCS) transactions
+// of all ROCs of a DTC, shared by their front-end interfaces
+//
+// - each ROC registers its link with the functions doing the transactions
+//   (single read, block read, write); requests come back through futures
+// - a read of an address already queued for the same link, with no write or
+//   block read queued after it, gets the result of that transaction
+// - the thread serves the links round-robin and takes all the reads queued
+//   for a link at once: reads of adjacent addresses become one incrementing
+//   block read of up to maxBlock words
+// - writes and block reads keep their place in the link queue, the reads
+//   queued after them are not moved in front. Addresses set with
+//   setNoCoalesce() (FIFOs) are always read on their own
+// - the requests of a link removed, or still queued when the coalescer is
+//   deleted, are dropped: their futures throw std::future_error
+//
+// get(Key) returns the coalescer of a DTC (Key: anything identifying it),
+// created on the first call and deleted with its last user
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace mu2e {
+  class TrackerDcsCoalescer {
+  public:
+    typedef std::function<uint16_t(uint16_t Address)>                                    read_t;
+    typedef std::function<void(std::vector<uint16_t>& Data, uint16_t Address, uint16_t Count,
+                               bool Increment)>                                           block_t;
+    typedef std::function<void(uint16_t Address, uint16_t Data)>                         write_t;
+
+    static std::shared_ptr<TrackerDcsCoalescer> get(const void* Key);
+
+    TrackerDcsCoalescer();
+    ~TrackerDcsCoalescer();
+
+    void   addLink      (int Link, read_t Read, block_t Block, write_t Write);
+                                        // returns once no transaction of the link is running
+    void   removeLink   (int Link);
+
+    void   setMaxBlock  (int Words) { _maxBlock = (Words > 1) ? Words : 1; }
+    void   setNoCoalesce(uint16_t Address);
+
+    std::future<uint16_t>              read     (int Link, uint16_t Address);
+    std::future<std::vector<uint16_t>> readBlock(int Link, uint16_t Address, uint16_t Count, bool Increment);
+    std::future<void>                  write    (int Link, uint16_t Address, uint16_t Data);
+
+    size_t nRequests    () const { return _nRequests;     }
+    size_t nTransactions() const { return _nTransactions; }
+                                        // reads answered by another read of the same address
+    size_t nCoalesced   () const { return _nCoalesced;    }
+                                        // reads done as part of a block read
+    size_t nBatched     () const { return _nBatched;      }
+
+  private:
+    enum Type_t { kRead, kBlock, kWrite };
+
+    struct Op {
+      Type_t                               type;
+      uint16_t                             address;
+      uint16_t                             value;           // kBlock: word count, kWrite: data
+      bool                                 increment;       // kBlock
+      bool                                 alone;           // kRead: setNoCoalesce() address
+      std::vector<std::promise<uint16_t>>  readers;         // kRead
+      std::promise<std::vector<uint16_t>>  block;           // kBlock
+      std::promise<void>                   written;         // kWrite
+    };
+
+    struct Link {
+      read_t         read;
+      block_t        block;
+      write_t        write;
+      std::deque<Op> ops;
+    };
+
+    void   run_         ();
+    void   doReads_     (Link const& L, std::vector<Op>& Reads);
+
+    std::map<int, Link>     _links;
+    std::set<uint16_t>      _noCoalesce;
+    std::atomic<int>        _maxBlock;
+    int                     _lastLink;                      // served last, round-robin
+    int                     _busyLink;                      // -1: no transaction running
+
+    std::mutex              _mutex;
+    std::condition_variable _cv;                            // work queued
+    std::condition_variable _idle;                          // a link is done
+    bool                    _stop;
+
+    std::atomic<size_t>     _nRequests;
+    std::atomic<size_t>     _nTransactions;
+    std::atomic<size_t>     _nCoalesced;
+    std::atomic<size_t>     _nBatched;
+
+    std::thread             _thread;                        // last, started by the constructor
+  };
+}  // namespace mu2e
+
+#endif
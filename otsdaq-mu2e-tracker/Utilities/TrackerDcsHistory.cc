@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////////
+// compressed DCS history, see TrackerDcsHistory.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "otsdaq-mu2e-tracker/Utilities/TrackerDcsHistory.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+  inline uint64_t mask(int N) { return (N >= 64) ? ~uint64_t(0) : (uint64_t(1) << N)-1; }
+
+//-----------------------------------------------------------------------------
+// the bits of a block, most significant bit of each word first
+//-----------------------------------------------------------------------------
+  struct BitReader {
+    std::vector<uint64_t> const& bits;
+    size_t                       pos;
+
+    uint64_t get(int N) {
+      size_t   w    = pos/64;
+      int      room = 64 - pos%64;
+      uint64_t v;
+      if (N <= room) v = (bits[w] >> (room-N)) & mask(N);
+      else {
+        int rest = N-room;
+        v = ((bits[w] & mask(room)) << rest) | (bits[w+1] >> (64-rest));
+      }
+      pos += N;
+      return v;
+    }
+  };
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerDcsHistory::TrackerDcsHistory(size_t Depth, size_t BlockSamples) :
+    _depth       (std::max<size_t>(Depth, 1))
+  , _blockSamples(std::max<size_t>(BlockSamples, 1))
+  , _nDropped    (0) {
+}
+
+//-----------------------------------------------------------------------------
+int64_t mu2e::TrackerDcsHistory::now() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+           std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDcsHistory::put_(Block& B, uint64_t Bits, int N) {
+  int room = 64 - B.nbits%64;
+  if (room == 64) B.bits.push_back(0);
+
+  Bits &= mask(N);
+  if (N <= room) B.bits.back() |= Bits << (room-N);
+  else {
+    int rest = N-room;
+    B.bits.back() |= Bits >> rest;
+    B.bits.push_back(Bits << (64-rest));
+  }
+  B.nbits += N;
+}
+
+//-----------------------------------------------------------------------------
+// first sample: time and value as they are. Then
+// - delta-of-delta of the time: '0' for 0, else '10', '110', '1110' with 7,
+//   12 and 20 bits, or '1111' and the 64 bits
+// - value XOR the previous one: '0' if the same, '10' and the bits inside
+//   the previous window of meaningful bits, or '11', 5 bits of leading zeros,
+//   6 bits of length-1 and the meaningful bits
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDcsHistory::encode_(Block& B, int64_t Time, uint64_t Value) {
+  if (B.n == 0) {
+    put_(B, uint64_t(Time), 64);
+    put_(B, Value         , 64);
+    B.first = Time;
+    B.delta = 0;
+    B.lead  = -1;
+    B.trail = 0;
+  }
+  else {
+    int64_t delta = Time - B.last;
+    int64_t dod   = delta - B.delta;
+    if      (dod == 0)                              put_(B, 0, 1);
+    else if ((dod >=     -63) and (dod <=     64)) { put_(B, 0x2, 2); put_(B, dod+63    ,  7); }
+    else if ((dod >=   -2047) and (dod <=   2048)) { put_(B, 0x6, 3); put_(B, dod+2047  , 12); }
+    else if ((dod >= -524287) and (dod <= 524288)) { put_(B, 0xe, 4); put_(B, dod+524287, 20); }
+    else                                           { put_(B, 0xf, 4); put_(B, dod       , 64); }
+    B.delta = delta;
+
+    uint64_t x = Value ^ B.value;
+    if (x == 0) put_(B, 0, 1);
+    else {
+      int lead  = std::min(__builtin_clzll(x), 31);
+      int trail = __builtin_ctzll(x);
+      if ((B.lead >= 0) and (lead >= B.lead) and (trail >= B.trail)) {
+        put_(B, 0x2, 2);
+        put_(B, x >> B.trail, 64-B.lead-B.trail);
+      }
+      else {
+        int len = 64-lead-trail;
+        put_(B, 0x3, 2);
+        put_(B, lead , 5);
+        put_(B, len-1, 6);
+        put_(B, x >> trail, len);
+        B.lead  = lead;
+        B.trail = trail;
+      }
+    }
+  }
+
+  B.last  = Time;
+  B.value = Value;
+  B.n++;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDcsHistory::decode_(Block const& B, int64_t First, int64_t Last, std::vector<Sample>& Samples) const {
+  BitReader r{B.bits, 0};
+
+  int64_t  t     = int64_t(r.get(64));
+  uint64_t v     = r.get(64);
+  int64_t  delta = 0;
+  int      lead  = 0;
+  int      trail = 0;
+
+  for (size_t i=0; i<B.n; i++) {
+    if (i > 0) {
+      int64_t dod;
+      if      (r.get(1) == 0) dod = 0;
+      else if (r.get(1) == 0) dod = int64_t(r.get( 7)) - 63;
+      else if (r.get(1) == 0) dod = int64_t(r.get(12)) - 2047;
+      else if (r.get(1) == 0) dod = int64_t(r.get(20)) - 524287;
+      else                    dod = int64_t(r.get(64));
+      delta += dod;
+      t     += delta;
+
+      if (r.get(1) == 1) {
+        if (r.get(1) == 0) v ^= r.get(64-lead-trail) << trail;
+        else {
+          lead      = r.get(5);
+          int len   = r.get(6)+1;
+          trail     = 64-lead-len;
+          v        ^= r.get(len) << trail;
+        }
+      }
+    }
+
+    if (t > Last) break;
+    if (t >= First) {
+      Sample s;
+      s.time = t;
+      memcpy(&s.value, &v, sizeof(v));
+      Samples.push_back(s);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+// a full block is trimmed and closed, the oldest ones go while the others
+// hold the depth
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDcsHistory::add(std::string const& Channel, int64_t Time, double Value) {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  TrackerDcsHistory::Channel& c = _channels[Channel];
+  if ((not c.blocks.empty()) and (Time < c.blocks.back().last)) {
+    _nDropped++;
+    return;
+  }
+
+  if (c.blocks.empty() or (c.blocks.back().n >= _blockSamples)) {
+    if (not c.blocks.empty()) c.blocks.back().bits.shrink_to_fit();
+    c.blocks.emplace_back();
+    c.blocks.back().n     = 0;
+    c.blocks.back().nbits = 0;
+  }
+
+  uint64_t bits;
+  memcpy(&bits, &Value, sizeof(bits));
+  encode_(c.blocks.back(), Time, bits);
+  c.n++;
+
+  while ((c.blocks.size() > 1) and (c.n - c.blocks.front().n >= _depth)) {
+    c.n -= c.blocks.front().n;
+    c.blocks.pop_front();
+  }
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerDcsHistory::query(std::string const& Channel, int64_t First, int64_t Last,
+                                      std::vector<Sample>& Samples) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  auto c = _channels.find(Channel);
+  if (c == _channels.end()) return 0;
+
+  size_t n = Samples.size();
+  for (Block const& b : c->second.blocks) {
+    if (b.last  < First) continue;
+    if (b.first > Last ) break;
+    decode_(b, First, Last, Samples);
+  }
+  return Samples.size() - n;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<std::string> mu2e::TrackerDcsHistory::channels() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  std::vector<std::string> names;
+  for (auto const& c : _channels) names.push_back(c.first);
+  return names;
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerDcsHistory::nSamples(std::string const& Channel) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  auto c = _channels.find(Channel);
+  return (c != _channels.end()) ? c->second.n : 0;
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerDcsHistory::bytes() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  size_t n = 0;
+  for (auto const& c : _channels) {
+    for (Block const& b : c.second.blocks) n += b.bits.size()*sizeof(uint64_t);
+  }
+  return n;
+}
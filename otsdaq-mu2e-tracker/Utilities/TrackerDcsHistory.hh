@@ -0,0 +1,81 @@
+#ifndef otsdaq_mu2e_tracker_Utilities_TrackerDcsHistory_hh
+#define otsdaq_mu2e_tracker_Utilities_TrackerDcsHistory_hh
+//-----------------------------------------------------------------------------
+// TrackerDcsHistory : recent history of DCS values (ROC registers, emulated
+// readings), one compressed ring per named channel
+//
+// - a sample is a time (us since the epoch) and a double value. Samples go
+//   into blocks of up to BlockSamples, compressed the Gorilla way: the time
+//   as the difference of consecutive deltas, the value XOR'ed with the
+//   previous one, with its meaningful bits only. A value sampled at a steady
+//   rate which changes little takes a few bits per sample
+// - a channel keeps at least its last Depth samples, whole blocks of the
+//   oldest ones are dropped. A sample older than the last one of its channel
+//   is dropped
+// - query() decodes only the blocks overlapping the time range
+// - thread-safe
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+  class TrackerDcsHistory {
+  public:
+    struct Sample {
+      int64_t time;                     // us since the epoch
+      double  value;
+    };
+
+    TrackerDcsHistory(size_t Depth, size_t BlockSamples = 128);
+
+    void   add      (std::string const& Channel, int64_t Time, double Value);
+    void   add      (std::string const& Channel, double Value) { add(Channel, now(), Value); }
+                                        // First <= time <= Last, appended in time order. Returns the number found
+    size_t query    (std::string const& Channel, int64_t First, int64_t Last, std::vector<Sample>& Samples) const;
+
+    std::vector<std::string> channels() const;
+    size_t nSamples (std::string const& Channel) const;
+                                        // compressed size of all channels
+    size_t bytes    () const;
+    size_t nDropped () const { return _nDropped; }
+
+    static int64_t now();
+
+  private:
+    struct Block {
+      int64_t               first;      // times of the first and last samples
+      int64_t               last;
+      size_t                n;
+      std::vector<uint64_t> bits;
+      size_t                nbits;
+                                        // encoder state
+      int64_t               delta;
+      uint64_t              value;
+      int                   lead;       // -1: no XOR window yet
+      int                   trail;
+    };
+
+    struct Channel {
+      std::deque<Block> blocks;
+      size_t            n;
+    };
+
+    void   put_     (Block& B, uint64_t Bits, int N);
+    void   encode_  (Block& B, int64_t Time, uint64_t Value);
+    void   decode_  (Block const& B, int64_t First, int64_t Last, std::vector<Sample>& Samples) const;
+
+    size_t                         _depth;
+    size_t                         _blockSamples;
+    std::map<std::string, Channel> _channels;
+    std::atomic<size_t>            _nDropped;
+    mutable std::mutex             _mutex;
+  };
+}  // namespace mu2e
+
+#endif
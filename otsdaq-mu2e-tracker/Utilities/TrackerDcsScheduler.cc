@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////
+// DCS transaction scheduler, see TrackerDcsScheduler.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "otsdaq-mu2e-tracker/Utilities/TrackerDcsScheduler.hh"
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerDcsScheduler::TrackerDcsScheduler() :
+    _stop     (false)
+  , _tokenTime(std::chrono::steady_clock::now())
+  , _lastDone (_tokenTime)
+  , _minGapUs (0) {
+
+  for (int p=0; p<kNPriorities; p++) {
+    _queue[p].rate   = 0;
+    _queue[p].burst  = 1;
+    _queue[p].tokens = 1;
+    _nDone  [p]      = 0;
+    _sumWait[p]      = 0;
+  }
+
+  _thread = std::thread(&TrackerDcsScheduler::run_, this);
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerDcsScheduler::~TrackerDcsScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _cv.notify_all();
+  _thread.join();
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDcsScheduler::setRateLimit(Priority_t Priority, double Rate, double Burst) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  Queue& q = _queue[Priority];
+  q.rate   = std::max(Rate, 0.);
+  q.burst  = std::max(Burst, 1.);
+  q.tokens = q.burst;
+}
+
+//-----------------------------------------------------------------------------
+std::future<uint32_t> mu2e::TrackerDcsScheduler::submit(Priority_t Priority, job_t Job) {
+  std::packaged_task<uint32_t()> task(std::move(Job));
+  std::future<uint32_t>          result = task.get_future();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queue[Priority].jobs.push_back({std::move(task), std::chrono::steady_clock::now()});
+  }
+  _cv.notify_one();
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerDcsScheduler::nPending(Priority_t Priority) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _queue[Priority].jobs.size();
+}
+
+//-----------------------------------------------------------------------------
+double mu2e::TrackerDcsScheduler::meanWaitUs(Priority_t Priority) const {
+  size_t n = _nDone[Priority];
+  return (n > 0) ? _sumWait[Priority]/n : 0;
+}
+
+//-----------------------------------------------------------------------------
+// called with the lock held. Returns the priority to serve, or -1 and the
+// time to look again (time_point_t::max(): nothing queued)
+//-----------------------------------------------------------------------------
+int mu2e::TrackerDcsScheduler::next_(time_point_t Now, time_point_t& Wakeup) {
+  double dt  = std::chrono::duration<double>(Now-_tokenTime).count();
+  _tokenTime = Now;
+
+  Wakeup = time_point_t::max();
+  bool queued = false;
+
+  for (int p=0; p<kNPriorities; p++) {
+    Queue& q = _queue[p];
+    if (q.rate > 0) q.tokens = std::min(q.burst, q.tokens + q.rate*dt);
+    queued = queued or (not q.jobs.empty());
+  }
+  if (not queued) return -1;
+
+  auto gapEnd = _lastDone + std::chrono::microseconds(_minGapUs);
+  if (Now < gapEnd) {
+    Wakeup = gapEnd;
+    return -1;
+  }
+
+  for (int p=0; p<kNPriorities; p++) {
+    Queue& q = _queue[p];
+    if (q.jobs.empty()) continue;
+    if ((q.rate == 0) or (q.tokens >= 1)) return p;
+
+    auto t = Now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                     std::chrono::duration<double>((1-q.tokens)/q.rate));
+    Wakeup = std::min(Wakeup, t);
+  }
+
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerDcsScheduler::run_() {
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  while (not _stop) {
+    time_point_t wakeup;
+    int p = next_(std::chrono::steady_clock::now(), wakeup);
+    if (p < 0) {
+      if (wakeup == time_point_t::max()) _cv.wait(lock);
+      else                               _cv.wait_until(lock, wakeup);
+      continue;
+    }
+
+    Queue& q   = _queue[p];
+    Job    job = std::move(q.jobs.front());
+    q.jobs.pop_front();
+    if (q.rate > 0) q.tokens -= 1;
+
+    lock.unlock();
+
+//-----------------------------------------------------------------------------
+// counted before it runs: the future is ready inside task(), a caller back from
+// get() finds its transaction in nDone()
+//-----------------------------------------------------------------------------
+    auto start  = std::chrono::steady_clock::now();
+    _sumWait[p] = _sumWait[p] + std::chrono::duration<double, std::micro>(start-job.submitted).count();
+    _nDone  [p]++;
+
+    job.task();                         // an exception goes into the future
+    _lastDone   = std::chrono::steady_clock::now();
+
+    lock.lock();
+  }
+}
@@ -0,0 +1,91 @@
+#ifndef otsdaq_mu2e_tracker_Utilities_TrackerDcsScheduler_hh
+#define otsdaq_mu2e_tracker_Utilities_TrackerDcsScheduler_hh
+//-----------------------------------------------------------------------------
+// TrackerDcsScheduler : one thread doing all DCS (ROC register) transactions
+// of a DTC, so slow control and diagnostics run next to the readout without
+// stopping the event window markers
+//
+// - submit() queues a transaction and returns a future for its result. An
+//   exception thrown by the transaction comes out of the future
+// - three priorities: kHigh (run control), kNormal (monitoring), kLow
+//   (diagnostics). The highest non-empty priority with budget left goes first
+// - each priority has a token bucket (transactions/s, burst), 0: unlimited;
+//   minGapUs spaces any two transactions, leaving the link to the data
+// - transactions still queued when the scheduler is deleted are dropped,
+//   their futures throw std::future_error (broken promise)
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace mu2e {
+  class TrackerDcsScheduler {
+  public:
+    enum Priority_t {
+      kHigh        = 0,
+      kNormal      = 1,
+      kLow         = 2,
+      kNPriorities = 3
+    };
+
+    typedef std::function<uint32_t()> job_t;
+
+    TrackerDcsScheduler();
+    ~TrackerDcsScheduler();
+                                        // Rate: transactions/s, 0: unlimited
+    void   setRateLimit(Priority_t Priority, double Rate, double Burst);
+    void   setMinGapUs (int GapUs) { _minGapUs = GapUs; }
+
+    std::future<uint32_t> submit(Priority_t Priority, job_t Job);
+                                        // same as submit(Priority, Job).get()
+    uint32_t run       (Priority_t Priority, job_t Job) { return submit(Priority, std::move(Job)).get(); }
+
+    size_t nPending    (Priority_t Priority) const;
+                                        // transactions run, counted as they start
+    size_t nDone       (Priority_t Priority) const { return _nDone[Priority]; }
+                                        // mean time from submit() to the start of the transaction
+    double meanWaitUs  (Priority_t Priority) const;
+                                        // true on the scheduler thread: call the device directly
+    bool   onThread    () const { return std::this_thread::get_id() == _thread.get_id(); }
+
+  private:
+    typedef std::chrono::steady_clock::time_point time_point_t;
+
+    struct Job {
+      std::packaged_task<uint32_t()> task;
+      time_point_t                   submitted;
+    };
+
+    struct Queue {
+      std::deque<Job> jobs;
+      double          rate;             // 0: unlimited
+      double          burst;
+      double          tokens;
+    };
+
+    void   run_        ();
+    int    next_       (time_point_t Now, time_point_t& Wakeup);
+
+    Queue                   _queue[kNPriorities];
+    mutable std::mutex      _mutex;
+    std::condition_variable _cv;
+    bool                    _stop;
+    time_point_t            _tokenTime;
+    time_point_t            _lastDone;
+    std::atomic<int>        _minGapUs;
+
+    std::atomic<size_t>     _nDone   [kNPriorities];
+    std::atomic<double>     _sumWait [kNPriorities];    // us
+
+    std::thread             _thread;                    // last, started by the constructor
+  };
+}  // namespace mu2e
+
+#endif
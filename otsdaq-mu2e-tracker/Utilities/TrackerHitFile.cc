@@ -0,0 +1,291 @@
+///////////////////////////////////////////////////////////////////////////////
+// columnar straw hit files, see TrackerHitFile.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "otsdaq-mu2e-tracker/Utilities/TrackerHitFile.hh"
+#include "otsdaq-mu2e-tracker/Utilities/TrackerLog.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  const char* kColumnName[mu2e::TrackerHitFile::kNColumns] = {
+    "ewt", "link", "channel", "flags", "time0", "time1", "charge", "waveform"
+  };
+
+  const size_t kColumnSize[mu2e::TrackerHitFile::kNColumns] = {
+    sizeof(uint64_t), sizeof(uint8_t), sizeof(uint8_t), sizeof(uint16_t),
+    sizeof(float), sizeof(float), sizeof(float), sizeof(uint16_t)
+  };
+
+  template <class T>
+  void minMax(std::vector<T> const& V, mu2e::TrackerHitFile::Column& C) {
+    if (V.empty()) return;
+    auto mm = std::minmax_element(V.begin(), V.end());
+    C.min   = double(*mm.first );
+    C.max   = double(*mm.second);
+  }
+}
+
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerHitFile::columnSize(int Column, int NSamples) {
+  return (Column == kWaveform) ? NSamples*kColumnSize[Column] : kColumnSize[Column];
+}
+
+//-----------------------------------------------------------------------------
+const char* mu2e::TrackerHitFile::columnName(int Column) {
+  return ((Column >= 0) and (Column < kNColumns)) ? kColumnName[Column] : "";
+}
+
+//-----------------------------------------------------------------------------
+int mu2e::TrackerHitFile::column(std::string const& Name) {
+  for (int i=0; i<kNColumns; i++) {
+    if (Name == kColumnName[i]) return i;
+  }
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerHitWriter::TrackerHitWriter(std::string const& File, int NSamples, size_t ChunkHits) :
+    _fileName (File)
+  , _file     (fopen(File.data(), "wb"))
+  , _nSamples (std::max(NSamples, 0))
+  , _chunkHits(std::max(ChunkHits, size_t(1)))
+  , _pos      (0)
+  , _nHits    (0) {
+
+  if (_file == nullptr) {
+    TRK_LOG(TrackerLog::kError, "can't open " << _fileName << ": " << strerror(errno));
+    return;
+  }
+
+  TrackerHitFile::Header h;
+  memset(&h, 0, sizeof(h));
+  h.magic    = TrackerHitFile::kMagic;
+  h.version  = TrackerHitFile::kVersion;
+  h.nColumns = TrackerHitFile::kNColumns;
+  h.nSamples = _nSamples;
+
+//-----------------------------------------------------------------------------
+// flushed right away, so a full or read-only device shows up here: without a
+// header there is no file, close() would put an index after garbage
+//-----------------------------------------------------------------------------
+  if ((not write_(&h, sizeof(h))) or (fflush(_file) != 0)) fail_();
+}
+
+//-----------------------------------------------------------------------------
+// a failed write ends the file, the hits still coming are dropped
+//-----------------------------------------------------------------------------
+void mu2e::TrackerHitWriter::fail_() {
+  TRK_LOG(TrackerLog::kError, "write to " << _fileName << " failed: " << strerror(errno) << ", file closed");
+  fclose(_file);
+  _file = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerHitWriter::~TrackerHitWriter() {
+  close();
+}
+
+//-----------------------------------------------------------------------------
+// the data, then zeros up to the next kAlign boundary
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerHitWriter::write_(const void* Data, size_t Bytes) {
+  static const char zero[TrackerHitFile::kAlign] = {};
+
+  size_t pad = TrackerHitFile::align(Bytes) - Bytes;
+  if (fwrite(Data, 1, Bytes, _file) != Bytes) return false;
+  if ((pad > 0) and (fwrite(zero, 1, pad, _file) != pad)) return false;
+
+  _pos += Bytes+pad;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerHitWriter::add(uint64_t Ewt, int Link, int Channel, int Flags, float Time0, float Time1,
+                                 float Charge, const uint16_t* Waveform) {
+  if (_file == nullptr) return;
+
+  _ewt    .push_back(Ewt);
+  _link   .push_back(Link);
+  _channel.push_back(Channel);
+  _flags  .push_back(Flags);
+  _time0  .push_back(Time0);
+  _time1  .push_back(Time1);
+  _charge .push_back(Charge);
+  if (_nSamples > 0) {
+    if (Waveform) _waveform.insert(_waveform.end(), Waveform, Waveform+_nSamples);
+    else          _waveform.resize(_waveform.size()+_nSamples, 0);
+  }
+
+  _nHits++;
+  if (_ewt.size() >= _chunkHits) flush();
+}
+
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerHitWriter::flush() {
+  if (_file == nullptr) return false;
+
+  size_t n = _ewt.size();
+  if (n == 0) return true;
+
+  const void* data[TrackerHitFile::kNColumns] = {
+    _ewt.data(), _link.data(), _channel.data(), _flags.data(),
+    _time0.data(), _time1.data(), _charge.data(), _waveform.data()
+  };
+
+  TrackerHitFile::Chunk c;
+  memset(&c, 0, sizeof(c));
+  c.magic = TrackerHitFile::kChunkMagic;
+  c.nHits = n;
+
+  uint64_t offset = TrackerHitFile::align(sizeof(c));
+  for (int k=0; k<TrackerHitFile::kNColumns; k++) {
+    c.column[k].offset = offset;
+    c.column[k].bytes  = n*TrackerHitFile::columnSize(k, _nSamples);
+    offset             = TrackerHitFile::align(offset + c.column[k].bytes);
+  }
+  c.bytes = offset;
+
+  minMax(_ewt     , c.column[TrackerHitFile::kEwt     ]);
+  minMax(_link    , c.column[TrackerHitFile::kLink    ]);
+  minMax(_channel , c.column[TrackerHitFile::kChannel ]);
+  minMax(_flags   , c.column[TrackerHitFile::kFlags   ]);
+  minMax(_time0   , c.column[TrackerHitFile::kTime0   ]);
+  minMax(_time1   , c.column[TrackerHitFile::kTime1   ]);
+  minMax(_charge  , c.column[TrackerHitFile::kCharge  ]);
+  minMax(_waveform, c.column[TrackerHitFile::kWaveform]);
+
+  _chunkOffset.push_back(_pos);
+
+  bool ok = write_(&c, sizeof(c));
+  for (int k=0; (k<TrackerHitFile::kNColumns) and ok; k++) {
+    if (c.column[k].bytes > 0) ok = write_(data[k], c.column[k].bytes);
+  }
+
+  _ewt.clear();
+  _link.clear();
+  _channel.clear();
+  _flags.clear();
+  _time0.clear();
+  _time1.clear();
+  _charge.clear();
+  _waveform.clear();
+
+  if (not ok) {
+    _chunkOffset.pop_back();
+    fail_();
+  }
+  return ok;
+}
+
+//-----------------------------------------------------------------------------
+// the chunk offsets, then the Index record at the very end
+//-----------------------------------------------------------------------------
+void mu2e::TrackerHitWriter::close() {
+  if (not flush()) return;
+
+  TrackerHitFile::Index index;
+  index.magic   = TrackerHitFile::kIndexMagic;
+  index.nChunks = _chunkOffset.size();
+  index.offset  = _pos;
+
+  size_t bytes = _chunkOffset.size()*sizeof(uint64_t);
+  bool   ok    = (bytes == 0) or (fwrite(_chunkOffset.data(), 1, bytes, _file) == bytes);
+  ok           = ok and (fwrite(&index, 1, sizeof(index), _file) == sizeof(index));
+  ok           = (fclose(_file) == 0) and ok;
+  _file        = nullptr;
+
+  if (not ok) TRK_LOG(TrackerLog::kError, "can't write the index of " << _fileName << ": " << strerror(errno));
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerHitReader* mu2e::TrackerHitReader::open(std::string const& File) {
+  int fd = ::open(File.data(), O_RDONLY);
+  if (fd < 0) return nullptr;
+
+  struct stat st;
+  if ((fstat(fd, &st) != 0) or (size_t(st.st_size) < sizeof(TrackerHitFile::Header))) {
+    ::close(fd);
+    return nullptr;
+  }
+
+  size_t size = st.st_size;
+  void*  data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) return nullptr;
+
+  TrackerHitReader* r = new TrackerHitReader();
+  r->_data     = static_cast<const uint8_t*>(data);
+  r->_size     = size;
+  r->_header   = reinterpret_cast<const TrackerHitFile::Header*>(data);
+  r->_nHits    = 0;
+  r->_complete = false;
+
+  if ((r->_header->magic    != TrackerHitFile::kMagic    ) or
+      (r->_header->version  != TrackerHitFile::kVersion  ) or
+      (r->_header->nColumns != TrackerHitFile::kNColumns)) {
+    delete r;
+    return nullptr;
+  }
+//-----------------------------------------------------------------------------
+// a chunk is used only if it and its columns are inside the file
+//-----------------------------------------------------------------------------
+  auto chunkAt = [r](uint64_t Offset) -> const TrackerHitFile::Chunk* {
+    if (Offset + sizeof(TrackerHitFile::Chunk) > r->_size) return nullptr;
+    auto c = reinterpret_cast<const TrackerHitFile::Chunk*>(r->_data + Offset);
+    if ((c->magic != TrackerHitFile::kChunkMagic) or (Offset + c->bytes > r->_size)) return nullptr;
+    for (int k=0; k<TrackerHitFile::kNColumns; k++) {
+      if (c->column[k].offset + c->column[k].bytes > c->bytes) return nullptr;
+    }
+    return c;
+  };
+
+  auto index = reinterpret_cast<const TrackerHitFile::Index*>(r->_data + size - sizeof(TrackerHitFile::Index));
+  if ((size >= sizeof(TrackerHitFile::Header) + sizeof(TrackerHitFile::Index)) and
+      (index->magic == TrackerHitFile::kIndexMagic)                          and
+      (index->offset + index->nChunks*sizeof(uint64_t) + sizeof(TrackerHitFile::Index) == size)) {
+    auto offset = reinterpret_cast<const uint64_t*>(r->_data + index->offset);
+    r->_complete = true;
+    for (uint32_t i=0; i<index->nChunks; i++) {
+      const TrackerHitFile::Chunk* c = chunkAt(offset[i]);
+      if (c == nullptr) {
+        r->_complete = false;
+        r->_chunk.clear();
+        break;
+      }
+      r->_chunk.push_back(c);
+    }
+  }
+
+  if (not r->_complete) {
+    uint64_t pos = TrackerHitFile::align(sizeof(TrackerHitFile::Header));
+    while (const TrackerHitFile::Chunk* c = chunkAt(pos)) {
+      r->_chunk.push_back(c);
+      pos += c->bytes;
+    }
+  }
+
+  for (auto c : r->_chunk) r->_nHits += c->nHits;
+  return r;
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerHitReader::~TrackerHitReader() {
+  munmap(const_cast<uint8_t*>(_data), _size);
+}
+
+//-----------------------------------------------------------------------------
+std::vector<size_t> mu2e::TrackerHitReader::select(TrackerHitFile::Column_t Column, double Lo, double Hi) const {
+  std::vector<size_t> chunks;
+  for (size_t i=0; i<_chunk.size(); i++) {
+    auto const& c = _chunk[i]->column[Column];
+    if ((c.bytes > 0) and (c.max >= Lo) and (c.min <= Hi)) chunks.push_back(i);
+  }
+  return chunks;
+}
@@ -0,0 +1,164 @@
+#ifndef otsdaq_mu2e_tracker_Utilities_TrackerHitFile_hh
+#define otsdaq_mu2e_tracker_Utilities_TrackerHitFile_hh
+//-----------------------------------------------------------------------------
+// TrackerHitFile : decoded straw hits in column blocks, for offline analysis
+// which needs a few columns of many hits
+//
+// file layout, native byte order, every piece starts on a kAlign boundary:
+//   Header
+//   chunks : Chunk header, then the columns of its hits one after the other;
+//            each column has its offset, size and min/max in the header
+//   Index  : chunk offsets, then the Index record - the last bytes of a closed
+//            file. A file without it (writer died) is read by walking the chunks
+//
+// columns : ewt (uint64), link, channel (uint8), flags (uint16), time0,
+//           time1, charge (float), waveform (nSamples uint16 per hit, only if
+//           nSamples > 0)
+//
+// TrackerHitWriter : fills one chunk in memory, writes it when chunkHits hits
+//                    are in, on flush() and on close(). A failed write is
+//                    logged as an error and closes the file, without an
+//                    index: isOpen() is false from then on
+// TrackerHitReader : maps the file read-only, column() points into the
+//                    mapping, select() skips chunks by their min/max
+//-----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+  class TrackerHitFile {
+  public:
+    enum {
+      kMagic      = 0x54524b48,         // 'TRKH'
+      kChunkMagic = 0x54524b43,         // 'TRKC'
+      kIndexMagic = 0x54524b49,         // 'TRKI'
+      kVersion    = 1,
+      kAlign      = 64
+    };
+
+    enum Column_t {
+      kEwt      = 0,
+      kLink     = 1,
+      kChannel  = 2,
+      kFlags    = 3,
+      kTime0    = 4,
+      kTime1    = 5,
+      kCharge   = 6,
+      kWaveform = 7,
+      kNColumns = 8
+    };
+
+    struct Header {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t nColumns;
+      uint32_t nSamples;                // waveform samples per hit, 0: no waveforms
+      uint64_t unused[2];
+    };
+
+    struct Column {
+      uint64_t offset;                  // from the start of the chunk
+      uint64_t bytes;
+      double   min;
+      double   max;
+    };
+
+    struct Chunk {
+      uint32_t magic;
+      uint32_t nHits;
+      uint64_t bytes;                   // header and columns, padding included
+      Column   column[kNColumns];
+    };
+
+    struct Index {
+      uint32_t magic;
+      uint32_t nChunks;
+      uint64_t offset;                  // of the chunk offsets
+    };
+                                        // bytes per hit
+    static size_t      columnSize(int Column, int NSamples);
+    static const char* columnName(int Column);
+    static int         column    (std::string const& Name);   // -1 if unknown
+    static uint64_t    align     (uint64_t Bytes) { return (Bytes + kAlign-1) & ~uint64_t(kAlign-1); }
+  };
+
+//-----------------------------------------------------------------------------
+  class TrackerHitWriter {
+  public:
+    TrackerHitWriter(std::string const& File, int NSamples, size_t ChunkHits = 65536);
+    ~TrackerHitWriter();
+
+    bool   isOpen () const { return _file != nullptr; }
+                                        // Waveform: NSamples values, ignored if NSamples = 0
+    void   add    (uint64_t Ewt, int Link, int Channel, int Flags, float Time0, float Time1, float Charge,
+                   const uint16_t* Waveform = nullptr);
+    bool   flush  ();
+    void   close  ();
+
+    size_t nHits  () const { return _nHits;              }
+    size_t nChunks() const { return _chunkOffset.size(); }
+    uint64_t bytes() const { return _pos;                }
+
+  private:
+    bool   write_ (const void* Data, size_t Bytes);
+    void   fail_  ();
+
+    std::string           _fileName;
+    FILE*                 _file;
+    int                   _nSamples;
+    size_t                _chunkHits;
+    uint64_t              _pos;
+    size_t                _nHits;
+    std::vector<uint64_t> _chunkOffset;
+
+    std::vector<uint64_t> _ewt;         // the chunk being filled
+    std::vector<uint8_t>  _link;
+    std::vector<uint8_t>  _channel;
+    std::vector<uint16_t> _flags;
+    std::vector<float>    _time0;
+    std::vector<float>    _time1;
+    std::vector<float>    _charge;
+    std::vector<uint16_t> _waveform;
+  };
+
+//-----------------------------------------------------------------------------
+  class TrackerHitReader {
+  public:
+                                        // nullptr if the file can't be mapped or isn't a hit file
+    static TrackerHitReader* open(std::string const& File);
+    ~TrackerHitReader();
+
+    int      nSamples () const { return _header->nSamples; }
+    size_t   nChunks  () const { return _chunk.size();      }
+    size_t   nHits    () const { return _nHits;             }
+    uint32_t nHits    (size_t Chunk) const { return _chunk[Chunk]->nHits; }
+                                        // false: no index, the chunks were found by walking the file
+    bool     complete () const { return _complete;          }
+
+    template <class T>
+    const T* column   (size_t Chunk, TrackerHitFile::Column_t Column) const {
+      const TrackerHitFile::Chunk* c = _chunk[Chunk];
+      return reinterpret_cast<const T*>(reinterpret_cast<const uint8_t*>(c) + c->column[Column].offset);
+    }
+
+    double   min      (size_t Chunk, TrackerHitFile::Column_t Column) const { return _chunk[Chunk]->column[Column].min; }
+    double   max      (size_t Chunk, TrackerHitFile::Column_t Column) const { return _chunk[Chunk]->column[Column].max; }
+                                        // chunks which may have hits with Lo <= Column <= Hi
+    std::vector<size_t> select(TrackerHitFile::Column_t Column, double Lo, double Hi) const;
+
+  private:
+    TrackerHitReader() {}
+
+    const uint8_t*                            _data;
+    size_t                                    _size;
+    const TrackerHitFile::Header*             _header;
+    std::vector<const TrackerHitFile::Chunk*> _chunk;
+    size_t                                    _nHits;
+    bool                                      _complete;
+  };
+}  // namespace mu2e
+
+#endif
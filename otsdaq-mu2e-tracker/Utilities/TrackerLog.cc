@@ -0,0 +1,211 @@
+///////////////////////////////////////////////////////////////////////////////
+// asynchronous hot-path logging, see TrackerLog.hh
+// bounded multi-producer ring: a record is free for the writer of index i when
+// its sequence number is i, readable when it is i+1
+///////////////////////////////////////////////////////////////////////////////
+#include "otsdaq-mu2e-tracker/Utilities/TrackerLog.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <streambuf>
+
+std::atomic<int> mu2e::TrackerLog::_level(mu2e::TrackerLog::kInfo);
+
+namespace {
+  const char* levelName[] = { "ERROR", "WARNING", "INFO", "DEBUG", "TRACE" };
+
+  void defaultSink(int Level, const char* Text) {
+    fprintf(stderr, "%s: %s\n", levelName[(Level >= 0 and Level <= mu2e::TrackerLog::kTrace) ? Level : mu2e::TrackerLog::kTrace], Text);
+  }
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerLog* mu2e::TrackerLog::instance() {
+  static TrackerLog log;
+  return &log;
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerLog::TrackerLog() :
+    _ring      (new Record[kRingSize])
+  , _head      (0)
+  , _tail      (0)
+  , _nSinkUsers(0)
+  , _stop      (false)
+  , _nDropped  (0) {
+
+  for (size_t i=0; i<kRingSize; i++) _ring[i].seq = i;
+
+  _sink = defaultSink;
+
+  _thread = std::thread(&TrackerLog::run_, this);
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerLog::~TrackerLog() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _cv.notify_all();
+  if (_thread.joinable()) _thread.join();
+}
+
+//-----------------------------------------------------------------------------
+// nullptr restores stderr: a plugin resets it before its library is unloaded
+//-----------------------------------------------------------------------------
+void mu2e::TrackerLog::setSink(sink_t Sink) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  drain_();
+  _sink = Sink ? std::move(Sink) : sink_t(defaultSink);
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerLog::acquireSink(sink_t Sink) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_nSinkUsers++ > 0) return;
+  drain_();
+  _sink = Sink ? std::move(Sink) : sink_t(defaultSink);
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerLog::releaseSink() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if ((_nSinkUsers == 0) or (--_nSinkUsers > 0)) return;
+  drain_();
+  _sink = defaultSink;
+}
+
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerLog::push(int Level, const char* Text, size_t Size) {
+  uint64_t pos = _head.load(std::memory_order_relaxed);
+  Record*  r;
+
+  while (true) {
+    r = &_ring[pos & (kRingSize-1)];
+    uint64_t seq = r->seq.load(std::memory_order_acquire);
+
+    if (seq == pos) {
+      if (_head.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) break;
+    }
+    else if (seq < pos) {
+      _nDropped++;
+      return false;
+    }
+    else {
+      pos = _head.load(std::memory_order_relaxed);
+    }
+  }
+
+  r->level = Level;
+  r->size  = (Size < kMaxText) ? Size : kMaxText-1;
+  memcpy(r->text, Text, r->size);
+  r->text[r->size] = 0;
+  r->seq.store(pos+1, std::memory_order_release);
+//-----------------------------------------------------------------------------
+// the drain thread wakes up on its own, only hurry it when the ring fills up
+//-----------------------------------------------------------------------------
+  if ((pos & (kRingSize/2-1)) == 0) _cv.notify_one();
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// called with _mutex held
+//-----------------------------------------------------------------------------
+size_t mu2e::TrackerLog::drain_() {
+  size_t n = 0;
+
+  while (true) {
+    Record& r = _ring[_tail & (kRingSize-1)];
+    if (r.seq.load(std::memory_order_acquire) != _tail+1) break;
+
+    _sink(r.level, r.text);
+
+    r.seq.store(_tail+kRingSize, std::memory_order_release);
+    _tail++;
+    n++;
+  }
+
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerLog::flush() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  drain_();
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerLog::run_() {
+  size_t reported = 0;
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    drain_();
+
+    if (_nDropped != reported) {
+      size_t dropped = _nDropped;
+      char   text[64];
+      snprintf(text, sizeof(text), "%zu log messages dropped", dropped-reported);
+      _sink(kWarning, text);
+      reported = dropped;
+    }
+
+    if (_stop) break;
+    _cv.wait_for(lock, std::chrono::milliseconds(5));
+  }
+}
+
+//-----------------------------------------------------------------------------
+// the stream and its buffer are built once per thread, not once per message
+//-----------------------------------------------------------------------------
+namespace {
+  class LineBuffer : public std::streambuf {
+  public:
+    LineBuffer() : _stream(this) { reset(); }
+
+//-----------------------------------------------------------------------------
+// a manipulator in one message must not leak into the next one
+//-----------------------------------------------------------------------------
+    void          reset () {
+      setp(_text, _text+sizeof(_text));
+      _stream.clear();
+      _stream.flags(std::ios_base::dec | std::ios_base::skipws);
+      _stream.precision(6);
+      _stream.width(0);
+      _stream.fill(' ');
+    }
+    size_t        size  () const { return pptr()-pbase(); }
+    const char*   text  () const { return _text; }
+    std::ostream& stream() { return _stream; }
+
+  protected:
+    int_type overflow(int_type C) override { return traits_type::eof(); }
+
+  private:
+    char         _text[mu2e::TrackerLog::kMaxText];
+    std::ostream _stream;
+  };
+
+  LineBuffer& lineBuffer() {
+    thread_local LineBuffer buffer;
+    return buffer;
+  }
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerLogLine::TrackerLogLine(int Level) : _level(Level) {
+  lineBuffer().reset();
+}
+
+//-----------------------------------------------------------------------------
+std::ostream& mu2e::TrackerLogLine::stream() {
+  return lineBuffer().stream();
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerLogLine::~TrackerLogLine() {
+  TrackerLog::instance()->push(_level, lineBuffer().text(), lineBuffer().size());
+}
@@ -0,0 +1,122 @@
+#ifndef otsdaq_mu2e_tracker_Utilities_TrackerLog_hh
+#define otsdaq_mu2e_tracker_Utilities_TrackerLog_hh
+//-----------------------------------------------------------------------------
+// TrackerLog : logging for the hot paths of the tracker plugins (TrackerVST,
+// ROCTrackerInterface)
+//
+// TRK_LOG(level, a << b << ...)
+//
+// - levels above TRK_LOG_MAX_LEVEL (set by the build, see the top
+//   CMakeLists.txt) are compiled out, the arguments are not evaluated
+// - the rest is checked against a runtime level (setLevel(), kInfo until the
+//   configuration raises it: TrackerVST log_level, ROC trackerLogLevel),
+//   formatted at the call site into a fixed-size record without allocating,
+//   and queued in a lock-free ring
+// - one background thread drains the ring into the sink, by default stderr.
+//   The plugins install their own (TRACE, message facility) with
+//   acquireSink(): the logger is one per process, so the first plugin
+//   instance installs it and the last one to release it restores stderr
+// - a full ring drops the message and counts it, the caller never blocks
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#ifndef TRK_LOG_MAX_LEVEL
+#define TRK_LOG_MAX_LEVEL 3
+#endif
+
+#define TRK_LOG(Level, Msg)                                                           \
+  do {                                                                                \
+    if (((Level) <= TRK_LOG_MAX_LEVEL) and mu2e::TrackerLog::enabled(Level)) {        \
+      mu2e::TrackerLogLine trk_log_line_(Level);                                      \
+      trk_log_line_.stream() << Msg;                                                  \
+    }                                                                                 \
+  } while (0)
+
+namespace mu2e {
+  class TrackerLog {
+  public:
+    enum Level_t {
+      kError   = 0,
+      kWarning = 1,
+      kInfo    = 2,
+      kDebug   = 3,
+      kTrace   = 4
+    };
+
+    enum {
+      kRingSize = 4096,                 // records, power of 2
+      kMaxText  = 240                   // bytes per message, longer ones are truncated
+    };
+
+    typedef std::function<void(int Level, const char* Text)> sink_t;
+
+    static TrackerLog* instance();
+
+    static bool enabled (int Level) { return Level <= _level.load(std::memory_order_relaxed); }
+    static void setLevel(int Level) { _level = Level; }
+
+    void   setSink    (sink_t Sink);
+                                        // reference counted, Sink is ignored if one is installed already
+    void   acquireSink(sink_t Sink);
+    void   releaseSink();
+                                        // false if the ring is full
+    bool   push       (int Level, const char* Text, size_t Size);
+                                        // returns when everything queued so far is written
+    void   flush      ();
+
+    size_t nDropped   () const { return _nDropped; }
+
+    ~TrackerLog();
+
+  private:
+    TrackerLog();
+
+    struct Record {
+      std::atomic<uint64_t> seq;
+      int                   level;
+      uint32_t              size;
+      char                  text[kMaxText];
+    };
+
+    void   run_     ();
+    size_t drain_   ();
+
+    static std::atomic<int>   _level;
+
+    std::unique_ptr<Record[]> _ring;
+    std::atomic<uint64_t>     _head;    // next record to write
+    uint64_t                  _tail;    // next record to read, drain thread only
+
+    std::mutex                _mutex;   // sink and wake-up only
+    std::condition_variable   _cv;
+    sink_t                    _sink;
+    int                       _nSinkUsers;
+    std::thread               _thread;
+    bool                      _stop;
+    std::atomic<size_t>       _nDropped;
+  };
+
+//-----------------------------------------------------------------------------
+// one message: formats into a per-thread buffer, queued by the destructor
+//-----------------------------------------------------------------------------
+  class TrackerLogLine {
+  public:
+    explicit TrackerLogLine(int Level);
+    ~TrackerLogLine();
+
+    std::ostream& stream();
+
+  private:
+    int _level;
+  };
+}  // namespace mu2e
+
+#endif
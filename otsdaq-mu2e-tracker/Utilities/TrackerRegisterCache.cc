@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadow register cache, see TrackerRegisterCache.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "otsdaq-mu2e-tracker/Utilities/TrackerRegisterCache.hh"
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerRegisterCache::TrackerRegisterCache() :
+    _nHits   (0)
+  , _nMisses (0)
+  , _nThrough(0) {
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRegisterCache::setClass(uint32_t Key, Class_t Class) {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if (Class == kVolatile) {
+    _entries.erase(Key);
+    return;
+  }
+
+  Entry& e = _entries[Key];
+  e.cls        = Class;
+  e.valid      = false;
+  e.generation++;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRegisterCache::setClass(std::vector<uint32_t> const& Keys, Class_t Class) {
+  for (uint32_t key : Keys) setClass(key, Class);
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerRegisterCache::Class_t mu2e::TrackerRegisterCache::regClass(uint32_t Key) const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _entries.find(Key);
+  return (it != _entries.end()) ? it->second.cls : kVolatile;
+}
+
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerRegisterCache::lookup_(uint32_t Key, uint32_t& Value, uint64_t& Generation) {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  auto it = _entries.find(Key);
+  if (it == _entries.end()) {
+    _nThrough++;
+    Generation = 0;
+    return false;
+  }
+
+  Entry& e = it->second;
+  if (not e.valid) {
+    _nMisses++;
+    Generation = e.generation;
+    return false;
+  }
+
+  _nHits++;
+  Value = e.value;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRegisterCache::fill_(uint32_t Key, uint64_t Generation, uint32_t Value) {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  auto it = _entries.find(Key);
+  if ((it == _entries.end()) or (it->second.generation != Generation)) return;
+
+  it->second.value = Value;
+  it->second.valid = true;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRegisterCache::written(uint32_t Key) {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  auto it = _entries.find(Key);
+  if (it == _entries.end()) return;
+
+  it->second.valid = false;
+  it->second.generation++;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerRegisterCache::invalidate(uint32_t First, uint32_t Last) {
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  for (auto& e : _entries) {
+    if ((e.first < First) or (e.first > Last)) continue;
+    e.second.valid = false;
+    e.second.generation++;
+  }
+}
+
+//-----------------------------------------------------------------------------
+double mu2e::TrackerRegisterCache::hitRate() const {
+  size_t n = _nHits + _nMisses + _nThrough;
+  return (n > 0) ? _nHits/double(n) : 0;
+}
@@ -0,0 +1,81 @@
+#ifndef otsdaq_mu2e_tracker_Utilities_TrackerRegisterCache_hh
+#define otsdaq_mu2e_tracker_Utilities_TrackerRegisterCache_hh
+//-----------------------------------------------------------------------------
+// TrackerRegisterCache : shadow copy of the DTC/ROC registers which don't
+// change on their own, so reading them doesn't cost a DCS round trip
+//
+// - every register has a class:
+//   kStatic   : never changes (design ID, firmware version), read once
+//   kConfig   : changes only when we write it, read again after our write
+//   kVolatile : counters, FIFO depths..., always read through (the default)
+// - the key is the caller's: the register address, with the link in the
+//   upper bits for the ROC registers
+// - read() calls the reader only on a miss. A write or an invalidate() in
+//   the middle of the read-through wins, the value read is not kept
+// - thread-safe, the reads themselves are made without holding the lock
+// - hitRate() counts all reads, volatile ones included: it is the fraction
+//   of the DCS reads saved
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mu2e {
+  class TrackerRegisterCache {
+  public:
+    enum Class_t {
+      kVolatile = 0,
+      kConfig   = 1,
+      kStatic   = 2
+    };
+
+    TrackerRegisterCache();
+
+    void     setClass  (uint32_t Key, Class_t Class);
+    void     setClass  (std::vector<uint32_t> const& Keys, Class_t Class);
+    Class_t  regClass  (uint32_t Key) const;
+                                        // Read: uint32_t(), the DCS access
+    template <class F>
+    uint32_t read      (uint32_t Key, F Read) {
+      uint32_t value;
+      uint64_t generation;
+      if (lookup_(Key, value, generation)) return value;
+
+      value = Read();
+      fill_(Key, generation, value);
+      return value;
+    }
+                                        // after our own write
+    void     written   (uint32_t Key);
+                                        // all the keys in [First, Last], everything by default
+    void     invalidate(uint32_t First = 0, uint32_t Last = UINT32_MAX);
+
+    size_t   nHits     () const { return _nHits;    }
+    size_t   nMisses   () const { return _nMisses;  }
+    size_t   nThrough  () const { return _nThrough; }
+    double   hitRate   () const;
+
+  private:
+    struct Entry {
+      Class_t  cls;
+      bool     valid;
+      uint32_t value;
+      uint64_t generation;              // bumped by every write and invalidation
+    };
+                                        // true on a hit
+    bool     lookup_   (uint32_t Key, uint32_t& Value, uint64_t& Generation);
+    void     fill_     (uint32_t Key, uint64_t Generation, uint32_t Value);
+
+    mutable std::mutex                  _mutex;
+    std::unordered_map<uint32_t, Entry> _entries;     // kConfig and kStatic only
+
+    std::atomic<size_t> _nHits;
+    std::atomic<size_t> _nMisses;
+    std::atomic<size_t> _nThrough;
+  };
+}  // namespace mu2e
+
+#endif
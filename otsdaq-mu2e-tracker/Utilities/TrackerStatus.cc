@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////////////
+// status export through shared memory, see TrackerStatus.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "otsdaq-mu2e-tracker/Utilities/TrackerStatus.hh"
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerStatus::TrackerStatus(std::string const& Name, Segment* S, bool Owner) :
+    _name   (Name)
+  , _segment(S)
+  , _owner  (Owner) {
+}
+
+//-----------------------------------------------------------------------------
+// the segment stays after the writer is gone, readers see the last values
+//-----------------------------------------------------------------------------
+mu2e::TrackerStatus::~TrackerStatus() {
+  munmap(_segment, sizeof(Segment));
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerStatus* mu2e::TrackerStatus::create(std::string const& Name) {
+  int fd = shm_open(Name.data(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) return nullptr;
+
+  if (ftruncate(fd, sizeof(Segment)) != 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  void* p = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return nullptr;
+//-----------------------------------------------------------------------------
+// a restarted writer starts from an empty table, the magic goes in last
+//-----------------------------------------------------------------------------
+  Segment* s = static_cast<Segment*>(p);
+  s->magic   = 0;
+  std::atomic_thread_fence(std::memory_order_release);
+
+  s->version   = kVersion;
+  s->blockSize = sizeof(Block);
+  s->nBlocks   = 0;
+  s->writerPid = getpid();
+  for (int i=0; i<kMaxBlocks; i++) s->block[i].seq = 0;
+
+  std::atomic_thread_fence(std::memory_order_release);
+  s->magic = kMagic;
+
+  return new TrackerStatus(Name, s, true);
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerStatus* mu2e::TrackerStatus::open(std::string const& Name) {
+  int fd = shm_open(Name.data(), O_RDONLY, 0);
+  if (fd < 0) return nullptr;
+
+  void* p = mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return nullptr;
+
+  Segment* s = static_cast<Segment*>(p);
+  if ((s->magic != kMagic) or (s->version != kVersion) or (s->blockSize != sizeof(Block))) {
+    munmap(p, sizeof(Segment));
+    return nullptr;
+  }
+
+  return new TrackerStatus(Name, s, false);
+}
+
+//-----------------------------------------------------------------------------
+// create() resets the segment, so it is called once per name in the process
+//-----------------------------------------------------------------------------
+std::shared_ptr<mu2e::TrackerStatus> mu2e::TrackerStatus::shared(std::string const& Name) {
+  static std::mutex                                          mutex;
+  static std::map<std::string, std::weak_ptr<TrackerStatus>> all;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  std::shared_ptr<TrackerStatus> s = all[Name].lock();
+  if (s == nullptr) {
+    s.reset(create(Name));
+    if (s) all[Name] = s;
+    else   all.erase(Name);
+  }
+  return s;
+}
+
+//-----------------------------------------------------------------------------
+int mu2e::TrackerStatus::block(std::string const& Name, Kind_t Kind, std::string const& Labels) {
+  if (not _owner) return -1;
+
+  std::lock_guard<std::mutex> lock(_blockMutex);
+
+  uint32_t n = _segment->nBlocks.load(std::memory_order_relaxed);
+  for (uint32_t i=0; i<n; i++) {
+    if (strncmp(_segment->block[i].name, Name.data(), kNameSize) == 0) return i;
+  }
+  if (n >= kMaxBlocks) return -1;
+
+  Block& b = _segment->block[n];
+  b.kind   = Kind;
+  b.time   = 0;
+  b.nWords = 0;
+  strncpy(b.name, Name.data(), kNameSize-1);
+  b.name[kNameSize-1] = 0;
+  strncpy(b.labels, Labels.data(), kLabelSize-1);
+  b.labels[kLabelSize-1] = 0;
+
+  _segment->nBlocks.store(n+1, std::memory_order_release);
+  return n;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerStatus::publish(int Index, const uint64_t* Words, size_t N) {
+  if ((not _owner) or (Index < 0) or (Index >= kMaxBlocks)) return;
+
+  Block&   b   = _segment->block[Index];
+  uint32_t seq = b.seq.load(std::memory_order_relaxed);
+
+  b.seq.store(seq+1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  b.nWords = (N < size_t(kMaxWords)) ? N : size_t(kMaxWords);
+  memcpy(b.word, Words, b.nWords*sizeof(uint64_t));
+  b.time   = std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+
+  b.seq.store(seq+2, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerStatus::publishValues(int Index, const double* Values, size_t N) {
+  uint64_t words[kMaxWords];
+  if (N > size_t(kMaxWords)) N = kMaxWords;
+  memcpy(words, Values, N*sizeof(double));
+  publish(Index, words, N);
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerStatus::publishRegisters(int Index, const uint16_t* Address, const uint32_t* Value, size_t N) {
+  uint64_t words[kMaxWords];
+  if (N > size_t(kMaxWords)) N = kMaxWords;
+  for (size_t i=0; i<N; i++) words[i] = (uint64_t(Address[i]) << 32) | Value[i];
+  publish(Index, words, N);
+}
+
+//-----------------------------------------------------------------------------
+// gives up after a few attempts if the writer keeps updating the block
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerStatus::read(int Index, Snapshot& S) const {
+  if ((Index < 0) or (size_t(Index) >= nBlocks())) return false;
+
+  Block const& b = _segment->block[Index];
+
+  for (int attempt=0; attempt<100; attempt++) {
+    uint32_t seq = b.seq.load(std::memory_order_acquire);
+    if (seq & 0x1) continue;
+
+    uint32_t n = b.nWords;
+    if (n > kMaxWords) continue;
+
+    S.name.assign(b.name, strnlen(b.name, kNameSize));
+    S.labels.assign(b.labels, strnlen(b.labels, kLabelSize));
+    S.kind = b.kind;
+    S.time = b.time;
+    S.word.assign(b.word, b.word+n);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (b.seq.load(std::memory_order_relaxed) == seq) return true;
+  }
+
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+double mu2e::TrackerStatus::value(uint64_t Word) {
+  double v;
+  memcpy(&v, &Word, sizeof(v));
+  return v;
+}
@@ -0,0 +1,112 @@
+#ifndef otsdaq_mu2e_tracker_Utilities_TrackerStatus_hh
+#define otsdaq_mu2e_tracker_Utilities_TrackerStatus_hh
+//-----------------------------------------------------------------------------
+// TrackerStatus : latest DTC/ROC register snapshots and rates in a POSIX
+// shared-memory segment (/dev/shm/<name>), readable without touching the
+// hardware
+//
+// - one writer per segment (a board reader or a front end), any number of
+//   readers (GUIs, scripts, trkStatus). Writers in one process (the ROCs of
+//   a front end) share it through shared(Name), each with its own blocks
+// - the segment holds up to kMaxBlocks named blocks of up to kMaxWords 64-bit
+//   words. Each block is a seqlock: the writer makes the sequence number odd,
+//   copies, makes it even; a reader retries until it gets the same even
+//   number before and after its copy
+// - registers are stored as (address << 32) | value, rates as doubles
+//
+// segment layout version: kVersion, readers check it
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mu2e {
+  class TrackerStatus {
+  public:
+    enum {
+      kMagic     = 0x54524b53,          // 'TRKS'
+      kVersion   = 1,
+      kMaxBlocks = 64,
+      kMaxWords  = 256,
+      kNameSize  = 48,
+      kLabelSize = 512                  // comma-separated names of the values
+    };
+
+    enum Kind_t {
+      kRegisters = 0,                   // (address << 32) | value
+      kValues    = 1                    // doubles
+    };
+
+    struct Block {
+      std::atomic<uint32_t> seq;
+      uint32_t              kind;
+      char                  name[kNameSize];
+      char                  labels[kLabelSize];
+      int64_t               time;       // ns, system clock
+      uint32_t              nWords;
+      uint32_t              unused;
+      uint64_t              word[kMaxWords];
+    };
+
+    struct Segment {
+      uint32_t              magic;
+      uint32_t              version;
+      uint32_t              blockSize;
+      std::atomic<uint32_t> nBlocks;
+      int32_t               writerPid;
+      uint32_t              unused;
+      Block                 block[kMaxBlocks];
+    };
+
+    struct Snapshot {
+      std::string           name;
+      std::string           labels;
+      int                   kind;
+      int64_t               time;
+      std::vector<uint64_t> word;
+    };
+//-----------------------------------------------------------------------------
+// writer: creates (or takes over) the segment
+//-----------------------------------------------------------------------------
+    static TrackerStatus* create   (std::string const& Name);
+//-----------------------------------------------------------------------------
+// writer: the segment of this process, created by the first caller and
+// unmapped after the last one is gone
+//-----------------------------------------------------------------------------
+    static std::shared_ptr<TrackerStatus> shared(std::string const& Name);
+//-----------------------------------------------------------------------------
+// reader: nullptr if the segment doesn't exist or has another layout
+//-----------------------------------------------------------------------------
+    static TrackerStatus* open     (std::string const& Name);
+
+    ~TrackerStatus();
+                                        // index of the block with this name, created if needed, -1 if full
+    int    block         (std::string const& Name, Kind_t Kind, std::string const& Labels = "");
+
+    void   publish       (int Block, const uint64_t* Words, size_t N);
+    void   publishValues (int Block, const double* Values, size_t N);
+                                        // Address[i] and Value[i]
+    void   publishRegisters(int Block, const uint16_t* Address, const uint32_t* Value, size_t N);
+
+    size_t nBlocks       () const { return _segment->nBlocks.load(std::memory_order_acquire); }
+    bool   read          (int Block, Snapshot& S) const;
+
+    static double   value  (uint64_t Word);
+    static uint32_t address(uint64_t Word) { return Word >> 32; }
+    static uint32_t regData(uint64_t Word) { return Word & 0xffffffff; }
+
+  private:
+    TrackerStatus(std::string const& Name, Segment* S, bool Owner);
+
+    std::string _name;
+    Segment*    _segment;
+    bool        _owner;
+    std::mutex  _blockMutex;            // block() by several writers of the process
+  };
+}  // namespace mu2e
+
+#endif
@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////
+// work-stealing task pool, see TrackerTaskPool.hh
+///////////////////////////////////////////////////////////////////////////////
+#include "otsdaq-mu2e-tracker/Utilities/TrackerTaskPool.hh"
+
+#include <chrono>
+
+namespace {
+  thread_local int workerIndex_ = -1;
+}
+
+//-----------------------------------------------------------------------------
+mu2e::TrackerTaskPool::TrackerTaskPool(int NThreads, init_t Init) :
+    _pending(0)
+  , _queued (0)
+  , _next   (0)
+  , _nStolen(0)
+  , _stop   (false) {
+
+  for (int i=0; i<NThreads; i++) _queues.emplace_back(new Queue);
+  for (int i=0; i<NThreads; i++) _threads.emplace_back(&TrackerTaskPool::run_, this, i, Init);
+}
+
+//-----------------------------------------------------------------------------
+// the tasks still queued are run before the workers exit
+//-----------------------------------------------------------------------------
+mu2e::TrackerTaskPool::~TrackerTaskPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _work.notify_all();
+  for (auto& t : _threads) t.join();
+}
+
+//-----------------------------------------------------------------------------
+int mu2e::TrackerTaskPool::workerIndex() {
+  return workerIndex_;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerTaskPool::submit(task_t Task) {
+  if (_threads.empty()) {
+    _pending++;
+    execute_(Task);
+    return;
+  }
+
+  _pending++;
+
+  Queue* q = _queues[_next++ % _queues.size()].get();
+  {
+    std::lock_guard<std::mutex> lock(q->mutex);
+    _queued++;
+    q->tasks.push_back(std::move(Task));
+  }
+//-----------------------------------------------------------------------------
+// a worker checks _queued under _mutex before it sleeps, so it can't miss this
+//-----------------------------------------------------------------------------
+  { std::lock_guard<std::mutex> lock(_mutex); }
+  _work.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+// newest task of the own queue first, then the oldest of the others.
+// Self = -1 (not a worker): steal only
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerTaskPool::pop_(int Self, task_t& Task) {
+  if (_queued == 0) return false;
+
+  if (Self >= 0) {
+    Queue* q = _queues[Self].get();
+    std::lock_guard<std::mutex> lock(q->mutex);
+    if (not q->tasks.empty()) {
+      Task = std::move(q->tasks.back());
+      q->tasks.pop_back();
+      _queued--;
+      return true;
+    }
+  }
+
+  size_t n = _queues.size();
+  for (size_t k=1; k<=n; k++) {
+    Queue* q = _queues[(Self+k+n) % n].get();
+    std::lock_guard<std::mutex> lock(q->mutex);
+    if (q->tasks.empty()) continue;
+    Task = std::move(q->tasks.front());
+    q->tasks.pop_front();
+    _queued--;
+    _nStolen++;
+    return true;
+  }
+
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerTaskPool::execute_(task_t& Task) {
+  try {
+    Task();
+  }
+  catch (...) {
+    std::lock_guard<std::mutex> lock(_errorMutex);
+    if (not _error) _error = std::current_exception();
+  }
+
+  if (--_pending == 0) {
+    { std::lock_guard<std::mutex> lock(_mutex); }
+    _idle.notify_all();
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool mu2e::TrackerTaskPool::runOne() {
+  task_t task;
+  if (not pop_(workerIndex_, task)) return false;
+  execute_(task);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerTaskPool::wait() {
+  while (_pending > 0) {
+    if (runOne()) continue;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait_for(lock, std::chrono::milliseconds(1), [this] { return (_pending == 0) or (_queued > 0); });
+  }
+
+  std::lock_guard<std::mutex> lock(_errorMutex);
+  if (_error) {
+    std::exception_ptr e = _error;
+    _error = nullptr;
+    std::rethrow_exception(e);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void mu2e::TrackerTaskPool::run_(int Index, init_t Init) {
+  workerIndex_ = Index;
+  if (Init) Init(Index);
+
+  while (true) {
+    task_t task;
+    if (pop_(Index, task)) {
+      execute_(task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_stop and (_queued == 0)) break;
+    _work.wait(lock, [this] { return _stop or (_queued > 0); });
+  }
+}
@@ -0,0 +1,76 @@
+#ifndef otsdaq_mu2e_tracker_Utilities_TrackerTaskPool_hh
+#define otsdaq_mu2e_tracker_Utilities_TrackerTaskPool_hh
+//-----------------------------------------------------------------------------
+// TrackerTaskPool : small work-stealing pool for the per-buffer work of the
+// board reader
+//
+// - each worker has its own queue; submit() deals the tasks out round-robin,
+//   a worker takes the newest task of its own queue and, when that is empty,
+//   steals the oldest one of another queue
+// - wait() returns when everything submitted so far is done; the waiting
+//   thread runs pending tasks itself instead of sleeping
+// - no ordering between the tasks: the caller decides where each result goes
+//   before submitting it (TrackerVST reserves the space in the fragment)
+// - with 0 threads submit() runs the task right away on the calling thread
+// - an exception thrown by a task is rethrown by the next wait()
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mu2e {
+  class TrackerTaskPool {
+  public:
+    typedef std::function<void()>           task_t;
+    typedef std::function<void(int Worker)> init_t;   // run by each worker when it starts
+
+    explicit TrackerTaskPool(int NThreads, init_t Init = nullptr);
+    ~TrackerTaskPool();
+
+    void   submit      (task_t Task);
+    void   wait        ();
+                                        // one pending task on the calling thread, false if there was none
+    bool   runOne      ();
+
+    int    nThreads    () const { return _threads.size(); }
+    size_t nStolen     () const { return _nStolen; }
+    size_t nPending    () const { return _pending; }
+                                        // 0..nThreads-1 on a worker, -1 elsewhere
+    static int workerIndex();
+
+  private:
+    struct Queue {
+      std::mutex          mutex;
+      std::deque<task_t>  tasks;
+    };
+
+    bool   pop_        (int Self, task_t& Task);
+    void   execute_    (task_t& Task);
+    void   run_        (int Index, init_t Init);
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread>            _threads;
+
+    std::atomic<size_t>      _pending;          // submitted, not finished
+    std::atomic<size_t>      _queued;           // submitted, not started
+    std::atomic<size_t>      _next;             // round-robin
+    std::atomic<size_t>      _nStolen;
+
+    std::mutex               _mutex;            // sleeping and waking up only
+    std::condition_variable  _work;
+    std::condition_variable  _idle;
+    bool                     _stop;
+
+    std::mutex               _errorMutex;
+    std::exception_ptr       _error;
+  };
+}  // namespace mu2e
+
+#endif
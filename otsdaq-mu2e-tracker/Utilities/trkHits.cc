@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// trkHits : summary and column dump of a TrackerHitFile
+//
+// usage: trkHits <file> [column ...]
+//   no columns : one line per chunk, number of hits and the ewt/time/charge ranges
+//   columns    : one line per hit with the listed columns (ewt link channel
+//                flags time0 time1 charge waveform)
+///////////////////////////////////////////////////////////////////////////////
+#include "otsdaq-mu2e-tracker/Utilities/TrackerHitFile.hh"
+
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using mu2e::TrackerHitFile;
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage: %s <file> [column ...]\n", argv[0]);
+    return 1;
+  }
+
+  std::unique_ptr<mu2e::TrackerHitReader> r(mu2e::TrackerHitReader::open(argv[1]));
+  if (not r) {
+    printf("%s is not a tracker hit file\n", argv[1]);
+    return 1;
+  }
+
+  std::vector<int> column;
+  for (int i=2; i<argc; i++) {
+    int k = TrackerHitFile::column(argv[i]);
+    if (k < 0) {
+      printf("unknown column %s\n", argv[i]);
+      return 1;
+    }
+    column.push_back(k);
+  }
+
+  if (column.empty()) {
+    printf("%s : %zu hits in %zu chunks, %d waveform samples%s\n", argv[1], r->nHits(), r->nChunks(),
+           r->nSamples(), r->complete() ? "" : ", no index (file not closed)");
+    printf("chunk     hits            ewt range           time0 range (ns)      charge range\n");
+    for (size_t i=0; i<r->nChunks(); i++) {
+      printf("%5zu %8u %12.0f %12.0f %10.2f %10.2f %10.2f %10.2f\n", i, r->nHits(i),
+             r->min(i, TrackerHitFile::kEwt   ), r->max(i, TrackerHitFile::kEwt   ),
+             r->min(i, TrackerHitFile::kTime0 ), r->max(i, TrackerHitFile::kTime0 ),
+             r->min(i, TrackerHitFile::kCharge), r->max(i, TrackerHitFile::kCharge));
+    }
+    return 0;
+  }
+
+  for (size_t i=0; i<r->nChunks(); i++) {
+    for (uint32_t h=0; h<r->nHits(i); h++) {
+      for (int k : column) {
+        switch (k) {
+        case TrackerHitFile::kEwt    : printf(" %12" PRIu64, r->column<uint64_t>(i, TrackerHitFile::kEwt    )[h]); break;
+        case TrackerHitFile::kLink   : printf(" %2u"       , r->column<uint8_t >(i, TrackerHitFile::kLink   )[h]); break;
+        case TrackerHitFile::kChannel: printf(" %3u"       , r->column<uint8_t >(i, TrackerHitFile::kChannel)[h]); break;
+        case TrackerHitFile::kFlags  : printf(" 0x%04x"    , r->column<uint16_t>(i, TrackerHitFile::kFlags  )[h]); break;
+        case TrackerHitFile::kTime0  : printf(" %10.3f"    , r->column<float   >(i, TrackerHitFile::kTime0  )[h]); break;
+        case TrackerHitFile::kTime1  : printf(" %10.3f"    , r->column<float   >(i, TrackerHitFile::kTime1  )[h]); break;
+        case TrackerHitFile::kCharge : printf(" %10.2f"    , r->column<float   >(i, TrackerHitFile::kCharge )[h]); break;
+        case TrackerHitFile::kWaveform: {
+          const uint16_t* w = r->column<uint16_t>(i, TrackerHitFile::kWaveform) + size_t(h)*r->nSamples();
+          for (int s=0; s<r->nSamples(); s++) printf(" %4u", w[s]);
+          break;
+        }
+        }
+      }
+      printf("\n");
+    }
+  }
+
+  return 0;
+}
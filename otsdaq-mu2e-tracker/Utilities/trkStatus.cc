@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+// trkStatus : print the tracker status exported to shared memory
+//
+// usage: trkStatus <segment> [block_name]
+//   segment : /trk_status_dtc0, /trk_status_<rocUID>, ...  (ls /dev/shm)
+// no DTC/ROC access, safe to run during data taking
+///////////////////////////////////////////////////////////////////////////////
+#include "otsdaq-mu2e-tracker/Utilities/TrackerStatus.hh"
+
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage: %s <segment> [block_name]\n", argv[0]);
+    return 1;
+  }
+
+  std::unique_ptr<mu2e::TrackerStatus> status(mu2e::TrackerStatus::open(argv[1]));
+  if (not status) {
+    printf("no tracker status segment %s\n", argv[1]);
+    return 1;
+  }
+
+  mu2e::TrackerStatus::Snapshot s;
+  for (size_t i=0; i<status->nBlocks(); i++) {
+    if (not status->read(i, s)) {
+      printf("%-40s : busy\n", "?");
+      continue;
+    }
+    if ((argc > 2) and (s.name != argv[2])) continue;
+
+    time_t t = s.time/1000000000;
+    char   tstr[32];
+    strftime(tstr, sizeof(tstr), "%F %T", localtime(&t));
+    printf("%-40s updated %s\n", s.name.data(), tstr);
+
+    std::vector<std::string> label;
+    std::stringstream        labels(s.labels);
+    for (std::string l; std::getline(labels, l, ',');) label.push_back(l);
+
+    for (size_t k=0; k<s.word.size(); k++) {
+      if (s.kind == mu2e::TrackerStatus::kRegisters) {
+        printf("  reg[%3u] : 0x%08x\n", mu2e::TrackerStatus::address(s.word[k]), mu2e::TrackerStatus::regData(s.word[k]));
+      }
+      else {
+        printf("  %-24s : %g\n", (k < label.size()) ? label[k].data() : std::to_string(k).data(),
+               mu2e::TrackerStatus::value(s.word[k]));
+      }
+    }
+  }
+
+  return 0;
+}
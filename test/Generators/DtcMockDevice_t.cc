@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////////////////
+// DtcMockDevice : the DAQ read loop, 48-bit tags, timeouts, the order of the
+// buffer releases (mock_config.track_releases), several DTCs behind
+// DtcMultiDevice
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE DtcMockDevice_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Generators/DtcMockDevice.hh"
+#include "otsdaq-mu2e-tracker/Generators/DtcMultiDevice.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <cstring>
+#include <deque>
+
+using namespace mu2e;
+using namespace DTCLib;
+
+namespace {
+//-----------------------------------------------------------------------------
+// no DMA latency or bandwidth limit: the reads don't wait
+//-----------------------------------------------------------------------------
+  fhicl::ParameterSet mockConfig(double TimeoutFraction = 0., size_t NBuffers = 32) {
+    fhicl::ParameterSet ps;
+    ps.put("dma_latency_us", 0.);
+    ps.put("bandwidth_mb_per_s", 0.);
+    ps.put("timeout_fraction", TimeoutFraction);
+    ps.put("n_buffers", NBuffers);
+    ps.put("random_seed", 5u);
+    ps.put("track_releases", true);
+    return ps;
+  }
+
+  uint64_t tag(const void* Buffer) {
+    auto eh = reinterpret_cast<const DTC_EventHeader*>(static_cast<const uint8_t*>(Buffer) + 8);
+    return uint64_t(eh->event_tag_low) | (uint64_t(eh->event_tag_high) << 32);
+  }
+
+  uint16_t firstWord(const void* Buffer) { return *static_cast<const uint16_t*>(Buffer); }
+
+  void request(DtcDevice& D, uint64_t Tag) { D.SendRequestForTimestamp(DTC_EventWindowTag(Tag), 0); }
+}
+
+BOOST_AUTO_TEST_SUITE(DtcMockDevice_test)
+
+BOOST_AUTO_TEST_CASE(ReadLoop) {
+  DtcMockDevice d(mockConfig());
+
+  for (uint64_t t = 10; t < 15; t++) request(d, t);
+  for (uint64_t t = 10; t < 15; t++) {
+    void* buffer;
+    int   sts = d.read_data(DTC_DMA_Engine_DAQ, &buffer, 10);
+    BOOST_REQUIRE_GT(sts, 0);
+    BOOST_CHECK_EQUAL(tag(buffer), t);
+
+    // the DMA byte count includes itself
+    uint64_t nbytes;
+    memcpy(&nbytes, buffer, sizeof(nbytes));
+    BOOST_CHECK_EQUAL(nbytes, uint64_t(sts));
+    auto eh = reinterpret_cast<const DTC_EventHeader*>(static_cast<const uint8_t*>(buffer) + 8);
+    BOOST_CHECK_EQUAL(eh->inclusive_event_byte_count, uint64_t(sts) - 8);
+    d.read_release(DTC_DMA_Engine_DAQ, 1);
+  }
+  BOOST_CHECK_EQUAL(d.nHeld(), 0u);
+  BOOST_CHECK_EQUAL(d.nBadReleases(), 0u);
+}
+
+//-----------------------------------------------------------------------------
+// the 48-bit tag goes through whole, the heartbeat count is a separate argument
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(LargeTag) {
+  DtcMockDevice d(mockConfig());
+
+  uint64_t t = (uint64_t(1) << 32) + 5;
+  d.SendRequestForTimestamp(DTC_EventWindowTag(t), 16);
+  BOOST_CHECK_EQUAL(d.lastHeartbeatsAfter(), 16u);
+
+  void* buffer;
+  BOOST_REQUIRE_GT(d.read_data(DTC_DMA_Engine_DAQ, &buffer, 10), 0);
+  BOOST_CHECK_EQUAL(tag(buffer), t);
+  d.read_release(DTC_DMA_Engine_DAQ, 1);
+
+  d.SendRequestsForRange(2, DTC_EventWindowTag(t+1), true, 0, 0, 4);
+  BOOST_CHECK_EQUAL(d.lastHeartbeatsAfter(), 4u);
+  for (uint64_t i = 1; i < 3; i++) {
+    BOOST_REQUIRE_GT(d.read_data(DTC_DMA_Engine_DAQ, &buffer, 10), 0);
+    BOOST_CHECK_EQUAL(tag(buffer), t+i);
+    d.read_release(DTC_DMA_Engine_DAQ, 1);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// no request, or a request never answered: sts = 0 after the timeout, no
+// buffer to give back
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Timeout) {
+  DtcMockDevice d(mockConfig(1.));
+
+  void* buffer = &d;
+  auto  start  = std::chrono::steady_clock::now();
+  BOOST_CHECK_EQUAL(d.read_data(DTC_DMA_Engine_DAQ, &buffer, 20), 0);
+  BOOST_CHECK(buffer == nullptr);
+  BOOST_CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+
+  request(d, 1);
+  BOOST_CHECK_EQUAL(d.read_data(DTC_DMA_Engine_DAQ, &buffer, 1), 0);
+  BOOST_CHECK_EQUAL(d.nHeld(), 0u);
+  BOOST_CHECK_GT(d.GetDeviceTime(), 0.02);
+}
+
+//-----------------------------------------------------------------------------
+// oldest first; a released buffer reads 0xdead; a release with nothing out
+// is counted. The ring holds n_buffers, then the reads wait for a release
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ReleaseOrder) {
+  DtcMockDevice d(mockConfig(0., 3));
+
+  void* buffer[4];
+  for (uint64_t t = 0; t < 4; t++) request(d, t);
+  for (int i = 0; i < 3; i++) BOOST_REQUIRE_GT(d.read_data(DTC_DMA_Engine_DAQ, &buffer[i], 1), 0);
+  BOOST_CHECK_EQUAL(d.read_data(DTC_DMA_Engine_DAQ, &buffer[3], 1), 0);
+  BOOST_CHECK_EQUAL(d.nHeld(), 3u);
+
+  d.read_release(DTC_DMA_Engine_DAQ, 1);
+  BOOST_CHECK_EQUAL(firstWord(buffer[0]), 0xdead);
+  BOOST_CHECK_EQUAL(tag(buffer[1]), 1u);
+
+  BOOST_REQUIRE_GT(d.read_data(DTC_DMA_Engine_DAQ, &buffer[3], 1), 0);
+  BOOST_CHECK_EQUAL(tag(buffer[3]), 3u);
+  BOOST_CHECK(buffer[3] == buffer[0]);  // the ring goes round
+
+  d.read_release(DTC_DMA_Engine_DAQ, 2);
+  d.release_all(DTC_DMA_Engine_DAQ);
+  BOOST_CHECK_EQUAL(d.nHeld(), 0u);
+  BOOST_CHECK((d.releasedTags() == std::vector<uint64_t>{0, 1, 2, 3}));
+  BOOST_CHECK_EQUAL(d.nBadReleases(), 0u);
+
+  d.read_release(DTC_DMA_Engine_DAQ, 1);
+  BOOST_CHECK_EQUAL(d.nBadReleases(), 1u);
+}
+
+//-----------------------------------------------------------------------------
+// the TrackerVST loop: requests ahead, some never answered, a few buffers held
+// while they are copied, released oldest first. Only the reads with sts > 0
+// are released: every buffer is intact until its own release
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(HeldBuffers) {
+  DtcMockDevice d(mockConfig(0.3, 4));
+
+  const size_t         maxHeld = 2;
+  std::vector<uint64_t> read;
+  std::deque<std::pair<void*, uint64_t>> held;
+
+  for (uint64_t t = 0; t < 200; t++) {
+    request(d, t);
+    void* buffer;
+    int   sts = d.read_data(DTC_DMA_Engine_DAQ, &buffer, 1);
+    if (sts > 0) {
+      read.push_back(tag(buffer));
+      held.emplace_back(buffer, tag(buffer));
+    }
+
+    for (auto const& h : held) BOOST_REQUIRE_EQUAL(tag(h.first), h.second);
+    while (held.size() > maxHeld) {
+      d.read_release(DTC_DMA_Engine_DAQ, 1);
+      held.pop_front();
+    }
+  }
+  for (; not held.empty(); held.pop_front()) d.read_release(DTC_DMA_Engine_DAQ, 1);
+
+  BOOST_CHECK_GT(read.size(), 100u);
+  BOOST_CHECK_LT(read.size(), 180u);
+  BOOST_CHECK(d.releasedTags() == read);
+  BOOST_CHECK_EQUAL(d.nBadReleases(), 0u);
+  BOOST_CHECK_EQUAL(d.nHeld(), 0u);
+}
+
+//-----------------------------------------------------------------------------
+// releasing for a read which timed out gives back a buffer still in use
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ReleaseAfterTimeout) {
+  DtcMockDevice d(mockConfig());
+
+  void* buffer;
+  request(d, 1);
+  BOOST_REQUIRE_GT(d.read_data(DTC_DMA_Engine_DAQ, &buffer, 1), 0);
+
+  void* none;
+  BOOST_CHECK_EQUAL(d.read_data(DTC_DMA_Engine_DAQ, &none, 1), 0);
+  d.read_release(DTC_DMA_Engine_DAQ, 1);
+  BOOST_CHECK_EQUAL(firstWord(buffer), 0xdead);
+}
+
+//-----------------------------------------------------------------------------
+// each buffer goes back to its own DTC, a release with nothing held to none
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(MultiDevice) {
+  fhicl::ParameterSet c1 = mockConfig();
+  c1.put_or_replace("dtc_id", 1);
+  DtcMockDevice* d0 = new DtcMockDevice(mockConfig());
+  DtcMockDevice* d1 = new DtcMockDevice(c1);
+  DtcMultiDevice m({d0, d1}, fhicl::ParameterSet());
+
+  for (uint64_t t = 0; t < 3; t++) request(m, t);
+
+  std::vector<int> source;
+  void*            buffer;
+  while (m.read_data(DTC_DMA_Engine_DAQ, &buffer, 1) > 0) source.push_back(m.lastSource());
+  BOOST_CHECK_EQUAL(source.size(), 6u);
+  BOOST_CHECK_EQUAL(m.nReads(0), 3u);
+  BOOST_CHECK_EQUAL(m.nReads(1), 3u);
+
+  m.read_release(DTC_DMA_Engine_DAQ, 3);
+  BOOST_CHECK_EQUAL(d0->nHeld() + d1->nHeld(), 3u);
+  m.read_release(DTC_DMA_Engine_DAQ, 5);
+  BOOST_CHECK_EQUAL(d0->nHeld() + d1->nHeld(), 0u);
+  BOOST_CHECK_EQUAL(m.nStrayReleases(), 2u);
+
+  BOOST_CHECK((d0->releasedTags() == std::vector<uint64_t>{0, 1, 2}));
+  BOOST_CHECK((d1->releasedTags() == std::vector<uint64_t>{0, 1, 2}));
+  BOOST_CHECK_EQUAL(d0->nBadReleases() + d1->nBadReleases(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
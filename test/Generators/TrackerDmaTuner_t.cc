@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerDmaTuner : the sweep over the register values, the choice of the best
+// point, the profile, register writes only for named registers and on change,
+// the latency of requests sent at once
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerDmaTuner_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerDmaTuner.hh"
+#include "otsdaq-mu2e-tracker/Generators/DtcMockDevice.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace mu2e;
+using namespace DTCLib;
+
+namespace {
+//-----------------------------------------------------------------------------
+// the mock DTC, keeping a list of the register writes
+//-----------------------------------------------------------------------------
+  class CountingDevice : public DtcMockDevice {
+  public:
+    CountingDevice() : DtcMockDevice(fhicl::ParameterSet()) {}
+
+    void WriteRegister(uint32_t data, DTC_Register const& address) override {
+      writes.push_back({uint16_t(address), data});
+      DtcMockDevice::WriteRegister(data, address);
+    }
+
+    std::vector<std::pair<uint16_t, uint32_t>> writes;
+  };
+
+  std::string profileFile() { return "/tmp/TrackerDmaTuner_t_" + std::to_string(::getpid()) + ".fcl"; }
+
+//-----------------------------------------------------------------------------
+// one call of TrackerVST::getNext_: apply, then NReads reads of Bytes each,
+// Seconds each
+//-----------------------------------------------------------------------------
+  void run(TrackerDmaTuner& T, DtcDevice* D, size_t NReads, size_t Bytes, double Seconds) {
+    T.apply(D);
+    for (size_t i = 0; i < NReads; i++) {
+      T.requestSent();
+      T.readDone(Bytes, false, Seconds);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerDmaTuner_test)
+
+//-----------------------------------------------------------------------------
+// two values of 0x9104, the second one faster: it ends up in the profile, the
+// register not swept goes in with its current value, 0x91a8 not at all
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Sweep) {
+  CountingDevice d;
+  d.DtcMockDevice::WriteRegister(0x20, DTC_Register(0x9144));
+
+  fhicl::ParameterSet ps;
+  ps.put("enabled", true);
+  ps.put("dma_transfer_length", std::vector<int64_t>{0x100, 0x200});
+  ps.put("settle_reads", size_t(2));
+  ps.put("reads_per_point", size_t(10));
+  ps.put("profile_file", profileFile());
+  TrackerDmaTuner t(ps, fhicl::ParameterSet(), 0);
+  BOOST_CHECK_EQUAL(t.nPoints(), 2u);
+
+  // time outside the reads does not count: same bytes, half the read time
+  run(t, &d, 12, 1000, 1.e-3);
+  BOOST_CHECK_EQUAL(t.point(), 1u);
+  run(t, &d, 12, 1000, 0.5e-3);
+  BOOST_CHECK(not t.tuning());
+  BOOST_CHECK_EQUAL(t.best().value[TrackerDmaTuner::kDmaTransferLength], 0x200);
+  BOOST_CHECK_CLOSE(t.best().throughput(), 2.e6, 1.e-6);
+
+  BOOST_REQUIRE_EQUAL(d.writes.size(), 2u);
+  BOOST_CHECK_EQUAL(d.writes[0].first, 0x9104);
+  BOOST_CHECK_EQUAL(d.writes[0].second, 0x100u);
+  BOOST_CHECK_EQUAL(d.writes[1].second, 0x200u);
+
+  std::ifstream     in(profileFile());
+  std::stringstream profile;
+  profile << in.rdbuf();
+  std::remove(profileFile().c_str());
+  BOOST_CHECK(profile.str().find("dma_transfer_length :        512") != std::string::npos);
+  BOOST_CHECK(profile.str().find("dtc_timeout         :         32") != std::string::npos);
+  BOOST_CHECK(profile.str().find("ewm_delta_t         :          0") != std::string::npos);
+}
+
+//-----------------------------------------------------------------------------
+// a profile: its registers are written once, again only after invalidate()
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Profile) {
+  CountingDevice d;
+
+  fhicl::ParameterSet profile;
+  profile.put("ewm_delta_t", int64_t(0x80));
+  TrackerDmaTuner t(fhicl::ParameterSet(), profile, 0);
+
+  for (int i = 0; i < 5; i++) run(t, &d, 4, 100, 1.e-3);
+  BOOST_REQUIRE_EQUAL(d.writes.size(), 1u);
+  BOOST_CHECK_EQUAL(d.writes[0].first, 0x91a8);
+  BOOST_CHECK_EQUAL(d.writes[0].second, 0x80u);
+  BOOST_CHECK_EQUAL(d.ReadRegister(DTC_Register(0x91a8)), 0x80u);
+
+  t.invalidate();
+  run(t, &d, 4, 100, 1.e-3);
+  BOOST_CHECK_EQUAL(d.writes.size(), 2u);
+}
+
+//-----------------------------------------------------------------------------
+// the requests of SendRequestsForRange sent at once: every read of the point
+// is paired with its own send time
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Latency) {
+  CountingDevice d;
+
+  fhicl::ParameterSet ps;
+  ps.put("enabled", true);
+  ps.put("dma_transfer_length", std::vector<int64_t>{0x100});
+  ps.put("settle_reads", size_t(0));
+  ps.put("reads_per_point", size_t(4));
+  ps.put("profile_file", profileFile());
+  TrackerDmaTuner t(ps, fhicl::ParameterSet(), 0);
+
+  t.apply(&d);
+  t.requestSent(4);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  for (int i = 0; i < 4; i++) t.readDone(1000, false, 1.e-3);
+  std::remove(profileFile().c_str());
+
+  BOOST_CHECK(not t.tuning());
+  BOOST_CHECK_GE(t.best().meanLatencyUs(), 2000.);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
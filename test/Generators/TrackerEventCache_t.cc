@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerEventCache : insert and find, eviction by a newer window in the same
+// slot, range lookups, the newest tag, events too long, max_age_ms, several
+// sources
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerEventCache_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerEventCache.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerPlacement.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace mu2e;
+
+namespace {
+//-----------------------------------------------------------------------------
+// a ring of 4 windows of 32 bytes, default placement (no NUMA binding)
+//-----------------------------------------------------------------------------
+  struct Fixture {
+    fhicl::ParameterSet ps;
+    TrackerPlacement    placement;
+
+    Fixture() : placement(fhicl::ParameterSet(), 0) {
+      ps.put("n_windows", size_t(4));
+      ps.put("slot_bytes", size_t(32));
+    }
+
+    static std::string event(uint64_t Tag) { return "event " + std::to_string(Tag); }
+
+    static void insert(TrackerEventCache& C, uint64_t Tag) {
+      std::string e = event(Tag);
+      BOOST_REQUIRE(C.insert(Tag, e.data(), e.size()));
+    }
+
+    static std::string find(TrackerEventCache const& C, uint64_t Tag) {
+      size_t         size;
+      const uint8_t* data = C.find(Tag, size);
+      return data ? std::string(reinterpret_cast<const char*>(data), size) : std::string();
+    }
+  };
+}
+
+BOOST_FIXTURE_TEST_SUITE(TrackerEventCache_test, Fixture)
+
+BOOST_AUTO_TEST_CASE(InsertFind) {
+  TrackerEventCache c(ps, &placement);
+  BOOST_CHECK(c.empty());
+
+  for (uint64_t t = 1; t <= 3; t++) insert(c, t);
+  BOOST_CHECK(not c.empty());
+  BOOST_CHECK_EQUAL(c.nInserted(), 3u);
+  for (uint64_t t = 1; t <= 3; t++) BOOST_CHECK_EQUAL(find(c, t), event(t));
+
+  // a copy: the caller's buffer can be given back to the DMA ring
+  std::string e = "overwritten";
+  c.insert(9, e.data(), e.size());
+  e[0] = 'X';
+  BOOST_CHECK_EQUAL(find(c, 9), "overwritten");
+
+  size_t size = 1;
+  BOOST_CHECK(c.find(4, size) == nullptr);
+  BOOST_CHECK_EQUAL(size, 0u);
+}
+
+//-----------------------------------------------------------------------------
+// tag N lives in slot N % 4: 5 and 6 evict 1 and 2
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Eviction) {
+  TrackerEventCache c(ps, &placement);
+
+  for (uint64_t t = 1; t <= 6; t++) insert(c, t);
+  BOOST_CHECK_EQUAL(find(c, 1), "");
+  BOOST_CHECK_EQUAL(find(c, 2), "");
+  for (uint64_t t = 3; t <= 6; t++) BOOST_CHECK_EQUAL(find(c, t), event(t));
+
+  std::vector<TrackerEventCache::Event_t> events;
+  BOOST_REQUIRE_EQUAL(c.findRange(1, 6, events), 4u);
+  for (size_t i = 0; i < events.size(); i++) {
+    BOOST_CHECK_EQUAL(std::string(reinterpret_cast<const char*>(events[i].first), events[i].second), event(i + 3));
+  }
+
+  // a range longer than the ring: only its newest part is looked at
+  BOOST_CHECK_EQUAL(c.findRange(0, 100, events), 0u);
+  BOOST_CHECK_EQUAL(c.findRange(6, 5, events), 0u);
+}
+
+//-----------------------------------------------------------------------------
+// windows may come back out of order (re-requested ones)
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(NewestTag) {
+  TrackerEventCache c(ps, &placement);
+
+  insert(c, 7);
+  insert(c, 3);
+  BOOST_CHECK_EQUAL(c.newestTag(), 7u);
+  insert(c, 8);
+  BOOST_CHECK_EQUAL(c.newestTag(), 8u);
+}
+
+BOOST_AUTO_TEST_CASE(TooLong) {
+  TrackerEventCache c(ps, &placement);
+
+  std::string e(33, 'x');
+  BOOST_CHECK(not c.insert(1, e.data(), e.size()));
+  BOOST_CHECK_EQUAL(c.nTooLong(), 1u);
+  BOOST_CHECK(c.empty());
+  BOOST_CHECK(c.insert(1, e.data(), 32));
+}
+
+BOOST_AUTO_TEST_CASE(MaxAge) {
+  ps.put("max_age_ms", size_t(5));
+  TrackerEventCache c(ps, &placement);
+
+  insert(c, 1);
+  BOOST_CHECK_EQUAL(find(c, 1), event(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  BOOST_CHECK_EQUAL(find(c, 1), "");
+}
+
+//-----------------------------------------------------------------------------
+// two DTCs: one slot per window and source, a window is complete once both
+// have delivered it, findRange returns both in tag then source order
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Sources) {
+  TrackerEventCache c(ps, &placement, 2);
+  BOOST_CHECK_EQUAL(c.nSources(), 2u);
+
+  std::string e0 = "dtc 0", e1 = "dtc 1";
+  for (uint64_t t = 1; t <= 3; t++) BOOST_REQUIRE(c.insert(t, e0.data(), e0.size(), 0));
+  BOOST_REQUIRE(c.insert(1, e1.data(), e1.size(), 1));
+  BOOST_CHECK_EQUAL(c.newestTag(), 1u);
+
+  size_t size;
+  BOOST_CHECK(c.find(1, size, 1) != nullptr);
+  BOOST_CHECK(c.find(2, size, 1) == nullptr);
+  BOOST_CHECK_EQUAL(find(c, 2), e0);
+
+  BOOST_REQUIRE(c.insert(2, e1.data(), e1.size(), 1));
+  BOOST_CHECK_EQUAL(c.newestTag(), 2u);
+
+  std::vector<TrackerEventCache::Event_t> events;
+  BOOST_REQUIRE_EQUAL(c.findRange(1, 2, events), 4u);
+  const char* expected[] = {"dtc 0", "dtc 1", "dtc 0", "dtc 1"};
+  for (size_t i = 0; i < events.size(); i++) {
+    BOOST_CHECK_EQUAL(std::string(reinterpret_cast<const char*>(events[i].first), events[i].second), expected[i]);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerFragmentIndex : index written the way TrackerVST does it and read
+// back, the 8-byte alignment of the index, lookups, windows out of order, a
+// fragment without an index
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerFragmentIndex_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerFragmentIndex.hh"
+
+#include "artdaq-core-mu2e/Overlays/FragmentType.hh"
+#include "artdaq-core-mu2e/Overlays/mu2eFragmentWriter.hh"
+#include "dtcInterfaceLib/DTC.h"
+
+#include <cstring>
+
+using namespace mu2e;
+using namespace DTCLib;
+
+namespace {
+//-----------------------------------------------------------------------------
+// one DTC event with the (link, ewt) ROC blocks, link+1 data packets each
+//-----------------------------------------------------------------------------
+  std::vector<uint8_t> event(int Dtc, std::vector<std::pair<int, uint64_t>> const& Blocks) {
+    std::vector<uint8_t> b(sizeof(DTC_EventHeader) + sizeof(DTC_SubEventHeader));
+    for (auto const& r : Blocks) {
+      int      npackets = r.first + 1;
+      uint16_t w[8]     = {uint16_t(16 * (npackets + 1)), uint16_t(0x8000 | (r.first << 8) | 0x50), uint16_t(npackets),
+                           uint16_t(r.second), uint16_t(r.second >> 16), uint16_t(r.second >> 32), 0, 0};
+      const uint8_t* p = reinterpret_cast<const uint8_t*>(w);
+      b.insert(b.end(), p, p + sizeof(w));
+      b.resize(b.size() + 16 * npackets, uint8_t(r.first));
+    }
+
+    DTC_EventHeader eh;
+    memset(&eh, 0, sizeof(eh));
+    eh.inclusive_event_byte_count = b.size();
+
+    DTC_SubEventHeader sh;
+    memset(&sh, 0, sizeof(sh));
+    sh.inclusive_subevent_byte_count = b.size() - sizeof(eh);
+    sh.num_rocs                      = Blocks.size();
+    sh.source_dtc_id                 = Dtc;
+
+    memcpy(b.data(), &eh, sizeof(eh));
+    memcpy(b.data() + sizeof(eh), &sh, sizeof(sh));
+    return b;
+  }
+
+//-----------------------------------------------------------------------------
+// the blocks and the index as TrackerVST::addBuffer_ and writeIndex_ lay them
+// out. Tail: bytes of a last block which isn't a DTC event
+//-----------------------------------------------------------------------------
+  artdaq::FragmentPtr fragment(std::vector<std::vector<uint8_t>> const& Events, size_t Tail, bool WriteIndex = true) {
+    artdaq::FragmentPtr  frag = artdaq::Fragment::FragmentBytes(0, 1, 0, toFragmentType("MU2E"), mu2eFragment::Metadata());
+    mu2eFragmentWriter   w(*frag);
+    TrackerFragmentIndex index;
+
+    for (auto const& e : Events) {
+      size_t offset = w.dataEndBytes();
+      w.addSpace(e.size());
+      memcpy(w.dataAtBytes(offset), e.data(), e.size());
+      index.addEvent(w.dataAtBytes(offset), offset, e.size());
+      w.endSubEvt(e.size());
+    }
+    if (Tail > 0) {
+      w.addSpace(Tail);
+      memset(w.dataAtBytes(w.dataEndBytes()), 0xff, Tail);
+      w.endSubEvt(Tail);
+    }
+
+    frag->resizeBytes(sizeof(mu2eFragment::Header) + w.dataEndBytes());
+    if (WriteIndex) {
+      size_t offset = TrackerFragmentIndex::indexOffset(w.dataEndBytes());
+      frag->resizeBytes(sizeof(mu2eFragment::Header) + offset + index.sizeBytes());
+      index.write(w.dataAtBytes(offset));
+    }
+    return frag;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerFragmentIndex_test)
+
+BOOST_AUTO_TEST_CASE(IndexOffset) {
+  BOOST_CHECK_EQUAL(TrackerFragmentIndex::indexOffset(0), 0u);
+  BOOST_CHECK_EQUAL(TrackerFragmentIndex::indexOffset(1), 8u);
+  BOOST_CHECK_EQUAL(TrackerFragmentIndex::indexOffset(8), 8u);
+  BOOST_CHECK_EQUAL(TrackerFragmentIndex::indexOffset(13), 16u);
+}
+
+//-----------------------------------------------------------------------------
+// every block is found at its offset; a 3-byte tail leaves the end of the
+// data off the 8-byte grid
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(RoundTrip) {
+  artdaq::FragmentPtr frag = fragment({event(4, {{0, 10}, {1, 10}, {2, 10}}), event(4, {{0, 11}, {2, 11}})}, 3);
+  mu2eFragment        f(*frag);
+  BOOST_REQUIRE_NE(f.dataEndBytes() % 8, 0u);
+
+  TrackerFragmentIndexReader r(f);
+  BOOST_REQUIRE(r.valid());
+  BOOST_REQUIRE_EQUAL(r.size(), 5u);
+
+  for (size_t i = 0; i < r.size(); i++) {
+    TrackerFragmentIndex::Entry const& e = r.entry(i);
+    const uint16_t*                    w = reinterpret_cast<const uint16_t*>(r.data(e));
+    BOOST_CHECK_EQUAL(w[0], e.size);
+    BOOST_CHECK_EQUAL((w[1] >> 8) & 0x7, e.link);
+    BOOST_CHECK_EQUAL(w[3], e.ewt);
+    BOOST_CHECK_EQUAL(e.dtc, 4);
+    BOOST_CHECK_EQUAL(r.data(e)[16], e.link);     // first data byte
+  }
+
+  TrackerFragmentIndex::Entry const* e = r.find(11, 2);
+  BOOST_REQUIRE(e);
+  BOOST_CHECK_EQUAL(e->ewt, 11u);
+  BOOST_CHECK_EQUAL(e->link, 2);
+  BOOST_CHECK_EQUAL(e->size, 16 * 4);
+
+  BOOST_CHECK(r.find(11, 1) == nullptr);
+  BOOST_CHECK(r.find(9, 0) == nullptr);
+  BOOST_CHECK(r.find(12, 0) == nullptr);
+}
+
+//-----------------------------------------------------------------------------
+// a re-requested window read after later ones: the index is in tag order,
+// the blocks stay where they are
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(OutOfOrder) {
+  std::vector<std::vector<uint8_t>> events;
+  for (uint64_t t : {20, 22, 23, 21, 24}) events.push_back(event(1, {{0, t}, {1, t}}));
+  artdaq::FragmentPtr frag = fragment(events, 0);
+  mu2eFragment        f(*frag);
+
+  TrackerFragmentIndexReader r(f);
+  BOOST_REQUIRE_EQUAL(r.size(), 10u);
+  for (size_t i = 1; i < r.size(); i++) BOOST_CHECK_LE(r.entry(i - 1).ewt, r.entry(i).ewt);
+  BOOST_CHECK_EQUAL(r.entry(2).link, 0);
+  BOOST_CHECK_EQUAL(r.entry(3).link, 1);
+
+  for (uint64_t t = 20; t <= 24; t++) {
+    for (int link = 0; link < 2; link++) {
+      TrackerFragmentIndex::Entry const* e = r.find(t, link);
+      BOOST_REQUIRE(e);
+      const uint16_t* w = reinterpret_cast<const uint16_t*>(r.data(*e));
+      BOOST_CHECK_EQUAL(w[3], t);
+      BOOST_CHECK_EQUAL((w[1] >> 8) & 0x7, link);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(NoIndex) {
+  artdaq::FragmentPtr frag = fragment({event(4, {{0, 10}})}, 0, false);
+  mu2eFragment        f(*frag);
+
+  TrackerFragmentIndexReader r(f);
+  BOOST_CHECK(not r.valid());
+  BOOST_CHECK_EQUAL(r.size(), 0u);
+  BOOST_CHECK(r.find(10, 0) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
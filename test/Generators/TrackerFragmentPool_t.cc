@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerFragmentPool : the size predictor (EWMA mean and variance, n_sigma,
+// min_bytes), fragments reused through get/put, refill after the prediction
+// grows
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerFragmentPool_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerFragmentPool.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+using namespace mu2e;
+
+namespace {
+//-----------------------------------------------------------------------------
+// two fragments of at least 8 kB, a fast-moving predictor
+//-----------------------------------------------------------------------------
+  fhicl::ParameterSet poolConfig() {
+    fhicl::ParameterSet ps;
+    ps.put("depth", size_t(2));
+    ps.put("min_bytes", size_t(8192));
+    ps.put("alpha", 0.5);
+    ps.put("n_sigma", 2.);
+    return ps;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerFragmentPool_test)
+
+//-----------------------------------------------------------------------------
+// the first observation sets the mean, the variance follows the next ones;
+// the prediction is rounded up to a page
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Predictor) {
+  TrackerSizePredictor p(0, 0.5, 2.);
+
+  p.observe(10000);
+  BOOST_CHECK_EQUAL(p.predicted(), 12288u);
+
+  // mean 15000, variance 0.5*(0.5*10000^2): sigma 5000
+  p.observe(20000);
+  BOOST_CHECK_EQUAL(p.predicted(), 28672u);
+
+  // the variance decays when the size stays put
+  for (int i = 0; i < 50; i++) p.observe(15000);
+  BOOST_CHECK_EQUAL(p.predicted(), 16384u);
+}
+
+BOOST_AUTO_TEST_CASE(MinBytes) {
+  TrackerSizePredictor p(65536, 0.05, 3.);
+
+  BOOST_CHECK_EQUAL(p.predicted(), 65536u);
+  p.observe(100);
+  BOOST_CHECK_EQUAL(p.predicted(), 65536u);
+}
+
+//-----------------------------------------------------------------------------
+// a fragment given back is handed out again, without a new allocation
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Reuse) {
+  TrackerFragmentPool pool(poolConfig(), 5, toFragmentType("MU2E"));
+  pool.refill();
+  size_t nallocated = pool.nAllocated();
+
+  artdaq::FragmentPtr f = pool.get(17);
+  BOOST_REQUIRE(f);
+  BOOST_CHECK_EQUAL(f->sequenceID(), 17u);
+  BOOST_CHECK_EQUAL(f->fragmentID(), 5u);
+  BOOST_CHECK_EQUAL(f->dataSizeBytes(), 0u);
+
+  artdaq::Fragment* p = f.get();
+  f->resizeBytes(1000);
+  pool.put(std::move(f));
+
+  f = pool.get(18);
+  BOOST_CHECK(f.get() == p);
+  BOOST_CHECK_EQUAL(f->dataSizeBytes(), 0u);
+  BOOST_CHECK_EQUAL(pool.nAllocated(), nallocated);
+  BOOST_CHECK_EQUAL(pool.nEmpty(), 0u);
+
+  // the pool is empty after two: the third is allocated on the spot
+  artdaq::FragmentPtr g = pool.get(19);
+  artdaq::FragmentPtr h = pool.get(20);
+  BOOST_CHECK_EQUAL(pool.nEmpty(), 1u);
+  BOOST_CHECK_EQUAL(pool.nAllocated(), nallocated + 1);
+}
+
+//-----------------------------------------------------------------------------
+// fragments which outgrew their capacity are counted; once the prediction is
+// larger, refill replaces the smaller ones
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Refill) {
+  TrackerFragmentPool pool(poolConfig(), 5, toFragmentType("MU2E"));
+  pool.refill();
+
+  artdaq::FragmentPtr f = pool.get(1);
+  pool.observe(20000);
+  BOOST_CHECK_EQUAL(pool.nGrown(), 1u);
+  BOOST_CHECK_EQUAL(pool.predictedBytes(), 20480u);
+
+  size_t nallocated = pool.nAllocated();
+  pool.refill();
+  BOOST_CHECK_EQUAL(pool.nAllocated(), nallocated + 2);
+
+  f = pool.get(2);
+  pool.observe(20000);
+  BOOST_CHECK_EQUAL(pool.nGrown(), 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
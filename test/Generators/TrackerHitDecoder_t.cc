@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerHitDecoder : the bit-packed hit fields and ADC samples (from bit 94
+// on), pedestal and gain, short hits, masked channels, min_charge, bad hits
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerHitDecoder_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerHitDecoder.hh"
+#include "otsdaq-mu2e-tracker/Generators/TrackerCalibration.hh"
+
+#include "dtcInterfaceLib/DTC.h"
+#include "fhiclcpp/ParameterSet.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace mu2e;
+using namespace DTCLib;
+
+namespace {
+  const float kLsb = 0.0390625;
+
+//-----------------------------------------------------------------------------
+// one hit: 16 bytes plus NPackets ADC packets, the samples packed from bit 94 on
+//-----------------------------------------------------------------------------
+  struct HitData {
+    int                   channel;
+    uint32_t              tdc0;
+    uint32_t              tdc1;
+    uint16_t              flags;
+    std::vector<uint16_t> samples;
+    int                   nPackets;
+  };
+
+  void setBits(std::vector<uint8_t>& Buf, size_t Pos, int N, uint32_t Value) {
+    for (int i = 0; i < N; i++, Pos++) {
+      if ((Value >> i) & 0x1) Buf[Pos >> 3] |= (1 << (Pos & 0x7));
+    }
+  }
+
+  std::vector<uint8_t> packHit(HitData const& H) {
+    std::vector<uint8_t> b(16*(1 + H.nPackets), 0);
+    uint16_t             w[6];
+    w[0] = H.channel;
+    w[1] = H.tdc0 & 0xffff;
+    w[2] = (H.tdc0 >> 16) & 0xff;
+    w[3] = H.tdc1 & 0xffff;
+    w[4] = ((H.tdc1 >> 16) & 0xff) | (H.flags << 12);
+    w[5] = H.nPackets;
+    memcpy(b.data(), w, sizeof(w));
+    for (size_t i = 0; (i < H.samples.size()) and (94 + 10*(i+1) <= 8*b.size()); i++) {
+      setBits(b, 94 + 10*i, 10, H.samples[i]);
+    }
+    return b;
+  }
+
+//-----------------------------------------------------------------------------
+// DTC event with one subevent and one ROC block per link
+//-----------------------------------------------------------------------------
+  std::vector<uint8_t> makeEvent(uint64_t Ewt, std::vector<std::pair<int, std::vector<HitData>>> const& Rocs) {
+    std::vector<uint8_t> rocs;
+    for (auto const& roc : Rocs) {
+      std::vector<uint8_t> hits;
+      for (auto const& h : roc.second) {
+        auto b = packHit(h);
+        hits.insert(hits.end(), b.begin(), b.end());
+      }
+      uint16_t w[8] = {0};
+      w[0] = 16 + hits.size();
+      w[1] = roc.first << 8;
+      w[3] = Ewt & 0xffff;
+      w[4] = (Ewt >> 16) & 0xffff;
+      w[5] = (Ewt >> 32) & 0xffff;
+      rocs.insert(rocs.end(), reinterpret_cast<uint8_t*>(w), reinterpret_cast<uint8_t*>(w) + 16);
+      rocs.insert(rocs.end(), hits.begin(), hits.end());
+    }
+
+    std::vector<uint8_t> ev(sizeof(DTC_EventHeader) + sizeof(DTC_SubEventHeader) + rocs.size(), 0);
+    auto eh = reinterpret_cast<DTC_EventHeader*>(ev.data());
+    auto sh = reinterpret_cast<DTC_SubEventHeader*>(ev.data() + sizeof(DTC_EventHeader));
+    eh->inclusive_event_byte_count    = ev.size();
+    sh->inclusive_subevent_byte_count = sizeof(DTC_SubEventHeader) + rocs.size();
+    sh->num_rocs                      = Rocs.size();
+    memcpy(ev.data() + sizeof(DTC_EventHeader) + sizeof(DTC_SubEventHeader), rocs.data(), rocs.size());
+    return ev;
+  }
+
+//-----------------------------------------------------------------------------
+// pedestal 2 counts per sample, gain 0.5, time offset 1 ns; link 1 channel 3 masked
+//-----------------------------------------------------------------------------
+  struct Fixture {
+    fhicl::ParameterSet ps;
+
+    Fixture() {
+      ps.put("pedestal", 2.f);
+      ps.put("gain", 0.5f);
+      ps.put("time_offset", 1.f);
+
+      fhicl::ParameterSet link;
+      link.put("link", 1);
+      link.put("masked", std::vector<int>{3});
+      ps.put("links", std::vector<fhicl::ParameterSet>{link});
+    }
+
+    static std::vector<uint16_t> samples(int N) {
+      std::vector<uint16_t> s;
+      for (int i = 0; i < N; i++) s.push_back((i*347 + 5) & 0x3ff);
+      return s;
+    }
+
+    static uint32_t sum(std::vector<uint16_t> const& S, size_t N) {
+      uint32_t s = 0;
+      for (size_t i = 0; i < N; i++) s += S[i];
+      return s;
+    }
+  };
+}
+
+BOOST_FIXTURE_TEST_SUITE(TrackerHitDecoder_test, Fixture)
+
+//-----------------------------------------------------------------------------
+// 15 samples in one ADC packet: TDC fields, flags, samples across byte boundaries
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Fields) {
+  TrackerCalibration calibration(ps);
+  TrackerHitDecoder  decoder(ps, &calibration);
+
+  auto s  = samples(15);
+  auto ev = makeEvent(0x123456789aULL, {{2, {{5, 0x123456, 0xabcdef, 0x9, s, 1}}}});
+  std::vector<TrackerHitDecoder::Hit> hits;
+  BOOST_CHECK_EQUAL(decoder.decode(ev.data(), ev.size(), hits), 1u);
+  BOOST_REQUIRE_EQUAL(hits.size(), 1u);
+
+  auto const& h = hits[0];
+  BOOST_CHECK_EQUAL(h.ewt, 0x123456789aULL);
+  BOOST_CHECK_EQUAL(int(h.link), 2);
+  BOOST_CHECK_EQUAL(int(h.channel), 5);
+  BOOST_CHECK_EQUAL(h.flags, 0x9);
+  BOOST_CHECK_CLOSE(h.time[0], 0x123456*kLsb - 1, 1.e-4);
+  BOOST_CHECK_CLOSE(h.time[1], 0xabcdef*kLsb - 1, 1.e-4);
+  BOOST_CHECK_CLOSE(h.charge, (sum(s, 15) - 15*2.)*0.5, 1.e-4);
+  BOOST_CHECK_EQUAL(decoder.nDecoded(), 1u);
+}
+
+//-----------------------------------------------------------------------------
+// no ADC packet: 3 whole samples fit in bits [94,128), the pedestal is
+// subtracted for those 3 only
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ShortHit) {
+  TrackerCalibration calibration(ps);
+  TrackerHitDecoder  decoder(ps, &calibration);
+
+  auto s  = samples(15);
+  auto ev = makeEvent(7, {{0, {{1, 100, 200, 0, s, 0}}}});
+  std::vector<TrackerHitDecoder::Hit> hits;
+  BOOST_CHECK_EQUAL(decoder.decode(ev.data(), ev.size(), hits), 1u);
+  BOOST_REQUIRE_EQUAL(hits.size(), 1u);
+  BOOST_CHECK_CLOSE(hits[0].charge, (sum(s, 3) - 3*2.)*0.5, 1.e-4);
+  BOOST_CHECK_EQUAL(decoder.nBadHits(), 0u);
+
+  // the waveform has the 3 samples, the rest 0
+  std::vector<uint16_t> waveforms;
+  hits.clear();
+  decoder.decode(ev.data(), ev.size(), hits, &waveforms);
+  BOOST_REQUIRE_EQUAL(waveforms.size(), 15u);
+  for (size_t i = 0; i < 15; i++) BOOST_CHECK_EQUAL(waveforms[i], (i < 3) ? s[i] : 0);
+
+  // n_adc_samples below what the hit holds: only those are summed
+  fhicl::ParameterSet p(ps);
+  p.put("n_adc_samples", 4);
+  TrackerHitDecoder d4(p, &calibration);
+  ev = makeEvent(7, {{0, {{1, 100, 200, 0, s, 1}}}});
+  hits.clear();
+  d4.decode(ev.data(), ev.size(), hits);
+  BOOST_REQUIRE_EQUAL(hits.size(), 1u);
+  BOOST_CHECK_CLOSE(hits[0].charge, (sum(s, 4) - 4*2.)*0.5, 1.e-4);
+}
+
+//-----------------------------------------------------------------------------
+// masked channel and min_charge, hits of several links
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Selection) {
+  TrackerCalibration calibration(ps);
+
+  fhicl::ParameterSet p(ps);
+  p.put("min_charge", 10.f);
+  TrackerHitDecoder decoder(p, &calibration);
+
+  std::vector<uint16_t> low(15, 2);     // charge 0
+  auto ev = makeEvent(1, {{1, {{3, 0, 0, 0, samples(15), 1}, {4, 0, 0, 0, samples(15), 1}}},
+                          {0, {{3, 0, 0, 0, samples(15), 1}, {6, 0, 0, 0, low, 1}}}});
+  std::vector<TrackerHitDecoder::Hit> hits;
+  BOOST_CHECK_EQUAL(decoder.decode(ev.data(), ev.size(), hits), 2u);
+  BOOST_CHECK_EQUAL(decoder.nDecoded(), 4u);
+  BOOST_CHECK_EQUAL(decoder.nMasked(), 1u);
+  BOOST_CHECK_EQUAL(decoder.nBelowCharge(), 1u);
+
+  BOOST_REQUIRE_EQUAL(hits.size(), 2u);
+  BOOST_CHECK_EQUAL(int(hits[0].link), 1);
+  BOOST_CHECK_EQUAL(int(hits[0].channel), 4);
+  BOOST_CHECK_EQUAL(int(hits[1].link), 0);
+  BOOST_CHECK_EQUAL(int(hits[1].channel), 3);
+
+  // the hits are appended to what the caller passes in
+  BOOST_CHECK_EQUAL(decoder.decode(ev.data(), ev.size(), hits), 2u);
+  BOOST_CHECK_EQUAL(hits.size(), 4u);
+}
+
+//-----------------------------------------------------------------------------
+// channel out of range is skipped, a truncated hit ends the block
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(BadHits) {
+  TrackerCalibration calibration(ps);
+  TrackerHitDecoder  decoder(ps, &calibration);
+
+  auto ev = makeEvent(1, {{0, {{100, 0, 0, 0, samples(15), 1}, {2, 0, 0, 0, samples(15), 1}}}});
+  std::vector<TrackerHitDecoder::Hit> hits;
+  BOOST_CHECK_EQUAL(decoder.decode(ev.data(), ev.size(), hits), 1u);
+  BOOST_CHECK_EQUAL(decoder.nBadHits(), 1u);
+
+  // the last hit claims 2 ADC packets, the block has 1
+  auto ev2 = makeEvent(1, {{0, {{2, 0, 0, 0, samples(15), 1}}}});
+  size_t first = sizeof(DTC_EventHeader) + sizeof(DTC_SubEventHeader) + 16;
+  ev2[first + 10] = 2;
+  BOOST_CHECK_EQUAL(decoder.decode(ev2.data(), ev2.size(), hits), 0u);
+  BOOST_CHECK_EQUAL(decoder.nBadHits(), 2u);
+
+  // too short for an event header
+  BOOST_CHECK_EQUAL(decoder.decode(ev.data(), 8, hits), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
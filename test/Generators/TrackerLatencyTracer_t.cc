@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerLatencyTracer : records from several threads, the CSV dump sorted by
+// time, ring overwrite, one ring per thread and per tracer
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerLatencyTracer_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerLatencyTracer.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace mu2e;
+
+namespace {
+//-----------------------------------------------------------------------------
+// one CSV line: ewt,stage,thread,t_ns
+//-----------------------------------------------------------------------------
+  struct Line {
+    uint64_t ewt;
+    uint32_t stage;
+    uint32_t thread;
+    int64_t  time;
+  };
+
+  std::string csvFile() { return "/tmp/TrackerLatencyTracer_t_" + std::to_string(::getpid()) + ".csv"; }
+
+  fhicl::ParameterSet tracerConfig(size_t RingSize) {
+    fhicl::ParameterSet ps;
+    ps.put("ring_size", RingSize);
+    ps.put("output_file", csvFile());
+    return ps;
+  }
+
+  std::vector<Line> readCsv(std::string const& File) {
+    std::vector<Line> lines;
+    std::ifstream     in(File);
+    std::string       s;
+    std::getline(in, s);
+    BOOST_CHECK_EQUAL(s, "ewt,stage,thread,t_ns");
+    while (std::getline(in, s)) {
+      Line              l;
+      char              c;
+      std::stringstream ss(s);
+      ss >> l.ewt >> c >> l.stage >> c >> l.thread >> c >> l.time;
+      BOOST_REQUIRE(ss);
+      lines.push_back(l);
+    }
+    std::remove(File.c_str());
+    return lines;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerLatencyTracer_test)
+
+//-----------------------------------------------------------------------------
+// each thread writes its own ring, the dump merges them in time order
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Threads) {
+  TrackerLatencyTracer tracer(tracerConfig(1024), 0);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&tracer, i] {
+      for (uint64_t t = 0; t < 100; t++) tracer.record(TrackerLatencyTracer::Stage_t(i), 1000*i + t);
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  BOOST_CHECK_EQUAL(tracer.dump(), 400u);
+
+  auto lines = readCsv(csvFile());
+  BOOST_REQUIRE_EQUAL(lines.size(), 400u);
+
+  std::set<uint32_t> ids;
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (i > 0) BOOST_CHECK_LE(lines[i-1].time, lines[i].time);
+    // all the records of a thread have its stage and tag range
+    BOOST_CHECK_EQUAL(lines[i].ewt/1000, lines[i].stage);
+    ids.insert(lines[i].thread);
+  }
+  BOOST_CHECK_EQUAL(ids.size(), 4u);
+}
+
+//-----------------------------------------------------------------------------
+// ring_size is rounded up to a power of 2, the oldest records are overwritten
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Overwrite) {
+  TrackerLatencyTracer tracer(tracerConfig(5), 0);
+
+  for (uint64_t t = 0; t < 20; t++) tracer.record(TrackerLatencyTracer::kDma, t);
+  BOOST_CHECK_EQUAL(tracer.dump(), 8u);
+
+  auto lines = readCsv(csvFile());
+  BOOST_REQUIRE_EQUAL(lines.size(), 8u);
+  for (size_t i = 0; i < lines.size(); i++) {
+    BOOST_CHECK_EQUAL(lines[i].ewt, 12 + i);
+    BOOST_CHECK_EQUAL(lines[i].stage, uint32_t(TrackerLatencyTracer::kDma));
+  }
+}
+
+//-----------------------------------------------------------------------------
+// a thread recording into two tracers, or into a tracer created after another
+// one was destroyed, gets a ring of each
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Tracers) {
+  auto a = std::make_unique<TrackerLatencyTracer>(tracerConfig(16), 0);
+  TrackerLatencyTracer b(tracerConfig(16), 1);
+
+  a->record(TrackerLatencyTracer::kRequest, 1);
+  b.record(TrackerLatencyTracer::kRequest, 2);
+  b.record(TrackerLatencyTracer::kEmit, 2);
+  a->record(TrackerLatencyTracer::kEmit, 1);
+
+  BOOST_CHECK_EQUAL(b.dump(), 2u);
+  auto lines = readCsv(csvFile());
+  BOOST_REQUIRE_EQUAL(lines.size(), 2u);
+  BOOST_CHECK_EQUAL(lines[0].ewt, 2u);
+  BOOST_CHECK_EQUAL(lines[1].stage, uint32_t(TrackerLatencyTracer::kEmit));
+
+  a.reset();
+  TrackerLatencyTracer c(tracerConfig(16), 2);
+  c.record(TrackerLatencyTracer::kBuild, 3);
+  BOOST_CHECK_EQUAL(c.dump(), 1u);
+  BOOST_CHECK_EQUAL(readCsv(csvFile()).size(), 1u);
+}
+
+//-----------------------------------------------------------------------------
+// nothing recorded: the header only; an unwritable file: nothing
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Empty) {
+  TrackerLatencyTracer tracer(tracerConfig(16), 0);
+  BOOST_CHECK_EQUAL(tracer.dump(), 0u);
+  BOOST_CHECK(readCsv(csvFile()).empty());
+
+  tracer.record(TrackerLatencyTracer::kDma, 1);
+  BOOST_CHECK_EQUAL(tracer.dump("/nonexistent/dir/latency.csv"), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,244 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerLinkMerger : window and link ordering, the header of a missing link,
+// late blocks, timeout
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerLinkMerger_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerLinkMerger.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <cstring>
+
+using namespace mu2e;
+using namespace DTCLib;
+
+namespace {
+  typedef std::chrono::steady_clock::time_point time_point_t;
+
+  struct Roc {
+    int      dtc;
+    int      link;
+    uint64_t ewt;
+    bool     valid;
+    int      nPackets;
+    uint8_t  fill;                      // first data byte, the link number
+  };
+
+//-----------------------------------------------------------------------------
+// one DTC event with the (link, ewt) ROC blocks, NPackets data packets each
+//-----------------------------------------------------------------------------
+  std::vector<uint8_t> event(int Dtc, std::vector<std::pair<int, uint64_t>> const& Blocks, int NPackets = 1) {
+    std::vector<uint8_t> b(sizeof(DTC_EventHeader) + sizeof(DTC_SubEventHeader));
+    for (auto const& r : Blocks) {
+      uint16_t w[8] = {uint16_t(16 * (NPackets + 1)), uint16_t(0x8000 | (r.first << 8) | 0x50), uint16_t(NPackets),
+                       uint16_t(r.second), uint16_t(r.second >> 16), uint16_t(r.second >> 32), 0, 0};
+      const uint8_t* p = reinterpret_cast<const uint8_t*>(w);
+      b.insert(b.end(), p, p + sizeof(w));
+      b.resize(b.size() + 16 * NPackets, uint8_t(r.first));
+    }
+
+    DTC_EventHeader eh;
+    memset(&eh, 0, sizeof(eh));
+    eh.inclusive_event_byte_count = b.size();
+    eh.event_tag_low              = Blocks.empty() ? 0 : Blocks[0].second;
+
+    DTC_SubEventHeader sh;
+    memset(&sh, 0, sizeof(sh));
+    sh.inclusive_subevent_byte_count = b.size() - sizeof(eh);
+    sh.num_rocs                      = Blocks.size();
+    sh.source_dtc_id                 = Dtc;
+
+    memcpy(b.data(), &eh, sizeof(eh));
+    memcpy(b.data() + sizeof(eh), &sh, sizeof(sh));
+    return b;
+  }
+
+//-----------------------------------------------------------------------------
+// the ROC blocks of a merged buffer, checking the byte counts on the way
+//-----------------------------------------------------------------------------
+  std::vector<Roc> rocs(std::vector<uint8_t> const& Buffer) {
+    std::vector<Roc> r;
+
+    uint64_t nbytes;
+    memcpy(&nbytes, Buffer.data(), sizeof(nbytes));
+    BOOST_REQUIRE_EQUAL(nbytes + 8, Buffer.size());
+
+    auto eh = reinterpret_cast<const DTC_EventHeader*>(Buffer.data() + 8);
+    BOOST_REQUIRE_EQUAL(eh->inclusive_event_byte_count, nbytes);
+
+    size_t pos = 8 + sizeof(DTC_EventHeader);
+    while (pos < Buffer.size()) {
+      auto   sh  = reinterpret_cast<const DTC_SubEventHeader*>(Buffer.data() + pos);
+      size_t end = pos + sh->inclusive_subevent_byte_count;
+      BOOST_REQUIRE_LE(end, Buffer.size());
+
+      size_t roc = pos + sizeof(DTC_SubEventHeader);
+      for (int i = 0; i < sh->num_rocs; i++) {
+        const uint16_t* w = reinterpret_cast<const uint16_t*>(Buffer.data() + roc);
+        r.push_back(Roc{int(sh->source_dtc_id), (w[1] >> 8) & 0x7,
+                        uint64_t(w[3]) | (uint64_t(w[4]) << 16) | (uint64_t(w[5]) << 32), (w[1] & 0x8000) != 0,
+                        w[2], (w[0] > 16) ? Buffer[roc + 16] : uint8_t(0xff)});
+        roc += w[0];
+      }
+      BOOST_REQUIRE_EQUAL(roc, end);
+      pos = end;
+    }
+    return r;
+  }
+
+  struct Fixture {
+    fhicl::ParameterSet  ps;
+    time_point_t         t0;
+    std::vector<uint8_t> out;
+
+    Fixture() : t0(std::chrono::steady_clock::now()) {
+      ps.put("links", std::vector<int>{0, 1, 2});
+      ps.put("timeout_ms", 50);
+    }
+
+    time_point_t at(int Ms) const { return t0 + std::chrono::milliseconds(Ms); }
+
+    void add(TrackerLinkMerger& M, std::vector<uint8_t> const& Event, int Ms = 0) {
+      M.add(Event.data(), Event.size(), at(Ms));
+    }
+  };
+}
+
+BOOST_FIXTURE_TEST_SUITE(TrackerLinkMerger_test, Fixture)
+
+//-----------------------------------------------------------------------------
+// links out of step: the blocks of a window come in different events
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Ordering) {
+  TrackerLinkMerger m(ps);
+
+  add(m, event(3, {{2, 1}, {0, 1}}));
+  add(m, event(3, {{0, 2}, {2, 2}}));
+  BOOST_CHECK(not m.next(out, false, at(1)));  // link 1 hasn't sent window 1 yet
+
+  add(m, event(3, {{1, 1}, {1, 2}}));
+  BOOST_CHECK_EQUAL(m.nPending(), 2u);
+
+  for (uint64_t tag = 1; tag <= 2; tag++) {
+    BOOST_REQUIRE(m.next(out, false, at(1)));
+    BOOST_CHECK_EQUAL(m.lastTag(), tag);
+    BOOST_CHECK_EQUAL(m.lastMissing(), 0);
+
+    std::vector<Roc> r = rocs(out);
+    BOOST_REQUIRE_EQUAL(r.size(), 3u);
+    for (int link = 0; link < 3; link++) {
+      BOOST_CHECK_EQUAL(r[link].link, link);
+      BOOST_CHECK_EQUAL(r[link].ewt, tag);
+      BOOST_CHECK(r[link].valid);
+      BOOST_CHECK_EQUAL(r[link].fill, link);
+    }
+  }
+  BOOST_CHECK(not m.next(out, true, at(1)));
+  BOOST_CHECK_EQUAL(m.nMerged(), 2u);
+  BOOST_CHECK_EQUAL(m.queuedBytes(), 0u);
+}
+
+//-----------------------------------------------------------------------------
+// a later block on every stream: the window goes out, the missing link gets
+// an empty ROC header with the valid bit clear
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(MissingLink) {
+  TrackerLinkMerger m(ps);
+
+  add(m, event(3, {{0, 3}, {2, 3}}));
+  add(m, event(3, {{1, 4}, {0, 4}, {2, 4}}));
+
+  BOOST_REQUIRE(m.next(out, false, at(1)));
+  BOOST_CHECK_EQUAL(m.lastTag(), 3u);
+  BOOST_CHECK_EQUAL(m.lastMissing(), 1);
+
+  std::vector<Roc> r = rocs(out);
+  BOOST_REQUIRE_EQUAL(r.size(), 3u);
+  BOOST_CHECK(r[0].valid);
+  BOOST_CHECK_EQUAL(r[1].link, 1);
+  BOOST_CHECK_EQUAL(r[1].ewt, 3u);
+  BOOST_CHECK(not r[1].valid);
+  BOOST_CHECK_EQUAL(r[1].nPackets, 0);
+  BOOST_CHECK(r[2].valid);
+
+  BOOST_REQUIRE(m.next(out, false, at(1)));
+  BOOST_CHECK_EQUAL(m.lastTag(), 4u);
+  BOOST_CHECK_EQUAL(m.lastMissing(), 0);
+
+  BOOST_CHECK_EQUAL(m.nIncomplete(), 1u);
+  BOOST_CHECK_EQUAL(m.nMissingBlocks(), 1u);
+}
+
+//-----------------------------------------------------------------------------
+// blocks for a window already sent, and second blocks for a queued one
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(LateBlocks) {
+  TrackerLinkMerger m(ps);
+
+  add(m, event(3, {{0, 5}, {2, 5}, {0, 6}, {1, 6}, {2, 6}}));
+  BOOST_REQUIRE(m.next(out, false, at(1)));
+  BOOST_CHECK_EQUAL(m.lastTag(), 5u);
+
+  std::vector<uint8_t> late = event(3, {{1, 5}});
+  BOOST_CHECK_EQUAL(m.add(late.data(), late.size(), at(2)), 0u);
+  BOOST_CHECK_EQUAL(m.nLateBlocks(), 1u);
+
+  add(m, event(3, {{2, 6}}), 2);
+  BOOST_CHECK_EQUAL(m.nLateBlocks(), 2u);
+
+  BOOST_REQUIRE(m.next(out, false, at(2)));
+  BOOST_CHECK_EQUAL(m.lastTag(), 6u);
+  BOOST_CHECK_EQUAL(rocs(out).size(), 3u);
+  BOOST_CHECK(not m.next(out, true, at(2)));
+}
+
+BOOST_AUTO_TEST_CASE(Timeout) {
+  TrackerLinkMerger m(ps);
+
+  add(m, event(3, {{0, 7}}), 0);
+  BOOST_CHECK(not m.next(out, false, at(49)));
+  BOOST_REQUIRE(m.next(out, false, at(50)));
+  BOOST_CHECK_EQUAL(m.lastTag(), 7u);
+  BOOST_CHECK_EQUAL(m.lastMissing(), 2);
+
+  add(m, event(3, {{0, 8}}), 60);
+  BOOST_REQUIRE(m.next(out, true, at(60)));
+  BOOST_CHECK_EQUAL(m.lastTag(), 8u);
+}
+
+BOOST_AUTO_TEST_CASE(MaxPending) {
+  ps.put_or_replace("max_pending", size_t(2));
+  TrackerLinkMerger m(ps);
+
+  add(m, event(3, {{0, 1}, {0, 2}}));
+  BOOST_CHECK(not m.next(out, false, at(1)));
+  add(m, event(3, {{0, 3}}));
+  BOOST_REQUIRE(m.next(out, false, at(1)));
+  BOOST_CHECK_EQUAL(m.lastTag(), 1u);
+  BOOST_CHECK(not m.next(out, false, at(1)));
+}
+
+//-----------------------------------------------------------------------------
+// one sub-event per DTC, in DTC order, each with all its expected links
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(TwoDtcs) {
+  TrackerLinkMerger m(ps);
+
+  add(m, event(5, {{0, 1}, {1, 1}, {2, 1}}));
+  add(m, event(4, {{2, 1}, {0, 1}}));
+  BOOST_CHECK(not m.next(out, false, at(1)));
+  add(m, event(4, {{1, 1}}));
+
+  BOOST_REQUIRE(m.next(out, false, at(1)));
+  std::vector<Roc> r = rocs(out);
+  BOOST_REQUIRE_EQUAL(r.size(), 6u);
+  for (int i = 0; i < 6; i++) {
+    BOOST_CHECK_EQUAL(r[i].dtc, 4 + i / 3);
+    BOOST_CHECK_EQUAL(r[i].link, i % 3);
+    BOOST_CHECK(r[i].valid);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
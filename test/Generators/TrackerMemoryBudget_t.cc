@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerMemoryBudget : per-stage and total usage, high-water marks, the
+// hysteresis between the high and the low mark, no limit
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerMemoryBudget_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerMemoryBudget.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <string>
+
+using namespace mu2e;
+
+namespace {
+  typedef TrackerMemoryBudget B;
+
+//-----------------------------------------------------------------------------
+// 1000 bytes: full above 900, not full again down to 700
+//-----------------------------------------------------------------------------
+  fhicl::ParameterSet budgetConfig(size_t Limit) {
+    fhicl::ParameterSet ps;
+    ps.put("limit_bytes", Limit);
+    return ps;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerMemoryBudget_test)
+
+//-----------------------------------------------------------------------------
+// reserve/release add up per stage, set replaces the total of a stage
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Usage) {
+  B b(budgetConfig(1000));
+
+  b.reserve(B::kDmaBuffers, 100);
+  b.reserve(B::kDmaBuffers, 200);
+  b.set    (B::kEventCache, 250);
+  BOOST_CHECK_EQUAL(b.used(B::kDmaBuffers), 300u);
+  BOOST_CHECK_EQUAL(b.used(), 550u);
+
+  b.set    (B::kEventCache, 50);
+  b.release(B::kDmaBuffers, 100);
+  BOOST_CHECK_EQUAL(b.used(), 250u);
+  BOOST_CHECK_EQUAL(b.highWater(B::kDmaBuffers), 300u);
+  BOOST_CHECK_EQUAL(b.highWater(B::kEventCache), 250u);
+  BOOST_CHECK_EQUAL(b.highWater(), 550u);
+
+  // more released than reserved: the stage goes down to 0, not below
+  b.release(B::kDmaBuffers, 1000);
+  BOOST_CHECK_EQUAL(b.used(B::kDmaBuffers), 0u);
+  BOOST_CHECK_EQUAL(b.used(), 50u);
+  BOOST_CHECK(not b.full());
+}
+
+//-----------------------------------------------------------------------------
+// full above the high mark, stays full between the marks
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Hysteresis) {
+  B b(budgetConfig(1000));
+
+  b.set(B::kFragments, 900);
+  BOOST_CHECK(not b.full());
+  b.reserve(B::kDmaBuffers, 1);
+  BOOST_CHECK(b.full());
+  BOOST_CHECK_EQUAL(b.nFull(), 1u);
+
+  b.set(B::kFragments, 750);
+  BOOST_CHECK(b.full());
+  b.set(B::kFragments, 699);
+  BOOST_CHECK(not b.full());
+
+  b.set(B::kLinkMerger, 500);
+  BOOST_CHECK(b.full());
+  BOOST_CHECK_EQUAL(b.nFull(), 2u);
+
+  b.requestDeferred();
+  BOOST_CHECK_EQUAL(b.nDeferred(), 1u);
+}
+
+//-----------------------------------------------------------------------------
+// limit_bytes=0: never full, the usage is still recorded
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(NoLimit) {
+  fhicl::ParameterSet none;
+  B                   b(none);
+
+  b.reserve(B::kDmaBuffers, size_t(1) << 40);
+  BOOST_CHECK(not b.full());
+  BOOST_CHECK_EQUAL(b.limitBytes(), 0u);
+  BOOST_CHECK_EQUAL(b.highWater(), size_t(1) << 40);
+  BOOST_CHECK_EQUAL(std::string(B::stageName(B::kEventCache)), "Event Cache");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerRateController : the request latency and occupancy measurements,
+// back-off on overload, speed-up otherwise
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerRateController_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerRateController.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <thread>
+
+using mu2e::TrackerRateController;
+
+namespace {
+//-----------------------------------------------------------------------------
+// one update per 4 reads, the downstream and FIFO inputs quiet
+//-----------------------------------------------------------------------------
+  fhicl::ParameterSet config() {
+    fhicl::ParameterSet ps;
+    ps.put("enabled", true);
+    ps.put("initial_delay_us", 100.);
+    ps.put("increase_step_us", 10.);
+    ps.put("initial_requests_ahead", 2);
+    ps.put("max_requests_ahead", 3);
+    ps.put("max_latency_us", 1000.);
+    ps.put("update_interval", size_t(4));
+    return ps;
+  }
+
+  void read(TrackerRateController& R, int N, size_t Sts = 1000, bool Timeout = false) {
+    for (int i = 0; i < N; i++) R.readDone(Sts, Timeout);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerRateController_test)
+
+//-----------------------------------------------------------------------------
+// reads answered right away, at most 2 of 4 requests in flight: faster
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(SpeedUp) {
+  TrackerRateController r(config());
+
+  for (int i = 0; i < 4; i++) {
+    r.requestSent();
+    if (i % 2 == 1) read(r, 2);
+  }
+  BOOST_CHECK_EQUAL(r.inFlight(), 0u);
+  BOOST_CHECK_LT(r.meanLatencyUs(), 1000.);
+  BOOST_CHECK_EQUAL(r.timeoutFraction(), 0.);
+  BOOST_CHECK_EQUAL(r.delayUs(), 90u);
+  BOOST_CHECK_EQUAL(r.requestsAhead(), 3);
+}
+
+//-----------------------------------------------------------------------------
+// the latency is measured from the send time of the oldest request
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Latency) {
+  TrackerRateController r(config());
+
+  r.requestSent(2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(3));
+  r.requestSent(2);
+  read(r, 4);
+
+  BOOST_CHECK_GT(r.meanLatencyUs(), 1500.);
+  BOOST_CHECK_EQUAL(r.delayUs(), 200u);
+  BOOST_CHECK_EQUAL(r.requestsAhead(), 1);
+}
+
+//-----------------------------------------------------------------------------
+// 4 requests in flight with max_requests_ahead=3 is more than max_occupancy
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Occupancy) {
+  TrackerRateController r(config());
+
+  r.requestSent(4);
+  BOOST_CHECK_EQUAL(r.inFlight(), 4u);
+  read(r, 4);
+  BOOST_CHECK_EQUAL(r.delayUs(), 200u);
+  BOOST_CHECK_EQUAL(r.requestsAhead(), 1);
+
+  // 3 of 4 is below it
+  r.requestSent(3);
+  read(r, 3);
+  r.requestSent();
+  read(r, 1);
+  BOOST_CHECK_EQUAL(r.delayUs(), 190u);
+  BOOST_CHECK_EQUAL(r.requestsAhead(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(Timeouts) {
+  TrackerRateController r(config());
+
+  r.requestSent(4);
+  read(r, 3);
+  read(r, 1, 0);
+  BOOST_CHECK_EQUAL(r.timeoutFraction(), 0.25);
+  BOOST_CHECK_EQUAL(r.delayUs(), 200u);
+}
+
+//-----------------------------------------------------------------------------
+// disabled: measured, the knobs don't move
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Disabled) {
+  fhicl::ParameterSet ps = config();
+  ps.put_or_replace("enabled", false);
+  TrackerRateController r(ps);
+
+  r.requestSent(4);
+  read(r, 4, 0);
+  BOOST_CHECK_EQUAL(r.timeoutFraction(), 1.);
+  BOOST_CHECK_EQUAL(r.delayUs(), 100u);
+  BOOST_CHECK_EQUAL(r.requestsAhead(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
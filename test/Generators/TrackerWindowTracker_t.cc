@@ -0,0 +1,207 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerWindowTracker : missing windows, retries and their budget, loss
+// counting, the link reset escalation, the cap on outstanding requests
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerWindowTracker_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Generators/TrackerWindowTracker.hh"
+
+#include "fhiclcpp/ParameterSet.h"
+
+#include <deque>
+#include <set>
+
+using mu2e::TrackerWindowTracker;
+
+namespace {
+//-----------------------------------------------------------------------------
+// a DTC answering the requests in order: the windows in Drop time out once,
+// the ones in Dead every time. The retries go to the back of the queue
+//-----------------------------------------------------------------------------
+  void run(TrackerWindowTracker& W, uint64_t First, uint64_t Last, std::set<uint64_t> Drop,
+           std::set<uint64_t> const& Dead) {
+    std::deque<uint64_t> wire;
+    for (uint64_t t = First; t <= Last; t++) {
+      W.requested(t);
+      wire.push_back(t);
+    }
+
+    std::vector<uint64_t> retry;
+    while (not wire.empty()) {
+      uint64_t t = wire.front();
+      wire.pop_front();
+      if (Dead.count(t) or Drop.erase(t)) W.timedOut();
+      else                                W.received(t);
+
+      retry.clear();
+      W.retries(retry);
+      for (uint64_t r : retry) {
+        W.requested(r);
+        wire.push_back(r);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerWindowTracker_test)
+
+BOOST_AUTO_TEST_CASE(Recovery) {
+  fhicl::ParameterSet  ps;
+  TrackerWindowTracker w(ps);
+  w.reset(1);
+
+  run(w, 1, 20, {5, 9}, {13});
+
+  // 5 and 9 come back on the first retry, 13 is lost after two
+  BOOST_CHECK_EQUAL(w.next(), 21u);
+  BOOST_CHECK_EQUAL(w.nOutstanding(), 0u);
+  BOOST_CHECK_EQUAL(w.nReceived(), 19u);
+  BOOST_CHECK_EQUAL(w.nMissing(), 5u);
+  BOOST_CHECK_EQUAL(w.nRetried(), 4u);
+  BOOST_CHECK_EQUAL(w.nRecovered(), 2u);
+  BOOST_CHECK_EQUAL(w.nLost(), 1u);
+  BOOST_CHECK_EQUAL(w.nUnexpected(), 0u);
+  BOOST_CHECK(not w.resetNeeded());
+}
+
+//-----------------------------------------------------------------------------
+// the DTC answers in order: a later window makes the ones in front missing
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Skipped) {
+  fhicl::ParameterSet ps;
+  ps.put("max_retries", 1);
+  TrackerWindowTracker w(ps);
+  w.reset(100);
+
+  for (uint64_t t = 100; t < 105; t++) w.requested(t);
+  w.received(103);
+  BOOST_CHECK_EQUAL(w.nMissing(), 3u);
+  BOOST_CHECK_EQUAL(w.next(), 100u);
+
+  std::vector<uint64_t> retry;
+  BOOST_CHECK_EQUAL(w.retries(retry), 3u);
+  BOOST_CHECK((retry == std::vector<uint64_t>{100, 101, 102}));
+
+  // 101 makes it late, without its re-request
+  w.received(101);
+  BOOST_CHECK_EQUAL(w.nRecovered(), 1u);
+  BOOST_CHECK_EQUAL(w.next(), 100u);
+
+  // 101 is done, its re-request is ignored. 100 times out again: lost
+  for (uint64_t t : retry) w.requested(t);
+  w.received(104);
+  w.timedOut();
+  w.received(102);
+  BOOST_CHECK_EQUAL(w.nLost(), 1u);
+  BOOST_CHECK_EQUAL(w.nRecovered(), 2u);
+  BOOST_CHECK_EQUAL(w.next(), 105u);
+
+  // a duplicate, and a window never requested
+  w.received(102);
+  w.received(200);
+  BOOST_CHECK_EQUAL(w.nUnexpected(), 2u);
+}
+
+//-----------------------------------------------------------------------------
+// no refill: only the burst goes out, the rest waits
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(RetryBudget) {
+  fhicl::ParameterSet ps;
+  ps.put("retries_per_s", 0.);
+  ps.put("retry_burst", 2.);
+  TrackerWindowTracker w(ps);
+  w.reset(0);
+
+  for (uint64_t t = 0; t < 5; t++) w.requested(t);
+  for (int i = 0; i < 5; i++) w.timedOut();
+  BOOST_CHECK_EQUAL(w.nMissing(), 5u);
+
+  std::vector<uint64_t> retry;
+  BOOST_CHECK_EQUAL(w.retries(retry), 2u);
+  BOOST_CHECK_EQUAL(w.retries(retry), 0u);
+  BOOST_CHECK_EQUAL(w.nRetried(), 2u);
+
+  // a fresh budget after a reset
+  w.reset(0);
+  for (uint64_t t = 0; t < 5; t++) w.requested(t);
+  for (int i = 0; i < 5; i++) w.timedOut();
+  retry.clear();
+  BOOST_CHECK_EQUAL(w.retries(retry), 2u);
+}
+
+//-----------------------------------------------------------------------------
+// reset_after_lost windows lost in a row ask for one link reset; a window
+// received in between starts the count over
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Escalation) {
+  fhicl::ParameterSet ps;
+  ps.put("max_retries", 0);
+  ps.put("reset_after_lost", 3);
+  TrackerWindowTracker w(ps);
+  w.reset(0);
+
+  for (uint64_t t = 0; t < 10; t++) w.requested(t);
+  w.timedOut();
+  w.timedOut();
+  w.received(2);
+  w.timedOut();
+  w.timedOut();
+  BOOST_CHECK(not w.resetNeeded());
+  w.timedOut();
+  BOOST_CHECK_EQUAL(w.nLost(), 5u);
+  BOOST_CHECK(w.resetNeeded());
+  BOOST_CHECK(not w.resetNeeded());
+
+  std::vector<uint64_t> retry;
+  BOOST_CHECK_EQUAL(w.retries(retry), 0u);
+  BOOST_CHECK_EQUAL(w.next(), 6u);
+}
+
+//-----------------------------------------------------------------------------
+// a request far ahead pushes the unresolved windows out as lost
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(JumpAhead) {
+  fhicl::ParameterSet  ps;
+  TrackerWindowTracker w(ps);
+  w.reset(0);
+
+  for (uint64_t t = 0; t < 4; t++) w.requested(t);
+  w.received(0);
+
+  uint64_t far = 10 * TrackerWindowTracker::kSize;
+  w.requested(far);
+  w.received(far);
+  BOOST_CHECK_EQUAL(w.nLost(), 3u);
+  BOOST_CHECK_EQUAL(w.next(), far + 1);
+  BOOST_CHECK_EQUAL(w.nUnexpected(), 0u);
+}
+
+//-----------------------------------------------------------------------------
+// the same windows requested over and over: the queue stops at kSize, the
+// oldest request is dropped, the done ones are retired with the next answer
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Cap) {
+  fhicl::ParameterSet  ps;
+  TrackerWindowTracker w(ps);
+  w.reset(0);
+
+  for (int i = 0; i < TrackerWindowTracker::kSize; i++) w.requested(i % 2);
+  BOOST_CHECK_EQUAL(w.nOutstanding(), size_t(TrackerWindowTracker::kSize));
+  BOOST_CHECK_EQUAL(w.nDropped(), 0u);
+
+  // 0 was requested more than max_retries times: lost once dropped
+  w.requested(2);
+  BOOST_CHECK_EQUAL(w.nOutstanding(), size_t(TrackerWindowTracker::kSize));
+  BOOST_CHECK_EQUAL(w.nDropped(), 1u);
+  BOOST_CHECK_EQUAL(w.nLost(), 1u);
+
+  w.received(1);
+  BOOST_CHECK_EQUAL(w.nOutstanding(), 1u);
+  w.received(2);
+  BOOST_CHECK_EQUAL(w.nOutstanding(), 0u);
+  BOOST_CHECK_EQUAL(w.next(), 3u);
+  BOOST_CHECK_EQUAL(w.nUnexpected(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
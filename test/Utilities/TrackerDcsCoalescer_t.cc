@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerDcsCoalescer : coalescing and batching of the reads, the order of
+// the writes, dropped requests
+//
+// the first read of a test holds the coalescer thread until the requests of
+// the test are queued, so what gets merged doesn't depend on the timing
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerDcsCoalescer_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Utilities/TrackerDcsCoalescer.hh"
+
+#include <mutex>
+#include <string>
+
+using mu2e::TrackerDcsCoalescer;
+
+namespace {
+  const uint16_t kGate = 99;           // reading it holds the thread
+
+//-----------------------------------------------------------------------------
+// the registers of one ROC, with the log of the DCS transactions
+//-----------------------------------------------------------------------------
+  struct Roc {
+    uint16_t                 reg[256];
+    std::vector<std::string> log;
+    std::mutex               mutex;
+    std::promise<void>       entered;
+    std::promise<void>       gate;
+
+    Roc() {
+      for (int i = 0; i < 256; i++) reg[i] = 1000 + i;
+    }
+
+    void record(std::string const& What) {
+      std::lock_guard<std::mutex> lock(mutex);
+      log.push_back(What);
+    }
+
+    void add(TrackerDcsCoalescer& C, int Link) {
+      std::shared_future<void> open = gate.get_future().share();
+      C.addLink(
+        Link,
+        [this, open](uint16_t A) {
+          if (A == kGate) {
+            entered.set_value();
+            open.wait();
+          }
+          record("r" + std::to_string(A));
+          return reg[A];
+        },
+        [this](std::vector<uint16_t>& D, uint16_t A, uint16_t N, bool Increment) {
+          record("b" + std::to_string(A) + "x" + std::to_string(N));
+          for (int i = 0; i < N; i++) D.push_back(reg[Increment ? A + i : A]);
+        },
+        [this](uint16_t A, uint16_t V) {
+          record("w" + std::to_string(A));
+          reg[A] = V;
+        });
+    }
+  };
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerDcsCoalescer_test)
+
+BOOST_AUTO_TEST_CASE(Shared) {
+  int  key = 0;
+  auto a = TrackerDcsCoalescer::get(&key);
+  auto b = TrackerDcsCoalescer::get(&key);
+  auto c = TrackerDcsCoalescer::get(&a);
+  BOOST_CHECK(a == b);
+  BOOST_CHECK(a != c);
+}
+
+BOOST_AUTO_TEST_CASE(Coalescing) {
+  TrackerDcsCoalescer c;
+  Roc                 roc;
+  roc.add(c, 0);
+  c.setNoCoalesce(42);
+
+  auto held = c.read(0, kGate);
+  roc.entered.get_future().wait();
+
+  std::vector<std::future<uint16_t>> f;
+  std::vector<uint16_t>              address = {8, 6, 10, 7, 9, 6, 42, 43, 42};
+  for (uint16_t a : address) f.push_back(c.read(0, a));
+
+  roc.gate.set_value();
+  BOOST_CHECK_EQUAL(held.get(), 1000 + kGate);
+  for (size_t i = 0; i < f.size(); i++) BOOST_CHECK_EQUAL(f[i].get(), 1000 + address[i]);
+
+  // 6-10 in one block read, the second 6 answered by the first one, 42 (a
+  // FIFO) read each time on its own, which leaves 43 alone too
+  std::vector<std::string> expected = {"r99", "b6x5", "r42", "r42", "r43"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(roc.log.begin(), roc.log.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL(c.nRequests(), 10u);
+  BOOST_CHECK_EQUAL(c.nCoalesced(), 1u);
+  BOOST_CHECK_EQUAL(c.nBatched(), 5u);
+  BOOST_CHECK_EQUAL(c.nTransactions(), 5u);
+}
+
+BOOST_AUTO_TEST_CASE(MaxBlock) {
+  TrackerDcsCoalescer c;
+  Roc                 roc;
+  roc.add(c, 0);
+  c.setMaxBlock(2);
+
+  auto held = c.read(0, kGate);
+  roc.entered.get_future().wait();
+
+  std::vector<std::future<uint16_t>> f;
+  for (uint16_t a = 6; a <= 10; a++) f.push_back(c.read(0, a));
+  roc.gate.set_value();
+  for (auto& x : f) x.get();
+
+  std::vector<std::string> expected = {"r99", "b6x2", "b8x2", "r10"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(roc.log.begin(), roc.log.end(), expected.begin(), expected.end());
+}
+
+//-----------------------------------------------------------------------------
+// a read queued after a write sees the value written, one queued before it
+// the old value: the reads are not moved across the write
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(WriteOrder) {
+  TrackerDcsCoalescer c;
+  Roc                 roc;
+  roc.add(c, 0);
+
+  auto held = c.read(0, kGate);
+  roc.entered.get_future().wait();
+
+  auto before = c.read(0, 8);
+  auto w      = c.write(0, 8, 500);
+  auto after1 = c.read(0, 8);
+  auto after2 = c.read(0, 8);
+  auto block  = c.readBlock(0, 7, 3, true);
+  auto last   = c.read(0, 8);
+
+  roc.gate.set_value();
+  BOOST_CHECK_EQUAL(before.get(), 1008);
+  w.get();
+  BOOST_CHECK_EQUAL(after1.get(), 500);
+  BOOST_CHECK_EQUAL(after2.get(), 500);
+  std::vector<uint16_t> b = block.get();
+  BOOST_REQUIRE_EQUAL(b.size(), 3u);
+  BOOST_CHECK_EQUAL(b[1], 500);
+  BOOST_CHECK_EQUAL(last.get(), 500);
+
+  // the read after the block read isn't merged with the ones before it
+  std::vector<std::string> expected = {"r99", "r8", "w8", "r8", "b7x3", "r8"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(roc.log.begin(), roc.log.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL(c.nCoalesced(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(Links) {
+  TrackerDcsCoalescer c;
+  Roc                 roc0, roc1;
+  roc0.add(c, 0);
+  roc1.add(c, 1);
+  roc1.reg[5] = 1;
+
+  BOOST_CHECK_EQUAL(c.read(1, 5).get(), 1);
+  BOOST_CHECK_EQUAL(c.read(0, 5).get(), 1005);
+  BOOST_CHECK_THROW(c.read(2, 5).get(), std::invalid_argument);
+  BOOST_CHECK_THROW(c.write(2, 5, 0).get(), std::invalid_argument);
+
+  // the requests of a link removed while queued are dropped
+  auto held = c.read(0, kGate);
+  roc0.entered.get_future().wait();
+  auto dropped = c.read(1, 6);
+  c.removeLink(1);
+  roc0.gate.set_value();
+  held.get();
+  BOOST_CHECK_THROW(dropped.get(), std::future_error);
+  BOOST_CHECK_THROW(c.read(1, 6).get(), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerDcsHistory : compression round trip, range queries, depth
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerDcsHistory_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Utilities/TrackerDcsHistory.hh"
+
+#include <cstring>
+#include <limits>
+#include <random>
+
+using mu2e::TrackerDcsHistory;
+
+namespace {
+  typedef std::vector<TrackerDcsHistory::Sample> Samples_t;
+//-----------------------------------------------------------------------------
+// bit for bit: NaN != NaN
+//-----------------------------------------------------------------------------
+  bool same(TrackerDcsHistory::Sample const& A, TrackerDcsHistory::Sample const& B) {
+    return (A.time == B.time) and (memcmp(&A.value, &B.value, sizeof(double)) == 0);
+  }
+//-----------------------------------------------------------------------------
+// a temperature read about once a second in ADC steps, with gaps, a NaN and
+// huge values now and then: every encoding of the time and value gets used
+//-----------------------------------------------------------------------------
+  Samples_t temperature(size_t N) {
+    std::mt19937_64 rng(1);
+    Samples_t       s;
+    int64_t         t    = 1700000000000000;
+    double          temp = 25;
+    for (size_t i = 0; i < N; i++) {
+      t += 1000000 + int64_t(rng() % 2000) - 1000;
+      if (i % 1000 == 0) t += int64_t(rng() % 100000000);
+      temp += (int(rng() % 3) - 1) * 0.0625;
+
+      double v = temp;
+      if (i % 5000 == 7) v = std::numeric_limits<double>::quiet_NaN();
+      if (i % 777 == 3) v = -1.e300;
+      if (i % 999 == 5) v = 0.;
+      s.push_back(TrackerDcsHistory::Sample{t, v});
+    }
+    return s;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerDcsHistory_test)
+
+BOOST_AUTO_TEST_CASE(RoundTrip) {
+  Samples_t         ref = temperature(20000);
+  TrackerDcsHistory h(ref.size(), 128);
+
+  for (auto const& s : ref) h.add("temp", s.time, s.value);
+
+  Samples_t out;
+  BOOST_REQUIRE_EQUAL(h.query("temp", INT64_MIN, INT64_MAX, out), ref.size());
+  for (size_t i = 0; i < ref.size(); i++) {
+    BOOST_REQUIRE_MESSAGE(same(out[i], ref[i]), "sample " << i);
+  }
+  // a slowly changing value takes much less than its 16 bytes
+  BOOST_CHECK_LT(h.bytes(), ref.size() * 16 / 2);
+}
+
+BOOST_AUTO_TEST_CASE(Range) {
+  Samples_t         ref = temperature(5000);
+  TrackerDcsHistory h(ref.size(), 64);
+
+  for (auto const& s : ref) h.add("temp", s.time, s.value);
+
+  Samples_t out;
+  BOOST_CHECK_EQUAL(h.query("temp", ref[1234].time, ref[4321].time, out), 4321u - 1234u + 1);
+  BOOST_CHECK(same(out.front(), ref[1234]));
+  BOOST_CHECK(same(out.back(), ref[4321]));
+  // appended, not replaced
+  BOOST_CHECK_EQUAL(h.query("temp", ref[10].time, ref[10].time, out), 1u);
+  BOOST_CHECK(same(out.back(), ref[10]));
+
+  out.clear();
+  BOOST_CHECK_EQUAL(h.query("temp", ref.back().time + 1, INT64_MAX, out), 0u);
+  BOOST_CHECK_EQUAL(h.query("nope", INT64_MIN, INT64_MAX, out), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Channels) {
+  TrackerDcsHistory h(100);
+
+  for (int i = 0; i < 10; i++) {
+    h.add("a", i, i);
+    h.add("b", i, -i);
+  }
+  h.add("a", 5, 1.);  // older than the last one
+
+  BOOST_CHECK_EQUAL(h.nDropped(), 1u);
+  BOOST_CHECK_EQUAL(h.nSamples("a"), 10u);
+  BOOST_CHECK_EQUAL(h.channels().size(), 2u);
+
+  Samples_t out;
+  h.query("b", 3, 3, out);
+  BOOST_REQUIRE_EQUAL(out.size(), 1u);
+  BOOST_CHECK_EQUAL(out[0].value, -3.);
+}
+
+//-----------------------------------------------------------------------------
+// whole blocks of the oldest samples go, at least Depth stay
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Depth) {
+  TrackerDcsHistory h(300, 128);
+
+  for (int i = 0; i < 1000; i++) h.add("x", i, i);
+
+  Samples_t out;
+  h.query("x", 0, 1000, out);
+  BOOST_CHECK_GE(out.size(), 300u);
+  BOOST_CHECK_LT(out.size(), 300u + 128);
+  BOOST_CHECK_EQUAL(out.size(), h.nSamples("x"));
+  BOOST_CHECK_EQUAL(out.back().time, 999);
+  BOOST_CHECK_EQUAL(out.front().value, double(out.front().time));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerDcsScheduler : priority order, the rate limit of a priority, the
+// minimum gap, exceptions through the future, jobs dropped by the destructor
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerDcsScheduler_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Utilities/TrackerDcsScheduler.hh"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace mu2e;
+
+namespace {
+  typedef TrackerDcsScheduler S;
+
+//-----------------------------------------------------------------------------
+// a job holding the scheduler thread until Go is set, so that what is queued
+// behind it is ordered by the scheduler, not by the submission
+//-----------------------------------------------------------------------------
+  std::future<uint32_t> block(S& Scheduler, std::atomic<bool>& Go, std::atomic<bool>& Started) {
+    auto f = Scheduler.submit(S::kHigh, [&] {
+      Started = true;
+      while (not Go) std::this_thread::sleep_for(std::chrono::microseconds(100));
+      return uint32_t(0);
+    });
+    while (not Started) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    return f;
+  }
+
+  double seconds(std::chrono::steady_clock::time_point Start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count();
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerDcsScheduler_test)
+
+//-----------------------------------------------------------------------------
+// queued low first and high last, run high first; FIFO within a priority
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Priority) {
+  S                 s;
+  std::atomic<bool> go(false), started(false);
+  auto              blocker = block(s, go, started);
+
+  std::vector<int>                   order;   // written by the scheduler thread only
+  std::vector<std::future<uint32_t>> f;
+  S::Priority_t priority[] = {S::kLow, S::kNormal, S::kHigh};
+  for (int p = 0; p < 3; p++) {
+    for (int i = 0; i < 2; i++) {
+      int id = 10*p + i;
+      f.push_back(s.submit(priority[p], [&order, id] { order.push_back(id); return uint32_t(id); }));
+    }
+  }
+  BOOST_CHECK_EQUAL(s.nPending(S::kLow), 2u);
+  BOOST_CHECK_EQUAL(s.nPending(S::kNormal), 2u);
+
+  go = true;
+  blocker.get();
+  for (size_t i = 0; i < f.size(); i++) BOOST_CHECK_EQUAL(f[i].get(), 10*(i/2) + i%2);
+
+  BOOST_CHECK((order == std::vector<int>{20, 21, 10, 11, 0, 1}));
+  BOOST_CHECK_EQUAL(s.nDone(S::kHigh), 3u);
+  BOOST_CHECK_EQUAL(s.nDone(S::kLow), 2u);
+  BOOST_CHECK_GT(s.meanWaitUs(S::kLow), 0.);
+}
+
+//-----------------------------------------------------------------------------
+// low limited to 100/s with a burst of 5: 15 jobs take ~0.1 s, the high ones
+// queued after them are not held back
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(RateLimit) {
+  S s;
+  s.setRateLimit(S::kLow, 100., 5.);
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::future<uint32_t>> low, high;
+  for (int i = 0; i < 15; i++) low .push_back(s.submit(S::kLow , [] { return 0u; }));
+  for (int i = 0; i < 15; i++) high.push_back(s.submit(S::kHigh, [] { return 1u; }));
+
+  for (auto& h : high) h.get();
+  BOOST_CHECK_LT(seconds(start), 0.05);
+  BOOST_CHECK_LT(s.nDone(S::kLow), 15u);
+
+  for (auto& l : low) l.get();
+  BOOST_CHECK_GT(seconds(start), 0.08);
+  BOOST_CHECK_EQUAL(s.nDone(S::kLow), 15u);
+}
+
+//-----------------------------------------------------------------------------
+// min_gap_us between any two transactions
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(MinGap) {
+  S s;
+  s.setMinGapUs(5000);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 5; i++) s.run(S::kHigh, [] { return 0u; });
+  BOOST_CHECK_GT(seconds(start), 0.019);
+}
+
+//-----------------------------------------------------------------------------
+// an exception goes to the caller; on the scheduler thread onThread() is true
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Exception) {
+  S s;
+  BOOST_CHECK_THROW(s.run(S::kNormal, []() -> uint32_t { throw std::runtime_error("DCS timeout"); }),
+                    std::runtime_error);
+  BOOST_CHECK(not s.onThread());
+  BOOST_CHECK_EQUAL(s.run(S::kNormal, [&s] { return uint32_t(s.onThread()); }), 1u);
+}
+
+//-----------------------------------------------------------------------------
+// jobs still queued when the scheduler goes away: broken promise
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Dropped) {
+  std::future<uint32_t> f;
+  {
+    S s;
+    s.setRateLimit(S::kLow, 1.e-3, 1.);
+    s.run(S::kLow, [] { return 0u; });
+    // no token left for the next one
+    f = s.submit(S::kLow, [] { return 0u; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    BOOST_CHECK_EQUAL(s.nPending(S::kLow), 1u);
+  }
+  BOOST_CHECK_THROW(f.get(), std::future_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
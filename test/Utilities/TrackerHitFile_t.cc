@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerHitFile : write hits, read them back column by column, chunk
+// selection, a file whose writer died, a file which can't be written
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerHitFile_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Utilities/TrackerHitFile.hh"
+
+#include <memory>
+
+#include <unistd.h>
+
+using namespace mu2e;
+
+namespace {
+  const int    kNHits    = 2500;
+  const int    kNSamples = 4;
+  const size_t kChunk    = 1000;
+//-----------------------------------------------------------------------------
+// hit I: ten per event window
+//-----------------------------------------------------------------------------
+  void write(std::string const& File, int NSamples) {
+    TrackerHitWriter w(File, NSamples, kChunk);
+    BOOST_REQUIRE(w.isOpen());
+
+    uint16_t wf[kNSamples];
+    for (int i = 0; i < kNHits; i++) {
+      for (int s = 0; s < kNSamples; s++) wf[s] = i % 1000 + s;
+      w.add(1000 + i / 10, i % 6, i % 96, i % 3, i * 0.5f, i * 0.5f + 1, 10.f + i, wf);
+    }
+    BOOST_CHECK_EQUAL(w.nHits(), size_t(kNHits));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerHitFile_test)
+
+BOOST_AUTO_TEST_CASE(ReadBack) {
+  std::string file = "TrackerHitFile_t.trkh";
+  write(file, kNSamples);
+
+  std::unique_ptr<TrackerHitReader> r(TrackerHitReader::open(file));
+  BOOST_REQUIRE(r);
+  BOOST_CHECK(r->complete());
+  BOOST_CHECK_EQUAL(r->nSamples(), kNSamples);
+  BOOST_CHECK_EQUAL(r->nHits(), size_t(kNHits));
+  BOOST_REQUIRE_EQUAL(r->nChunks(), 3u);
+
+  int i = 0;
+  for (size_t c = 0; c < r->nChunks(); c++) {
+    const uint64_t* ewt     = r->column<uint64_t>(c, TrackerHitFile::kEwt);
+    const uint8_t*  link    = r->column<uint8_t>(c, TrackerHitFile::kLink);
+    const uint8_t*  channel = r->column<uint8_t>(c, TrackerHitFile::kChannel);
+    const uint16_t* flags   = r->column<uint16_t>(c, TrackerHitFile::kFlags);
+    const float*    time0   = r->column<float>(c, TrackerHitFile::kTime0);
+    const float*    time1   = r->column<float>(c, TrackerHitFile::kTime1);
+    const float*    charge  = r->column<float>(c, TrackerHitFile::kCharge);
+    const uint16_t* wf      = r->column<uint16_t>(c, TrackerHitFile::kWaveform);
+
+    BOOST_CHECK_EQUAL(r->min(c, TrackerHitFile::kEwt), double(ewt[0]));
+    BOOST_CHECK_EQUAL(r->max(c, TrackerHitFile::kEwt), double(ewt[r->nHits(c) - 1]));
+
+    for (uint32_t k = 0; k < r->nHits(c); k++, i++) {
+      BOOST_REQUIRE_EQUAL(ewt[k], uint64_t(1000 + i / 10));
+      BOOST_REQUIRE_EQUAL(link[k], i % 6);
+      BOOST_REQUIRE_EQUAL(channel[k], i % 96);
+      BOOST_REQUIRE_EQUAL(flags[k], i % 3);
+      BOOST_REQUIRE_EQUAL(time0[k], i * 0.5f);
+      BOOST_REQUIRE_EQUAL(time1[k], i * 0.5f + 1);
+      BOOST_REQUIRE_EQUAL(charge[k], 10.f + i);
+      for (int s = 0; s < kNSamples; s++) BOOST_REQUIRE_EQUAL(wf[k * kNSamples + s], i % 1000 + s);
+    }
+  }
+  BOOST_CHECK_EQUAL(i, kNHits);
+
+  // hit 1150 is in the second chunk
+  std::vector<size_t> sel = r->select(TrackerHitFile::kEwt, 1115, 1116);
+  BOOST_REQUIRE_EQUAL(sel.size(), 1u);
+  BOOST_CHECK_EQUAL(sel[0], 1u);
+  BOOST_CHECK(r->select(TrackerHitFile::kCharge, 1.e6, 2.e6).empty());
+
+  unlink(file.data());
+}
+
+BOOST_AUTO_TEST_CASE(NoWaveforms) {
+  std::string file = "TrackerHitFile_t.nowf.trkh";
+  write(file, 0);
+
+  std::unique_ptr<TrackerHitReader> r(TrackerHitReader::open(file));
+  BOOST_REQUIRE(r);
+  BOOST_CHECK_EQUAL(r->nSamples(), 0);
+  BOOST_CHECK_EQUAL(r->nHits(), size_t(kNHits));
+  BOOST_CHECK_EQUAL(TrackerHitFile::columnSize(TrackerHitFile::kWaveform, 0), 0u);
+
+  unlink(file.data());
+}
+
+//-----------------------------------------------------------------------------
+// no index: the chunks written in full are found by walking the file
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Truncated) {
+  std::string file = "TrackerHitFile_t.cut.trkh";
+  write(file, kNSamples);
+
+  std::unique_ptr<TrackerHitReader> full(TrackerHitReader::open(file));
+  BOOST_REQUIRE(full);
+  BOOST_REQUIRE_EQUAL(full->nChunks(), 3u);
+  uint64_t cut = reinterpret_cast<const uint8_t*>(full->column<uint8_t>(2, TrackerHitFile::kEwt)) -
+                 reinterpret_cast<const uint8_t*>(full->column<uint8_t>(0, TrackerHitFile::kEwt));
+  full.reset();
+  // in the middle of the last chunk
+  BOOST_REQUIRE_EQUAL(truncate(file.data(), cut + 1000), 0);
+
+  std::unique_ptr<TrackerHitReader> r(TrackerHitReader::open(file));
+  BOOST_REQUIRE(r);
+  BOOST_CHECK(not r->complete());
+  BOOST_CHECK_EQUAL(r->nChunks(), 2u);
+  BOOST_CHECK_EQUAL(r->nHits(), 2 * kChunk);
+
+  unlink(file.data());
+}
+
+//-----------------------------------------------------------------------------
+// the header can't be written: no file, the hits are dropped
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(WriteError) {
+  TrackerHitWriter w("/dev/full", 4);
+  BOOST_CHECK(not w.isOpen());
+
+  uint16_t wf[4] = {1, 2, 3, 4};
+  w.add(1, 0, 0, 0, 0, 0, 0, wf);
+  BOOST_CHECK_EQUAL(w.nHits(), 0u);
+  BOOST_CHECK(not w.flush());
+  w.close();
+  BOOST_CHECK_EQUAL(w.nChunks(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(NotAHitFile) {
+  BOOST_CHECK(TrackerHitReader::open("no-such-file.trkh") == nullptr);
+
+  std::string file = "TrackerHitFile_t.bad";
+  FILE*       f    = fopen(file.data(), "w");
+  fprintf(f, "not a hit file, not a hit file, not a hit file, not a hit file\n");
+  fclose(f);
+  BOOST_CHECK(TrackerHitReader::open(file) == nullptr);
+  unlink(file.data());
+}
+
+BOOST_AUTO_TEST_CASE(Columns) {
+  for (int c = 0; c < TrackerHitFile::kNColumns; c++) {
+    BOOST_CHECK_EQUAL(TrackerHitFile::column(TrackerHitFile::columnName(c)), c);
+  }
+  BOOST_CHECK_EQUAL(TrackerHitFile::column("nope"), -1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
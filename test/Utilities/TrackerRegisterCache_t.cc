@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerRegisterCache : register classes, invalidation, a write during a
+// read-through
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerRegisterCache_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Utilities/TrackerRegisterCache.hh"
+
+using mu2e::TrackerRegisterCache;
+
+namespace {
+//-----------------------------------------------------------------------------
+// a register file counting the DCS reads
+//-----------------------------------------------------------------------------
+  struct Registers {
+    uint32_t value[64] = {};
+    int      nReads    = 0;
+
+    uint32_t read(TrackerRegisterCache& Cache, uint32_t Key) {
+      return Cache.read(Key, [&]() { nReads++; return value[Key]; });
+    }
+  };
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerRegisterCache_test)
+
+BOOST_AUTO_TEST_CASE(Classes) {
+  TrackerRegisterCache c;
+  Registers            r;
+
+  c.setClass(0, TrackerRegisterCache::kStatic);
+  c.setClass(8, TrackerRegisterCache::kConfig);
+  BOOST_CHECK_EQUAL(c.regClass(35), TrackerRegisterCache::kVolatile);
+
+  r.value[0] = 0x1234;
+  r.value[8] = 7;
+  for (int i = 0; i < 10; i++) {
+    BOOST_CHECK_EQUAL(r.read(c, 0), 0x1234u);
+    BOOST_CHECK_EQUAL(r.read(c, 8), 7u);
+    BOOST_CHECK_EQUAL(r.read(c, 35), 0u);
+  }
+  // static and config once, volatile every time
+  BOOST_CHECK_EQUAL(r.nReads, 12);
+  BOOST_CHECK_EQUAL(c.nHits(), 18u);
+  BOOST_CHECK_EQUAL(c.nMisses(), 2u);
+  BOOST_CHECK_EQUAL(c.nThrough(), 10u);
+  BOOST_CHECK_CLOSE(c.hitRate(), 0.6, 1.e-6);
+}
+
+BOOST_AUTO_TEST_CASE(Written) {
+  TrackerRegisterCache c;
+  Registers            r;
+
+  c.setClass(8, TrackerRegisterCache::kConfig);
+  r.value[8] = 1;
+  BOOST_CHECK_EQUAL(r.read(c, 8), 1u);
+
+  r.value[8] = 2;
+  BOOST_CHECK_EQUAL(r.read(c, 8), 1u);  // not our write, still the shadow copy
+  c.written(8);
+  BOOST_CHECK_EQUAL(r.read(c, 8), 2u);
+  BOOST_CHECK_EQUAL(r.nReads, 2);
+}
+
+BOOST_AUTO_TEST_CASE(Invalidate) {
+  TrackerRegisterCache c;
+  Registers            r;
+
+  c.setClass(std::vector<uint32_t>{2, 3, 4, 5}, TrackerRegisterCache::kStatic);
+  for (uint32_t k = 2; k <= 5; k++) {
+    r.value[k] = k;
+    r.read(c, k);
+  }
+  BOOST_CHECK_EQUAL(r.nReads, 4);
+
+  for (uint32_t k = 2; k <= 5; k++) r.value[k] = 10 * k;
+  c.invalidate(3, 4);
+  BOOST_CHECK_EQUAL(r.read(c, 2), 2u);
+  BOOST_CHECK_EQUAL(r.read(c, 3), 30u);
+  BOOST_CHECK_EQUAL(r.read(c, 4), 40u);
+  BOOST_CHECK_EQUAL(r.read(c, 5), 5u);
+  BOOST_CHECK_EQUAL(r.nReads, 6);
+  // the class stays
+  BOOST_CHECK_EQUAL(c.regClass(3), TrackerRegisterCache::kStatic);
+
+  c.invalidate();
+  for (uint32_t k = 2; k <= 5; k++) BOOST_CHECK_EQUAL(r.read(c, k), 10 * k);
+  BOOST_CHECK_EQUAL(r.nReads, 10);
+}
+
+//-----------------------------------------------------------------------------
+// a write in the middle of the read-through wins, the value read is not kept
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(WriteDuringRead) {
+  TrackerRegisterCache c;
+  int                  nReads = 0;
+
+  c.setClass(8, TrackerRegisterCache::kConfig);
+  uint32_t v = c.read(8, [&]() { nReads++; c.written(8); return 7u; });
+  BOOST_CHECK_EQUAL(v, 7u);
+  BOOST_CHECK_EQUAL(c.read(8, [&]() { nReads++; return 9u; }), 9u);
+  BOOST_CHECK_EQUAL(c.read(8, [&]() { nReads++; return 10u; }), 9u);
+  BOOST_CHECK_EQUAL(nReads, 2);
+
+  // same for an invalidation
+  c.invalidate();
+  v = c.read(8, [&]() { nReads++; c.invalidate(8, 8); return 11u; });
+  BOOST_CHECK_EQUAL(v, 11u);
+  BOOST_CHECK_EQUAL(c.read(8, [&]() { nReads++; return 12u; }), 12u);
+  BOOST_CHECK_EQUAL(nReads, 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
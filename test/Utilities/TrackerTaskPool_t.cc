@@ -0,0 +1,203 @@
+///////////////////////////////////////////////////////////////////////////////
+// TrackerTaskPool : wait() and completion, results in submission order, work
+// stealing between workers and by the waiting thread, exceptions, no threads
+///////////////////////////////////////////////////////////////////////////////
+#define BOOST_TEST_MODULE TrackerTaskPool_t
+#include <boost/test/unit_test.hpp>
+
+#include "otsdaq-mu2e-tracker/Utilities/TrackerTaskPool.hh"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace mu2e;
+
+namespace {
+//-----------------------------------------------------------------------------
+// spins until Done() or 5 s, without running pool tasks on the calling thread
+//-----------------------------------------------------------------------------
+  template <class F>
+  bool waitFor(F Done) {
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (not Done()) {
+      if (std::chrono::steady_clock::now() > end) return false;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(TrackerTaskPool_test)
+
+//-----------------------------------------------------------------------------
+// every worker runs Init once; wait() returns when all tasks are done, the
+// results go where the caller put them, whatever order they ran in
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Completion) {
+  // Boost.Test checks are not thread-safe: count on the workers, check here
+  std::atomic<int> ninit(0), nbad(0);
+  TrackerTaskPool  pool(4, [&](int Worker) {
+    if (TrackerTaskPool::workerIndex() != Worker) nbad++;
+    ninit++;
+  });
+  BOOST_CHECK_EQUAL(pool.nThreads(), 4);
+  BOOST_CHECK_EQUAL(TrackerTaskPool::workerIndex(), -1);
+
+  std::vector<int> result(1000, -1);
+  for (int i = 0; i < 1000; i++) {
+    pool.submit([&result, i] {
+      if (i % 97 == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+      result[i] = i*i;
+    });
+  }
+  pool.wait();
+
+  BOOST_CHECK_EQUAL(pool.nPending(), 0u);
+  for (int i = 0; i < 1000; i++) BOOST_REQUIRE_EQUAL(result[i], i*i);
+  BOOST_CHECK(waitFor([&] { return ninit == 4; }));
+  BOOST_CHECK_EQUAL(nbad, 0);
+}
+
+//-----------------------------------------------------------------------------
+// a task submitted by a task is counted before its parent finishes: one wait()
+// covers both
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Nested) {
+  TrackerTaskPool  pool(2);
+  std::atomic<int> n(0);
+
+  for (int i = 0; i < 50; i++) {
+    pool.submit([&] {
+      pool.submit([&] {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        n++;
+      });
+      n++;
+    });
+  }
+  pool.wait();
+  BOOST_CHECK_EQUAL(n, 100);
+}
+
+//-----------------------------------------------------------------------------
+// worker 1 blocked: worker 0 runs its own queue newest first, then steals the
+// queue of worker 1 oldest first
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Stealing) {
+  TrackerTaskPool   pool(2);
+  std::atomic<bool> go[2] = {{false}, {false}};
+  std::atomic<int>  started(0);
+
+  for (int i = 0; i < 2; i++) {
+    pool.submit([&] {
+      started++;
+      int w = TrackerTaskPool::workerIndex();
+      while (not go[w]) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    });
+  }
+  BOOST_REQUIRE(waitFor([&] { return started == 2; }));
+  size_t stolen = pool.nStolen();
+
+  // round-robin: the even ones in the queue of worker 0, the odd ones in the other
+  std::mutex       mutex;
+  std::vector<int> order, worker;
+  for (int i = 0; i < 10; i++) {
+    pool.submit([&, i] {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(i);
+      worker.push_back(TrackerTaskPool::workerIndex());
+    });
+  }
+
+  go[0] = true;
+  BOOST_REQUIRE(waitFor([&] {
+    std::lock_guard<std::mutex> lock(mutex);
+    return order.size() == 10;
+  }));
+  BOOST_CHECK((order  == std::vector<int>{8, 6, 4, 2, 0, 1, 3, 5, 7, 9}));
+  BOOST_CHECK((worker == std::vector<int>(10, 0)));
+  BOOST_CHECK_EQUAL(pool.nStolen() - stolen, 5u);
+
+  go[1] = true;
+  pool.wait();
+}
+
+//-----------------------------------------------------------------------------
+// the waiting thread steals instead of sleeping
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(RunOne) {
+  TrackerTaskPool   pool(1);
+  std::atomic<bool> go(false);
+  std::atomic<bool> started(false);
+
+  pool.submit([&] {
+    started = true;
+    while (not go) std::this_thread::sleep_for(std::chrono::microseconds(100));
+  });
+  BOOST_REQUIRE(waitFor([&] { return bool(started); }));
+  size_t stolen = pool.nStolen();
+
+  std::vector<int> worker;
+  for (int i = 0; i < 3; i++) pool.submit([&] { worker.push_back(TrackerTaskPool::workerIndex()); });
+  BOOST_CHECK_EQUAL(pool.nPending(), 4u);
+
+  while (pool.runOne()) {}
+  BOOST_CHECK((worker == std::vector<int>(3, -1)));
+  BOOST_CHECK_EQUAL(pool.nStolen() - stolen, 3u);
+  BOOST_CHECK_EQUAL(pool.nPending(), 1u);
+
+  go = true;
+  pool.wait();
+  BOOST_CHECK_EQUAL(pool.nPending(), 0u);
+}
+
+//-----------------------------------------------------------------------------
+// the first exception comes out of the next wait(), the pool goes on
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Exception) {
+  TrackerTaskPool  pool(3);
+  std::atomic<int> n(0);
+
+  for (int i = 0; i < 20; i++) {
+    pool.submit([&, i] {
+      if (i == 7) throw std::runtime_error("task 7");
+      n++;
+    });
+  }
+  BOOST_CHECK_THROW(pool.wait(), std::runtime_error);
+  BOOST_CHECK_EQUAL(n, 19);
+
+  pool.submit([&] { n++; });
+  BOOST_CHECK_NO_THROW(pool.wait());
+  BOOST_CHECK_EQUAL(n, 20);
+}
+
+//-----------------------------------------------------------------------------
+// no threads: the task runs inside submit(); the destructor runs what is queued
+//-----------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(Inline) {
+  int n = 0;
+  {
+    TrackerTaskPool pool(0);
+    pool.submit([&] {
+      BOOST_CHECK_EQUAL(TrackerTaskPool::workerIndex(), -1);
+      n++;
+    });
+    BOOST_CHECK_EQUAL(n, 1);
+    BOOST_CHECK_EQUAL(pool.nPending(), 0u);
+    pool.wait();
+  }
+
+  std::atomic<int> m(0);
+  {
+    TrackerTaskPool pool(1);
+    for (int i = 0; i < 5; i++) pool.submit([&] { m++; });
+  }
+  BOOST_CHECK_EQUAL(m, 5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()